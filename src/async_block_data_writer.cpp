@@ -0,0 +1,162 @@
+// Copyright (c) 2024 Bitcoin Association
+// Distributed under the Open BSV software license, see the accompanying file LICENSE.
+
+#include "async_block_data_writer.h"
+
+#include "block_file_access.h"
+#include "clientversion.h"
+#include "serialize.h"
+#include "txdb.h"
+#include "undo.h"
+#include "util.h"
+
+std::unique_ptr<CAsyncBlockDataWriter> pBlockDataWriter{};
+
+CAsyncBlockDataWriter::CAsyncBlockDataWriter(
+    CBlockTreeDB& blockTree,
+    const CMessageHeader::MessageMagic& diskMagic,
+    size_t maxQueued)
+    : mBlockTree{ blockTree }
+    , mDiskMagic{ diskMagic }
+    , mMaxQueued{ std::max<size_t>(maxQueued, 1) }
+    , mWorker{ [this]{ Work(); } }
+{
+}
+
+CAsyncBlockDataWriter::~CAsyncBlockDataWriter()
+{
+    {
+        std::lock_guard lock{ mMutex };
+        mStop = true;
+    }
+    mQueueChanged.notify_all();
+    mWorker.join();
+}
+
+CDiskBlockPos CAsyncBlockDataWriter::WriteUndo(
+    std::shared_ptr<const CBlockUndo> undo,
+    const CDiskBlockPos& allocatedPos,
+    const uint256& prevBlockHash)
+{
+    const CDiskBlockPos pos = BlockFileAccess::GetUndoDataPos(
+        allocatedPos, ::GetSerializeSize(*undo, SER_DISK, CLIENT_VERSION));
+    Push(UndoTask{ std::move(undo), allocatedPos, pos, prevBlockHash });
+    return pos;
+}
+
+void CAsyncBlockDataWriter::WriteTxIndex(std::vector<std::pair<uint256, CDiskTxPos>>&& positions)
+{
+    Push(TxIndexTask{ std::move(positions) });
+}
+
+std::shared_ptr<const CBlockUndo> CAsyncBlockDataWriter::GetPendingUndo(const CDiskBlockPos& pos) const
+{
+    std::lock_guard lock{ mMutex };
+    for (const auto& task : mQueue)
+    {
+        if (const auto* undoTask = std::get_if<UndoTask>(&task); undoTask && undoTask->pos == pos)
+        {
+            return undoTask->undo;
+        }
+    }
+    return nullptr;
+}
+
+bool CAsyncBlockDataWriter::HasPendingTxIndex() const
+{
+    std::lock_guard lock{ mMutex };
+    return mQueuedTxIndexTasks > 0;
+}
+
+bool CAsyncBlockDataWriter::Sync()
+{
+    std::set<int> undoFiles{};
+    {
+        std::unique_lock lock{ mMutex };
+        mQueueChanged.wait(lock, [this]{ return mQueue.empty(); });
+        undoFiles.swap(mUndoFilesToFlush);
+    }
+
+    bool ok{ true };
+    for (int fileNo : undoFiles)
+    {
+        ok = BlockFileAccess::FlushUndoFile(fileNo) && ok;
+    }
+
+    std::lock_guard lock{ mMutex };
+    // Failures are not reset as the data that was not written is lost
+    mFailed = mFailed || !ok;
+    return !mFailed;
+}
+
+void CAsyncBlockDataWriter::Push(Task&& task)
+{
+    {
+        std::unique_lock lock{ mMutex };
+        mQueueChanged.wait(lock, [this]{ return mQueue.size() < mMaxQueued; });
+        if (std::holds_alternative<TxIndexTask>(task))
+        {
+            ++mQueuedTxIndexTasks;
+        }
+        mQueue.push_back(std::move(task));
+    }
+    mQueueChanged.notify_all();
+}
+
+bool CAsyncBlockDataWriter::Write(const Task& task)
+{
+    if (const auto* undoTask = std::get_if<UndoTask>(&task))
+    {
+        CDiskBlockPos pos = undoTask->allocatedPos;
+        if (!BlockFileAccess::UndoWriteToDisk(*undoTask->undo, pos, undoTask->prevBlockHash, mDiskMagic))
+        {
+            return error("%s: Failed to write undo data", __func__);
+        }
+        if (!(pos == undoTask->pos))
+        {
+            return error("%s: Undo data written at %s instead of %s", __func__,
+                pos.ToString(), undoTask->pos.ToString());
+        }
+        return true;
+    }
+
+    if (!mBlockTree.WriteTxIndex(std::get<TxIndexTask>(task)))
+    {
+        return error("%s: Failed to write transaction index", __func__);
+    }
+    return true;
+}
+
+void CAsyncBlockDataWriter::Work()
+{
+    RenameThread("blockdatawriter");
+
+    std::unique_lock lock{ mMutex };
+    for (;;)
+    {
+        mQueueChanged.wait(lock, [this]{ return mStop || !mQueue.empty(); });
+        if (mQueue.empty())
+        {
+            return;
+        }
+
+        // References to deque elements remain valid while other tasks are
+        // pushed to the back
+        const Task& task = mQueue.front();
+        lock.unlock();
+        const bool ok = Write(task);
+        lock.lock();
+
+        if (const auto* undoTask = std::get_if<UndoTask>(&task))
+        {
+            mUndoFilesToFlush.insert(undoTask->pos.File());
+        }
+        else
+        {
+            --mQueuedTxIndexTasks;
+        }
+        mFailed = mFailed || !ok;
+        mQueue.pop_front();
+        mQueueChanged.notify_all();
+    }
+}
@@ -0,0 +1,104 @@
+// Copyright (c) 2024 Bitcoin Association
+// Distributed under the Open BSV software license, see the accompanying file LICENSE.
+
+#pragma once
+
+#include "disk_block_pos.h"
+#include "disk_tx_pos.h"
+#include "protocol.h"
+#include "uint256.h"
+
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <thread>
+#include <utility>
+#include <variant>
+#include <vector>
+
+class CBlockTreeDB;
+class CBlockUndo;
+
+/** Number of queued writes after which queueing blocks until one is written */
+static constexpr size_t DEFAULT_BLOCK_DATA_WRITER_MAX_QUEUED{ 32 };
+
+/**
+ * Writes undo data and transaction index entries of connected blocks in a
+ * background thread so that connecting a block does not wait for them.
+ *
+ * Writes are done in the order in which they were queued. Block index entries
+ * and chain state that refer to queued data must not be written to disk before
+ * Sync() returned, FlushStateToDisk() calls it before writing them so after a
+ * crash blocks whose data was lost are connected again.
+ */
+class CAsyncBlockDataWriter
+{
+public:
+    CAsyncBlockDataWriter(
+        CBlockTreeDB& blockTree,
+        const CMessageHeader::MessageMagic& diskMagic,
+        size_t maxQueued = DEFAULT_BLOCK_DATA_WRITER_MAX_QUEUED);
+    // Writes all queued data before returning.
+    ~CAsyncBlockDataWriter();
+
+    CAsyncBlockDataWriter(const CAsyncBlockDataWriter&) = delete;
+    CAsyncBlockDataWriter& operator=(const CAsyncBlockDataWriter&) = delete;
+
+    // Queue writing of undo data of a block to undo file space allocated at
+    // allocatedPos. Returns the position at which the undo data will be
+    // stored, as set by BlockFileAccess::UndoWriteToDisk().
+    CDiskBlockPos WriteUndo(
+        std::shared_ptr<const CBlockUndo> undo,
+        const CDiskBlockPos& allocatedPos,
+        const uint256& prevBlockHash);
+
+    // Queue writing of transaction index entries of a block.
+    void WriteTxIndex(std::vector<std::pair<uint256, CDiskTxPos>>&& positions);
+
+    // Undo data that is queued for writing at pos or nullptr.
+    std::shared_ptr<const CBlockUndo> GetPendingUndo(const CDiskBlockPos& pos) const;
+
+    // Whether transaction index entries are queued for writing.
+    bool HasPendingTxIndex() const;
+
+    // Wait until all queued data is written and undo files that were written
+    // to are flushed to disk. Returns false if writing of any data failed.
+    bool Sync();
+
+private:
+    struct UndoTask
+    {
+        std::shared_ptr<const CBlockUndo> undo;
+        CDiskBlockPos allocatedPos;
+        CDiskBlockPos pos;
+        uint256 prevBlockHash;
+    };
+    using TxIndexTask = std::vector<std::pair<uint256, CDiskTxPos>>;
+    using Task = std::variant<UndoTask, TxIndexTask>;
+
+    void Push(Task&& task);
+    bool Write(const Task& task);
+    void Work();
+
+    CBlockTreeDB& mBlockTree;
+    const CMessageHeader::MessageMagic mDiskMagic;
+    const size_t mMaxQueued;
+
+    mutable std::mutex mMutex{};
+    std::condition_variable mQueueChanged{};
+    // Queued tasks, the front one stays queued until it is written so that
+    // pending undo data can still be found
+    std::deque<Task> mQueue{};
+    size_t mQueuedTxIndexTasks{ 0 };
+    // Numbers of undo files written to since the last Sync()
+    std::set<int> mUndoFilesToFlush{};
+    bool mFailed{ false };
+    bool mStop{ false };
+
+    std::thread mWorker;
+};
+
+/** Set when undo data and transaction index entries are written asynchronously */
+extern std::unique_ptr<CAsyncBlockDataWriter> pBlockDataWriter;
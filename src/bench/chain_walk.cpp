@@ -0,0 +1,115 @@
+// Copyright (c) 2024 Bitcoin Association
+// Distributed under the Open BSV software license, see the accompanying file LICENSE.
+
+#include "bench.h"
+#include "block_index_store.h"
+#include "chain.h"
+#include "random.h"
+
+// Chain walking operations over a block index of a realistic size. Layout of
+// CBlockIndex objects in memory is what matters here so the block index is
+// built once in insertion order as it would be during header sync.
+namespace
+{
+    constexpr int32_t MAIN_CHAIN_LENGTH { 200'000 };
+    constexpr int32_t FORK_HEIGHT { 150'000 };
+    constexpr int32_t FORK_LENGTH { 1'000 };
+
+    struct ChainWalkData
+    {
+        BlockIndexStore store {};
+        CChain chain {};
+        const CBlockIndex* forkTip { nullptr };
+
+        ChainWalkData()
+        {
+            CBlockHeader header {};
+            header.nBits = 0x207fffff;
+            CBlockIndex* tip = store.Insert( header );
+            const CBlockIndex* forkBase = nullptr;
+            for (int32_t height = 1; height < MAIN_CHAIN_LENGTH; ++height)
+            {
+                header.hashPrevBlock = tip->GetBlockHash();
+                header.nTime = static_cast<uint32_t>(height);
+                tip = store.Insert( header );
+                if (height == FORK_HEIGHT)
+                {
+                    forkBase = tip;
+                }
+            }
+            chain.SetTip( tip );
+
+            forkTip = forkBase;
+            for (int32_t i = 0; i < FORK_LENGTH; ++i)
+            {
+                header.hashPrevBlock = forkTip->GetBlockHash();
+                header.nNonce = 1;
+                header.nTime = static_cast<uint32_t>(i);
+                forkTip = store.Insert( header );
+            }
+        }
+    };
+
+    ChainWalkData& GetChainWalkData()
+    {
+        static ChainWalkData data {};
+        return data;
+    }
+}
+
+static void BlockIndexGetAncestor(benchmark::State& state)
+{
+    auto& data = GetChainWalkData();
+    const CBlockIndex* tip = data.chain.Tip();
+    FastRandomContext rng { true };
+    int64_t sum = 0;
+    while (state.KeepRunning())
+    {
+        sum += tip->GetAncestor(static_cast<int32_t>(rng.randrange(MAIN_CHAIN_LENGTH)))->GetHeight();
+    }
+    (void) sum;
+}
+
+static void ChainFindFork(benchmark::State& state)
+{
+    auto& data = GetChainWalkData();
+    while (state.KeepRunning())
+    {
+        assert(data.chain.FindFork(data.forkTip)->GetHeight() == FORK_HEIGHT);
+    }
+}
+
+static void ChainWalkToGenesis(benchmark::State& state)
+{
+    auto& data = GetChainWalkData();
+    while (state.KeepRunning())
+    {
+        int64_t work = 0;
+        for (const CBlockIndex* index = data.chain.Tip(); index; index = index->GetPrev())
+        {
+            work += index->GetBits();
+        }
+        (void) work;
+    }
+}
+
+static void BlockIndexScan(benchmark::State& state)
+{
+    auto& data = GetChainWalkData();
+    while (state.KeepRunning())
+    {
+        // Similar to scans done for pruning and fork tip detection
+        size_t withData = 0;
+        data.store.ForEach(
+            [&](const CBlockIndex& index)
+            {
+                withData += index.getStatus().hasData();
+            });
+        (void) withData;
+    }
+}
+
+BENCHMARK(BlockIndexGetAncestor);
+BENCHMARK(ChainFindFork);
+BENCHMARK(ChainWalkToGenesis);
+BENCHMARK(BlockIndexScan);
@@ -0,0 +1,90 @@
+// Copyright (c) 2024 Bitcoin Association
+// Distributed under the Open BSV software license, see the accompanying file LICENSE.
+
+#include "bench.h"
+
+#include "consensus/validation.h"
+#include "random.h"
+#include "txmempool.h"
+#include "txn_double_spend_detector.h"
+
+#include <thread>
+#include <vector>
+
+namespace
+{
+    constexpr size_t NUMBER_OF_VALIDATORS = 32;
+    constexpr size_t TXNS_PER_VALIDATOR = 250;
+    constexpr size_t INPUTS_PER_TXN = 3;
+
+    // Every validator gets its own set of txns. Every tenth txn also spends
+    // an input that is shared by the txns at the same position of all
+    // validators so that some double spends are detected too.
+    std::vector<std::vector<CTransactionRef>> MakeValidatorTxns()
+    {
+        FastRandomContext rand {true};
+        std::vector<COutPoint> shared {};
+        for(size_t i = 0; i < TXNS_PER_VALIDATOR; ++i)
+        {
+            shared.emplace_back(rand.rand256(), 0);
+        }
+
+        std::vector<std::vector<CTransactionRef>> txns(NUMBER_OF_VALIDATORS);
+        for(auto& validatorTxns : txns)
+        {
+            for(size_t i = 0; i < TXNS_PER_VALIDATOR; ++i)
+            {
+                CMutableTransaction tx;
+                tx.vin.resize(INPUTS_PER_TXN);
+                for(auto& input : tx.vin)
+                {
+                    input.prevout = COutPoint(rand.rand256(), 0);
+                }
+                if(i % 10 == 0)
+                {
+                    tx.vin[0].prevout = shared[i];
+                }
+                tx.vout.resize(1);
+                tx.vout[0].nValue = Amount(1);
+                validatorTxns.push_back(MakeTransactionRef(tx));
+            }
+        }
+        return txns;
+    }
+
+    // Many validator threads claiming and releasing the inputs of their txns
+    // at the same time, as they do while a batch of txns is being validated.
+    void DoubleSpendDetectorConcurrentValidators(benchmark::State& state)
+    {
+        const CTxMemPool pool {};
+        CTxnDoubleSpendDetector detector {};
+        const auto txns = MakeValidatorTxns();
+
+        while(state.KeepRunning())
+        {
+            std::vector<std::thread> validators {};
+            for(const auto& validatorTxns : txns)
+            {
+                validators.emplace_back(
+                    [&detector, &pool, &validatorTxns]
+                    {
+                        for(const auto& ptx : validatorTxns)
+                        {
+                            CValidationState validationState;
+                            detector.insertTxnInputs(ptx, pool, validationState, true);
+                        }
+                        for(const auto& ptx : validatorTxns)
+                        {
+                            detector.removeTxnInputs(*ptx);
+                        }
+                    });
+            }
+            for(auto& validator : validators)
+            {
+                validator.join();
+            }
+        }
+    }
+}
+
+BENCHMARK(DoubleSpendDetectorConcurrentValidators);
@@ -3,6 +3,7 @@
 // file COPYING or http://www.opensource.org/licenses/mit-license.php.
 
 #include "bench.h"
+#include "crypto/common.h"
 #include "mining/journal_change_set.h"
 #include "policy/policy.h"
 #include "txmempool.h"
@@ -123,3 +124,42 @@ static void MempoolEviction(benchmark::State &state) {
 }
 
 BENCHMARK(MempoolEviction)
+
+// Evicts from a mempool filled with numOfTxs independent transactions of
+// various fee rates. Every run trims a hundredth of the mempool so the cost
+// of an eviction batch, and not of filling the mempool, is measured.
+static void MempoolEvictionLarge(benchmark::State &state, size_t numOfTxs) {
+    CTxMemPool pool;
+
+    for (size_t i = 0; i < numOfTxs; ++i) {
+        uint256 prevTxId;
+        WriteLE64(prevTxId.begin(), i);
+
+        CMutableTransaction tx;
+        tx.vin.resize(1);
+        tx.vin[0].prevout = COutPoint(TxId(prevTxId), 0);
+        tx.vin[0].scriptSig = CScript() << OP_1;
+        tx.vout.resize(1);
+        tx.vout[0].scriptPubKey = CScript() << OP_1 << OP_EQUAL;
+        tx.vout[0].nValue = 10 * COIN;
+
+        // spread fee rates over a wide range of eviction buckets
+        AddTx(CTransaction(tx), Amount(int64_t(50 + (i * 7919) % 5000)), pool);
+    }
+
+    while (state.KeepRunning()) {
+        pool.TrimToSize(pool.DynamicMemoryUsage() / 100 * 99, nullChangeSet);
+    }
+}
+
+static void MempoolEviction100K(benchmark::State &state) {
+    MempoolEvictionLarge(state, 100'000);
+}
+
+// Needs around 10 GB of memory.
+static void MempoolEviction10M(benchmark::State &state) {
+    MempoolEvictionLarge(state, 10'000'000);
+}
+
+BENCHMARK(MempoolEviction100K)
+BENCHMARK(MempoolEviction10M)
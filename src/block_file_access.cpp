@@ -4,6 +4,7 @@
 #include "block_file_access.h"
 
 #include "block_file_info.h"
+#include "block_tx_offsets.h"
 #include "chain.h"
 #include "clientversion.h"
 #include "config.h"
@@ -105,6 +106,13 @@ namespace
      * Write index header. If size larger thant 32 bit max than write 32 bit max and 64 bit size.
      * 32 bit max (0xFFFFFFFF) indicates that there is 64 bit size value following.
      */
+    uint64_t GetIndexHeaderSize(uint64_t nSize)
+    {
+        return nSize >= std::numeric_limits<unsigned int>::max()
+            ? CMessageFields::MESSAGE_START_SIZE + sizeof(uint32_t) + sizeof(uint64_t)
+            : CMessageFields::MESSAGE_START_SIZE + sizeof(uint32_t);
+    }
+
     void WriteIndexHeader(CAutoFile& fileout,
                           const CMessageHeader::MessageMagic& messageStart,
                           uint64_t nSize)
@@ -166,6 +174,7 @@ bool BlockFileAccess::RemoveFile( int fileNo )
     // only delete rev file if blk file deletion succeeded otherwise keep the
     // data for now as it's most likely still being used
     fs::remove(GetBlockPosFilename(pos, "rev"));
+    RemoveBlockTxOffsetsFiles(fileNo);
 
     return true;
 }
@@ -243,6 +252,24 @@ bool BlockFileAccess::UndoWriteToDisk(
     return true;
 }
 
+CDiskBlockPos BlockFileAccess::GetUndoDataPos(const CDiskBlockPos& pos, uint64_t undoSize)
+{
+    return { pos.File(), static_cast<unsigned int>(pos.Pos() + GetIndexHeaderSize(undoSize)) };
+}
+
+bool BlockFileAccess::FlushUndoFile(int fileNo)
+{
+    std::shared_lock lock{ serializationMutex };
+
+    UniqueCFile file = ::OpenUndoFile(CDiskBlockPos{ fileNo, 0 }, OpenDiskType::WriteIfExists, true);
+    if (!file) {
+        return error("%s: OpenUndoFile failed", __func__);
+    }
+    FileCommit(file.get());
+
+    return true;
+}
+
 bool BlockFileAccess::ReadBlockFromDisk(
     CBlock& block,
     const CDiskBlockPos& pos,
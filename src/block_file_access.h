@@ -74,6 +74,18 @@ namespace BlockFileAccess
         const uint256& hashBlock,
         const CMessageHeader::MessageMagic& messageStart);
 
+    /**
+     * Position at which UndoWriteToDisk() stores undo data of the given
+     * serialized size when it is called with pos.
+     */
+    CDiskBlockPos GetUndoDataPos(const CDiskBlockPos& pos, uint64_t undoSize);
+
+    /**
+     * Flush data of an undo file that is remaining in filesystem memory cache
+     * to disk.
+     */
+    bool FlushUndoFile(int fileNo);
+
     /**
      * Function makes sure that all block and undo file data that is remaining
      * in filesystem memory cache is flushed to disk.
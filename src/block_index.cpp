@@ -4,6 +4,7 @@
 #include "block_index.h"
 
 #include "block_file_access.h"
+#include "async_block_data_writer.h"
 #include "async_file_reader.h"
 #include "blockfileinfostore.h"
 #include "blockstreams.h"
@@ -175,6 +176,24 @@ std::optional<CBlockUndo> CBlockIndex::GetBlockUndo() const
         return std::nullopt;
     }
 
+    if (pBlockDataWriter)
+    {
+        if (auto pendingUndo = pBlockDataWriter->GetPendingUndo(pos))
+        {
+            // Coins are move only so the pending undo data is copied
+            CBlockUndo& undo = blockUndo.value();
+            undo.vtxundo.resize(pendingUndo->vtxundo.size());
+            for (size_t i = 0; i < undo.vtxundo.size(); ++i)
+            {
+                for (const auto& coin : pendingUndo->vtxundo[i].vprevout)
+                {
+                    undo.vtxundo[i].vprevout.push_back(coin.MakeOwning());
+                }
+            }
+            return blockUndo;
+        }
+    }
+
     if (!BlockFileAccess::UndoReadFromDisk(blockUndo.value(), pos, pprev->GetBlockHash()))
     {
         error("DisconnectBlock(): failure reading undo data");
@@ -185,8 +204,9 @@ std::optional<CBlockUndo> CBlockIndex::GetBlockUndo() const
 }
 
 
-bool CBlockIndex::writeUndoToDisk(CValidationState &state, const CBlockUndo &blockundo,
-                            bool fCheckForPruning, const Config &config, DirtyBlockIndexStore& notifyDirty)
+bool CBlockIndex::writeUndoToDisk(CValidationState &state, CBlockUndo &&blockundo,
+                            bool fCheckForPruning, const Config &config, DirtyBlockIndexStore& notifyDirty,
+                            CAsyncBlockDataWriter* writer)
 {
     std::lock_guard lock { GetMutex() };
     if (GetUndoPosNL().IsNull() ||
@@ -200,7 +220,10 @@ bool CBlockIndex::writeUndoToDisk(CValidationState &state, const CBlockUndo &blo
                 return error("CBlockIndex: FindUndoPos failed");
             }
 
-            if (!BlockFileAccess::UndoWriteToDisk(blockundo, _pos, pprev->GetBlockHash(),
+            if (writer) {
+                _pos = writer->WriteUndo(std::make_shared<const CBlockUndo>(std::move(blockundo)),
+                                         _pos, pprev->GetBlockHash());
+            } else if (!BlockFileAccess::UndoWriteToDisk(blockundo, _pos, pprev->GetBlockHash(),
                                  config.GetChainParams().DiskMagic())) {
                 return AbortNode(state, "Failed to write undo data");
             }
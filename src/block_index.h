@@ -19,6 +19,7 @@
 #include <vector>
 #include <memory>
 
+class CAsyncBlockDataWriter;
 struct CBlockIndexWorkComparator;
 
 template<typename Reader>
@@ -862,8 +863,10 @@ public:
 
     std::optional<CBlockUndo> GetBlockUndo() const;
 
-    bool writeUndoToDisk(CValidationState &state, const CBlockUndo &blockundo,
-                            bool fCheckForPruning, const Config &config, DirtyBlockIndexStore& notifyDirty);
+    // Undo data is written by writer in the background if it is set.
+    bool writeUndoToDisk(CValidationState &state, CBlockUndo &&blockundo,
+                            bool fCheckForPruning, const Config &config, DirtyBlockIndexStore& notifyDirty,
+                            CAsyncBlockDataWriter* writer = nullptr);
 
     bool verifyUndoValidity() const;
 
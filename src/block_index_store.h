@@ -10,6 +10,7 @@
 #include "primitives/block.h"
 #include "block_hasher.h"
 #include "chain.h"
+#include "chunked_arena.h"
 #include "dirty_block_index_store.h"
 #include "uint256.h"
 #include "utiltime.h"
@@ -17,8 +18,10 @@
 /**
  * BlockIndexStore tracks all currently existing CBlockIndex objects (except TemporaryBlockIndex objects).
  * In the outside world it can be accessed via mapBlockIndex global variable.
- * CBlockIndex objects are stored in mStore member variable.
- * mStore is locked internally with mMutex member variable on every read/write operation.
+ * CBlockIndex objects are stored contiguously in mArena in the order in which they were created
+ * (which during normal operation roughly follows block height) and mStore maps block hashes to them,
+ * so walking the chain doesn't chase map nodes scattered across the heap.
+ * mArena and mStore are locked internally with mMutex member variable on every read/write operation.
  * The header that is valid and has the highest chain work is stored in mBestHeader member.
  * Details about choosing the best header are in CBlockIndexWorkComparator implementation.
  * BlockIndexStore also keeps tracks of objects that were changed during the lifetime and not yet persisted to the database: mDirtyBlockIndex.
@@ -43,26 +46,38 @@ public:
      * entry.
      */
     CBlockIndex* Insert( const CBlockHeader& block )
+    {
+        return Insert( block, block.GetHash() );
+    }
+
+    /**
+     * Same as Insert(block) but with a block hash that was already calculated
+     * by the caller so that hashing is not done while holding the lock.
+     */
+    CBlockIndex* Insert( const CBlockHeader& block, const uint256& blockHash )
     {
         std::lock_guard lock{ mMutex };
 
-        auto prev = mStore.find(block.hashPrevBlock);
+        auto prev = getNL(block.hashPrevBlock);
 
         // Only genesis blocks may have missing previous block!
         assert(
-            (block.hashPrevBlock.IsNull() && prev == mStore.end() ) ||
-            prev != mStore.end());
-
-        auto mi =
-            mStore.try_emplace(
-                block.GetHash(),
-                block,
-                (prev != mStore.end() ? &prev->second : nullptr),
-                mDirtyBlockIndex,
-                CBlockIndex::PrivateTag{})
-            .first;
-
-        auto& indexNew = mi->second;
+            (block.hashPrevBlock.IsNull() && prev == nullptr ) ||
+            prev != nullptr);
+
+        auto mi = mStore.find( blockHash );
+        if (mi == mStore.end())
+        {
+            auto& created =
+                mArena.Emplace(
+                    block,
+                    prev,
+                    mDirtyBlockIndex,
+                    CBlockIndex::PrivateTag{});
+            mi = mStore.emplace( blockHash, &created ).first;
+        }
+
+        auto& indexNew = *mi->second;
         indexNew.CBlockIndex_SetBlockHash( &mi->first, CBlockIndex::PrivateTag{} );
 
         if (mBestHeader == nullptr ||
@@ -93,10 +108,7 @@ public:
     {
         std::shared_lock lock{ mMutex };
 
-        for (auto& item : mStore)
-        {
-            callback( item.second );
-        }
+        mArena.ForEach( callback );
     }
 
     template<class Func>
@@ -104,10 +116,7 @@ public:
     {
         std::lock_guard lock{ mMutex };
 
-        for (auto& item : mStore)
-        {
-            callback( item.second );
-        }
+        mArena.ForEach( callback );
     }
 
     std::vector<const CBlockIndex*> ExtractDirtyBlockIndices()
@@ -155,12 +164,9 @@ private:
             return *index;
         }
 
-        auto [mi, inserted] =
-            mStore.try_emplace(
-                blockHash,
-                CBlockIndex::PrivateTag{} );
+        auto& indexNew = mArena.Emplace( CBlockIndex::PrivateTag{} );
+        auto [mi, inserted] = mStore.emplace( blockHash, &indexNew );
         assert( inserted );
-        auto& indexNew = mi->second;
         indexNew.CBlockIndex_SetBlockHash( &mi->first, CBlockIndex::PrivateTag{} );
 
         return indexNew;
@@ -170,14 +176,20 @@ private:
     {
         if (auto it = mStore.find( blockHash ); it != mStore.end())
         {
-            return &it->second;
+            return it->second;
         }
 
         return nullptr;
     }
 
     mutable std::shared_mutex mMutex;
-    std::unordered_map<uint256, CBlockIndex, BlockHasher> mStore;
+
+    // Block hash to object lookup. Objects reference their keys as their
+    // block hash (see CBlockIndex_SetBlockHash).
+    std::unordered_map<uint256, CBlockIndex*, BlockHasher> mStore;
+    // Owns all CBlockIndex objects. Declared after mStore so that the objects
+    // are destroyed before the keys they reference.
+    ChunkedArena<CBlockIndex> mArena;
 
     /**
      * Best header we've seen so far (used for getheaders queries' starting
@@ -8,36 +8,106 @@
 #include "pow.h"
 #include "util.h"
 
+#include <algorithm>
+#include <future>
 #include <utility>
+#include <vector>
 #include <boost/thread/thread.hpp>
 
+namespace
+{
+    constexpr char DB_BLOCK_INDEX = 'b';
+
+    // Number of distinct values of the first byte of a block hash which is
+    // used to split the key space between loading threads.
+    constexpr unsigned int KEY_SPACE_RANGES = 256;
+}
+
 bool BlockIndexStoreLoader::ForceLoad(
     const Config& config,
-    std::unique_ptr<CDBIterator> cursor )
+    const CursorFactory& cursorFactory,
+    size_t numThreads )
 {
     std::lock_guard lock{ mBlockIndexStore.mMutex };
 
     assert( mBlockIndexStore.mStore.empty() );
 
-    constexpr char DB_BLOCK_INDEX = 'b';
-    cursor->Seek(std::make_pair(DB_BLOCK_INDEX, uint256()));
+    // Block hashes are uniformly distributed so splitting the key space into
+    // equally sized ranges by the first byte of the hash gives every thread
+    // roughly the same amount of work. Each thread uses its own cursor as
+    // leveldb iterators can't be shared between threads.
+    numThreads = std::clamp<size_t>( numThreads, 1, KEY_SPACE_RANGES );
+
+    // Guards mStore while it's being filled by loading threads. Objects
+    // returned by GetOrInsertNL remain at the same address after further
+    // insertions so they can be deserialised into without the lock.
+    std::mutex storeMutex;
+
+    auto loadRange =
+        [&]( size_t rangeIdx )
+        {
+            auto cursor = cursorFactory();
+            return
+                LoadRange(
+                    config,
+                    *cursor,
+                    static_cast<unsigned int>( rangeIdx * KEY_SPACE_RANGES / numThreads ),
+                    static_cast<unsigned int>( (rangeIdx + 1) * KEY_SPACE_RANGES / numThreads ),
+                    storeMutex );
+        };
+
+    std::vector<std::future<bool>> ranges;
+    for (size_t i = 1; i < numThreads; ++i)
+    {
+        ranges.push_back( std::async( std::launch::async, loadRange, i ) );
+    }
+
+    // First range is loaded by the calling thread.
+    bool result = loadRange( 0 );
+    for (auto& range : ranges)
+    {
+        result = range.get() && result;
+    }
+
+    boost::this_thread::interruption_point();
+
+    return result;
+}
+
+bool BlockIndexStoreLoader::LoadRange(
+    const Config& config,
+    CDBIterator& cursor,
+    unsigned int rangeBegin,
+    unsigned int rangeEnd,
+    std::mutex& storeMutex )
+{
+    uint256 firstKey;
+    *firstKey.begin() = static_cast<uint8_t>( rangeBegin );
+    cursor.Seek(std::make_pair(DB_BLOCK_INDEX, firstKey));
 
     // Load mapBlockIndex
-    for (; cursor->Valid(); cursor->Next())
+    for (; cursor.Valid(); cursor.Next())
     {
-        boost::this_thread::interruption_point();
         std::pair<char, uint256> key;
-        if (!cursor->GetKey(key) || key.first != DB_BLOCK_INDEX) {
+        if (!cursor.GetKey(key) || key.first != DB_BLOCK_INDEX) {
+            break;
+        }
+        if (*key.second.begin() >= rangeEnd) {
+            // Reached the range of the next thread
             break;
         }
 
         // Create uninitialized block index object in array or return one that was created previously
-        auto& indexNew = mBlockIndexStore.GetOrInsertNL( key.second );
-        assert(indexNew.GetVersion()==0 && indexNew.GetPrev()==nullptr); // We must always get an uninitialized block index object.
+        CBlockIndex* indexNew = nullptr;
+        {
+            std::lock_guard lock{ storeMutex };
+            indexNew = &mBlockIndexStore.GetOrInsertNL( key.second );
+        }
+        assert(indexNew->GetVersion()==0 && indexNew->GetPrev()==nullptr); // We must always get an uninitialized block index object.
 
         // Initialize object by reading it from database
-        CDiskBlockIndex diskindex{ indexNew };
-        if (!cursor->GetValue( diskindex ))
+        CDiskBlockIndex diskindex{ *indexNew };
+        if (!cursor.GetValue( diskindex ))
         {
             return error("LoadBlockIndex() : failed to read value");
         }
@@ -46,13 +116,20 @@ bool BlockIndexStoreLoader::ForceLoad(
         {
             // Set parent of this object. This is a second part part of logical object construction.
             // If parent does not already exist in an array, a new uninitialized object is created.
-            indexNew.CBlockIndex_SetPrev( &mBlockIndexStore.GetOrInsertNL(diskindex.GetHashPrev()), CBlockIndex::PrivateTag{} );
+            // Parent may be initialized concurrently by another thread which is fine as we only
+            // need its address here.
+            CBlockIndex* parent = nullptr;
+            {
+                std::lock_guard lock{ storeMutex };
+                parent = &mBlockIndexStore.GetOrInsertNL(diskindex.GetHashPrev());
+            }
+            indexNew->CBlockIndex_SetPrev( parent, CBlockIndex::PrivateTag{} );
         }
 
-        if (!CheckProofOfWork(indexNew.GetBlockHash(), indexNew.GetBits(),
+        if (!CheckProofOfWork(indexNew->GetBlockHash(), indexNew->GetBits(),
                               config)) {
             return error("LoadBlockIndex(): CheckProofOfWork failed: %s",
-                         indexNew.ToString());
+                         indexNew->ToString());
         }
     }
 
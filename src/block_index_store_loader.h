@@ -1,6 +1,8 @@
 // Copyright (c) 2021 Bitcoin Association.
 // Distributed under the Open BSV software license, see the accompanying file LICENSE.
 
+#include <cstddef>
+#include <functional>
 #include <memory>
 #include <mutex>
 
@@ -13,9 +15,19 @@ class BlockIndexStoreLoader
 public:
     BlockIndexStoreLoader(BlockIndexStore &blockIndexStoreIn) : mBlockIndexStore(blockIndexStoreIn) {};
 
+    using CursorFactory = std::function<std::unique_ptr<CDBIterator>()>;
+
     // may only be used in contexts where we are certain that nobody is using
     // CBlockIndex instances that are owned by this class
-    bool ForceLoad( const Config& config, std::unique_ptr<CDBIterator> cursor );
+    //
+    // The block index key space is split into numThreads ranges that are
+    // iterated and deserialised concurrently, each with its own cursor
+    // obtained from cursorFactory. Linking of the loaded objects (chain work,
+    // candidates,...) is left to the caller.
+    bool ForceLoad(
+        const Config& config,
+        const CursorFactory& cursorFactory,
+        size_t numThreads = 1 );
 
     // may only be used in contexts where we are certain that nobody is using
     // CBlockIndex instances that are owned by this class
@@ -23,10 +35,18 @@ public:
     {
         std::lock_guard lock{ mBlockIndexStore.mMutex };
 
+        mBlockIndexStore.mArena.Clear();
         mBlockIndexStore.mStore.clear();
         mBlockIndexStore.mBestHeader = nullptr;
         mBlockIndexStore.mDirtyBlockIndex.Clear();
     }
 private:
+    bool LoadRange(
+        const Config& config,
+        CDBIterator& cursor,
+        unsigned int rangeBegin,
+        unsigned int rangeEnd,
+        std::mutex& storeMutex );
+
     BlockIndexStore& mBlockIndexStore;
 };
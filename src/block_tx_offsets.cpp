@@ -0,0 +1,548 @@
+// Copyright (c) 2024 Bitcoin Association
+// Distributed under the Open BSV software license, see the accompanying file LICENSE.
+
+#include "block_tx_offsets.h"
+
+#include "block_index.h"
+#include "clientversion.h"
+#include "crypto/common.h"
+#include "fs.h"
+#include "hash.h"
+#include "primitives/block.h"
+#include "serialize.h"
+#include "streams.h"
+#include "util.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <list>
+#include <mutex>
+#include <optional>
+#include <stdexcept>
+
+namespace
+{
+    // Serialised size of a block header
+    constexpr size_t BLOCK_HEADER_SIZE = 80;
+    // Size of outpoint, sequence number, amount, version and lock time fields
+    constexpr size_t OUTPOINT_SIZE = 36;
+    constexpr size_t SEQUENCE_SIZE = 4;
+    constexpr size_t AMOUNT_SIZE = 8;
+    constexpr size_t VERSION_SIZE = 4;
+    constexpr size_t LOCKTIME_SIZE = 4;
+
+    constexpr size_t READ_CHUNK_SIZE = 256 * 1024;
+
+    /**
+     * Reads raw block data from a stream, keeping track of the offset and
+     * optionally hashing the data that is read.
+     */
+    class CRawBlockReader
+    {
+    public:
+        explicit CRawBlockReader(CForwardReadonlyStream& stream) : mStream{ stream } {}
+
+        // Used by ReadCompactSize()
+        void read(char* pch, size_t size) { Consume(reinterpret_cast<uint8_t*>(pch), size); }
+
+        void Skip(uint64_t size) { Consume(nullptr, size); }
+
+        uint64_t GetOffset() const { return mOffset; }
+
+        void StartHashing()
+        {
+            mHasher.Reset();
+            mHashing = true;
+        }
+
+        TxId FinishHashing()
+        {
+            uint256 hash;
+            mHasher.Finalize(hash.begin());
+            mHashing = false;
+            return TxId{ hash };
+        }
+
+    private:
+        void Consume(uint8_t* out, uint64_t size)
+        {
+            while (size > 0)
+            {
+                if (mPos == mChunk.Size())
+                {
+                    if (mStream.EndOfStream())
+                    {
+                        throw std::runtime_error("Unexpected end of block data");
+                    }
+                    mChunk = mStream.Read(READ_CHUNK_SIZE);
+                    mPos = 0;
+                    continue;
+                }
+
+                size_t n = static_cast<size_t>(std::min<uint64_t>(size, mChunk.Size() - mPos));
+                const uint8_t* data = mChunk.Begin() + mPos;
+                if (out)
+                {
+                    std::memcpy(out, data, n);
+                    out += n;
+                }
+                if (mHashing)
+                {
+                    mHasher.Write(data, n);
+                }
+                mPos += n;
+                mOffset += n;
+                size -= n;
+            }
+        }
+
+        CForwardReadonlyStream& mStream;
+        CSpan mChunk{};
+        size_t mPos{ 0 };
+        uint64_t mOffset{ 0 };
+        CHash256 mHasher{};
+        bool mHashing{ false };
+    };
+
+    void SkipTransaction(CRawBlockReader& reader)
+    {
+        reader.Skip(VERSION_SIZE);
+        for (uint64_t in = ReadCompactSize(reader); in > 0; --in)
+        {
+            reader.Skip(OUTPOINT_SIZE);
+            reader.Skip(ReadCompactSize(reader));
+            reader.Skip(SEQUENCE_SIZE);
+        }
+        for (uint64_t out = ReadCompactSize(reader); out > 0; --out)
+        {
+            reader.Skip(AMOUNT_SIZE);
+            reader.Skip(ReadCompactSize(reader));
+        }
+        reader.Skip(LOCKTIME_SIZE);
+    }
+
+    /** FIFO cache of transaction offsets of recently accessed blocks */
+    class CBlockTxOffsetsCache
+    {
+    public:
+        std::shared_ptr<const CBlockTxOffsets> Get(const uint256& blockHash)
+        {
+            std::lock_guard lock{ mMutex };
+            auto it = std::find_if(mEntries.begin(), mEntries.end(),
+                [&blockHash](const auto& entry) { return entry.first == blockHash; });
+            return it == mEntries.end() ? nullptr : it->second;
+        }
+
+        void Insert(const uint256& blockHash, std::shared_ptr<const CBlockTxOffsets> offsets)
+        {
+            std::lock_guard lock{ mMutex };
+            if (offsets->GetSizeInBytes() > DEFAULT_MAX_BLOCK_TX_OFFSETS_CACHE_SIZE)
+            {
+                return;
+            }
+            while (mSize + offsets->GetSizeInBytes() > DEFAULT_MAX_BLOCK_TX_OFFSETS_CACHE_SIZE)
+            {
+                mSize -= mEntries.front().second->GetSizeInBytes();
+                mEntries.pop_front();
+            }
+            mSize += offsets->GetSizeInBytes();
+            mEntries.emplace_back(blockHash, std::move(offsets));
+        }
+
+    private:
+        std::mutex mMutex{};
+        std::list<std::pair<uint256, std::shared_ptr<const CBlockTxOffsets>>> mEntries{};
+        uint64_t mSize{ 0 };
+    };
+
+    CBlockTxOffsetsCache blockTxOffsetsCache{};
+
+    // Transaction offsets file consists of a header (version and number of
+    // transactions), offsets of transactions followed by the block size and
+    // a table of (txid prefix, transaction index) entries sorted by prefix.
+    constexpr uint32_t TX_OFFSETS_FILE_VERSION = 1;
+    constexpr uint64_t TX_OFFSETS_FILE_HEADER_SIZE = 4 + 8;
+    constexpr uint64_t TX_OFFSETS_FILE_ENTRY_SIZE = 8 + 4;
+
+    std::atomic<uint64_t> txOffsetsFileMinTxs{ DEFAULT_BLOCK_TX_OFFSETS_FILE_MIN_TXS };
+
+    uint64_t GetTxIdPrefix(const TxId& txid)
+    {
+        return ReadLE64(txid.begin());
+    }
+
+    fs::path GetTxOffsetsDir(int fileNo)
+    {
+        return GetDataDir() / "blocks" / strprintf("txo%05u", fileNo);
+    }
+
+    fs::path GetTxOffsetsFilename(int fileNo, const uint256& blockHash)
+    {
+        return GetTxOffsetsDir(fileNo) / (blockHash.GetHex() + ".dat");
+    }
+
+    /**
+     * Reads parts of the transaction offsets file of a block. Files that are
+     * missing, have an unknown version or unexpected size are treated as if
+     * they did not exist.
+     */
+    class CTxOffsetsFileReader
+    {
+    public:
+        explicit CTxOffsetsFileReader(const CBlockIndex& index)
+        {
+            const fs::path path = GetTxOffsetsFilename(index.GetBlockPos().File(), index.GetBlockHash());
+            mFile = CAutoFile{ fsbridge::fopen(path, "rb"), SER_DISK, CLIENT_VERSION };
+            if (mFile.IsNull())
+            {
+                return;
+            }
+
+            uint32_t version{ 0 };
+            const uint64_t fileSize = fs::file_size(path);
+            if (fileSize >= TX_OFFSETS_FILE_HEADER_SIZE)
+            {
+                mFile >> version >> mTxCount;
+            }
+            const uint64_t expectedSize = TX_OFFSETS_FILE_HEADER_SIZE + (mTxCount + 1) * sizeof(uint64_t) +
+                                          mTxCount * TX_OFFSETS_FILE_ENTRY_SIZE;
+            if (version != TX_OFFSETS_FILE_VERSION || mTxCount != index.GetBlockTxCount() ||
+                fileSize != expectedSize)
+            {
+                LogPrintf("Ignoring invalid transaction offsets file %s\n", path.string());
+                mFile.reset();
+            }
+        }
+
+        bool IsNull() const { return mFile.IsNull(); }
+
+        std::vector<uint64_t> ReadOffsets()
+        {
+            std::vector<uint64_t> offsets(mTxCount + 1);
+            Seek(TX_OFFSETS_FILE_HEADER_SIZE);
+            for (auto& offset : offsets)
+            {
+                mFile >> offset;
+            }
+            return offsets;
+        }
+
+        // Offset and size of transaction at the given index
+        std::pair<uint64_t, uint64_t> ReadTxRange(uint64_t index)
+        {
+            uint64_t begin;
+            uint64_t end;
+            Seek(TX_OFFSETS_FILE_HEADER_SIZE + index * sizeof(uint64_t));
+            mFile >> begin >> end;
+            return { begin, end - begin };
+        }
+
+        // Indexes of transactions whose ids start with the same prefix as txid
+        std::vector<uint64_t> FindTx(const TxId& txid)
+        {
+            const uint64_t prefix = GetTxIdPrefix(txid);
+
+            // Find the first entry with the prefix
+            uint64_t first = 0;
+            uint64_t count = mTxCount;
+            while (count > 0)
+            {
+                const uint64_t step = count / 2;
+                if (ReadEntry(first + step).first < prefix)
+                {
+                    first += step + 1;
+                    count -= step + 1;
+                }
+                else
+                {
+                    count = step;
+                }
+            }
+
+            std::vector<uint64_t> indexes{};
+            for (uint64_t i = first; i < mTxCount; ++i)
+            {
+                const auto [entryPrefix, index] = ReadEntry(i);
+                if (entryPrefix != prefix)
+                {
+                    break;
+                }
+                indexes.push_back(index);
+            }
+            return indexes;
+        }
+
+    private:
+        std::pair<uint64_t, uint32_t> ReadEntry(uint64_t i)
+        {
+            std::pair<uint64_t, uint32_t> entry;
+            Seek(TX_OFFSETS_FILE_HEADER_SIZE + (mTxCount + 1) * sizeof(uint64_t) + i * TX_OFFSETS_FILE_ENTRY_SIZE);
+            mFile >> entry.first >> entry.second;
+            return entry;
+        }
+
+        void Seek(uint64_t position)
+        {
+            if (std::fseek(mFile.Get(), static_cast<long>(position), SEEK_SET) != 0)
+            {
+                throw std::ios_base::failure("Transaction offsets file seek failed");
+            }
+        }
+
+        CAutoFile mFile{ nullptr, SER_DISK, CLIENT_VERSION };
+        uint64_t mTxCount{ 0 };
+    };
+
+    CTransactionRef ReadTransactionAt(const CBlockIndex& index, uint64_t offset, uint64_t size)
+    {
+        auto stream = index.StreamSyncPartialBlockFromDisk(offset, size);
+        if (!stream)
+        {
+            return nullptr;
+        }
+
+        std::vector<uint8_t> data{};
+        data.reserve(size);
+        while (data.size() < size)
+        {
+            if (stream->EndOfStream())
+            {
+                throw std::runtime_error("Unexpected end of block data");
+            }
+            const CSpan chunk = stream->Read(size - data.size());
+            data.insert(data.end(), chunk.Begin(), chunk.Begin() + chunk.Size());
+        }
+
+        CDataStream ssTx{ data, SER_NETWORK, PROTOCOL_VERSION };
+        return MakeTransactionRef(CTransaction{ deserialize, ssTx });
+    }
+}
+
+CBlockTxOffsets::CBlockTxOffsets(std::vector<uint64_t>&& offsets)
+    : mOffsets{ std::move(offsets) }
+{
+    if (mOffsets.empty())
+    {
+        throw std::invalid_argument("Block transaction offsets must contain block size");
+    }
+}
+
+std::pair<uint64_t, uint64_t> CBlockTxOffsets::GetTxRange(size_t first, size_t count) const
+{
+    uint64_t begin = mOffsets.at(first);
+    uint64_t end = mOffsets.at(first + count);
+    return { begin, end - begin };
+}
+
+std::unique_ptr<CBlockTxOffsets> ScanBlockTransactions(
+    const CBlockIndex& index,
+    bool computeTxIds,
+    const std::function<void(uint64_t offset, const TxId& txid)>& callback)
+{
+    auto stream = index.StreamSyncBlockFromDisk();
+    if (!stream)
+    {
+        return nullptr;
+    }
+
+    try
+    {
+        CRawBlockReader reader{ *stream };
+        reader.Skip(BLOCK_HEADER_SIZE);
+        uint64_t txCount = ReadCompactSize(reader);
+
+        std::vector<uint64_t> offsets{};
+        offsets.reserve(txCount + 1);
+        for (uint64_t i = 0; i < txCount; ++i)
+        {
+            uint64_t offset = reader.GetOffset();
+            offsets.push_back(offset);
+            if (computeTxIds)
+            {
+                reader.StartHashing();
+            }
+            SkipTransaction(reader);
+            if (callback)
+            {
+                callback(offset, computeTxIds ? reader.FinishHashing() : TxId{});
+            }
+        }
+        offsets.push_back(reader.GetOffset());
+
+        return std::make_unique<CBlockTxOffsets>(std::move(offsets));
+    }
+    catch (const std::exception& e)
+    {
+        error("%s: Error reading block %s: %s", __func__,
+            index.GetBlockHash().ToString(), e.what());
+        return nullptr;
+    }
+}
+
+std::shared_ptr<const CBlockTxOffsets> GetBlockTxOffsets(const CBlockIndex& index)
+{
+    const uint256 blockHash = index.GetBlockHash();
+    if (auto offsets = blockTxOffsetsCache.Get(blockHash))
+    {
+        return offsets;
+    }
+
+    std::shared_ptr<const CBlockTxOffsets> offsets{};
+    try
+    {
+        CTxOffsetsFileReader file{ index };
+        if (!file.IsNull())
+        {
+            offsets = std::make_shared<CBlockTxOffsets>(file.ReadOffsets());
+        }
+    }
+    catch (const std::exception& e)
+    {
+        error("%s: Error reading transaction offsets of block %s: %s", __func__,
+            blockHash.ToString(), e.what());
+    }
+
+    if (!offsets)
+    {
+        offsets = ScanBlockTransactions(index, false);
+    }
+    if (offsets)
+    {
+        blockTxOffsetsCache.Insert(blockHash, offsets);
+    }
+    return offsets;
+}
+
+CTransactionRef ReadBlockTransaction(const CBlockIndex& index, const TxId& txid)
+{
+    try
+    {
+        CTxOffsetsFileReader file{ index };
+        if (!file.IsNull())
+        {
+            for (uint64_t txIndex : file.FindTx(txid))
+            {
+                const auto [offset, size] = file.ReadTxRange(txIndex);
+                CTransactionRef tx = ReadTransactionAt(index, offset, size);
+                if (tx && tx->GetId() == txid)
+                {
+                    return tx;
+                }
+            }
+            return nullptr;
+        }
+
+        std::optional<size_t> txIndex{};
+        size_t count{ 0 };
+        std::shared_ptr<const CBlockTxOffsets> offsets = ScanBlockTransactions(index, true,
+            [&](uint64_t, const TxId& id)
+            {
+                if (id == txid && !txIndex.has_value())
+                {
+                    txIndex = count;
+                }
+                ++count;
+            });
+        if (!offsets)
+        {
+            return nullptr;
+        }
+        blockTxOffsetsCache.Insert(index.GetBlockHash(), offsets);
+        if (!txIndex.has_value())
+        {
+            return nullptr;
+        }
+
+        const auto [offset, size] = offsets->GetTxRange(txIndex.value(), 1);
+        return ReadTransactionAt(index, offset, size);
+    }
+    catch (const std::exception& e)
+    {
+        error("%s: Error reading transaction %s of block %s: %s", __func__,
+            txid.ToString(), index.GetBlockHash().ToString(), e.what());
+        return nullptr;
+    }
+}
+
+void SetBlockTxOffsetsFileMinTxs(uint64_t minTxs)
+{
+    txOffsetsFileMinTxs = minTxs;
+}
+
+bool WriteBlockTxOffsetsFile(const CBlock& block, int fileNo)
+{
+    const uint64_t minTxs = txOffsetsFileMinTxs;
+    if (minTxs == 0 || block.vtx.size() < minTxs)
+    {
+        return true;
+    }
+
+    // The file may already exist if the block is stored again during reindex
+    const fs::path path = GetTxOffsetsFilename(fileNo, block.GetHash());
+    if (fs::exists(path))
+    {
+        return true;
+    }
+
+    std::vector<std::pair<uint64_t, uint32_t>> entries{};
+    entries.reserve(block.vtx.size());
+    for (size_t i = 0; i < block.vtx.size(); ++i)
+    {
+        entries.emplace_back(GetTxIdPrefix(block.vtx[i]->GetId()), static_cast<uint32_t>(i));
+    }
+    std::sort(entries.begin(), entries.end());
+
+    try
+    {
+        fs::create_directories(path.parent_path());
+
+        // Written to a temporary file first so that readers never see a
+        // partially written file
+        fs::path tmpPath = path;
+        tmpPath += ".new";
+        {
+            CAutoFile file{ fsbridge::fopen(tmpPath, "wb"), SER_DISK, CLIENT_VERSION };
+            if (file.IsNull())
+            {
+                return error("%s: Failed to open file %s", __func__, tmpPath.string());
+            }
+
+            file << TX_OFFSETS_FILE_VERSION << static_cast<uint64_t>(block.vtx.size());
+            uint64_t offset = BLOCK_HEADER_SIZE + GetSizeOfCompactSize(block.vtx.size());
+            for (const auto& tx : block.vtx)
+            {
+                file << offset;
+                offset += tx->GetTotalSize();
+            }
+            file << offset;
+            for (const auto& [prefix, index] : entries)
+            {
+                file << prefix << index;
+            }
+        }
+
+        if (!RenameOver(tmpPath, path))
+        {
+            return error("%s: Failed to rename file %s", __func__, tmpPath.string());
+        }
+    }
+    catch (const std::exception& e)
+    {
+        return error("%s: Error writing transaction offsets of block %s: %s", __func__,
+            block.GetHash().ToString(), e.what());
+    }
+
+    return true;
+}
+
+void RemoveBlockTxOffsetsFiles(int fileNo)
+{
+    boost::system::error_code ec;
+    fs::remove_all(GetTxOffsetsDir(fileNo), ec);
+    if (ec)
+    {
+        LogPrintf("Failed to remove transaction offsets files of block file %d: %s\n", fileNo, ec.message());
+    }
+}
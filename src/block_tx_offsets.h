@@ -0,0 +1,99 @@
+// Copyright (c) 2024 Bitcoin Association
+// Distributed under the Open BSV software license, see the accompanying file LICENSE.
+
+#pragma once
+
+#include "primitives/transaction.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <utility>
+#include <vector>
+
+class CBlock;
+class CBlockIndex;
+
+/** The default maximum size of the memory cache of block transaction offsets */
+static constexpr uint64_t DEFAULT_MAX_BLOCK_TX_OFFSETS_CACHE_SIZE{ 32 * 1024 * 1024 }; // 32 MiB
+/**
+ * The default minimum number of transactions of a block for which a transaction
+ * offsets file is written, 0 means that the files are not written
+ */
+static constexpr uint64_t DEFAULT_BLOCK_TX_OFFSETS_FILE_MIN_TXS{ 0 };
+
+/**
+ * Offsets of transactions within the serialised block data on disk, counted
+ * from the start of the block header. They make it possible to read a range of
+ * transactions of a block by seeking to it instead of parsing the block from
+ * its start.
+ */
+class CBlockTxOffsets
+{
+public:
+    // offsets contains an offset for every transaction followed by the size of
+    // the block
+    explicit CBlockTxOffsets(std::vector<uint64_t>&& offsets);
+
+    size_t GetTxCount() const { return mOffsets.size() - 1; }
+    uint64_t GetTxOffset(size_t index) const { return mOffsets.at(index); }
+    uint64_t GetBlockSize() const { return mOffsets.back(); }
+
+    // Offset and size of count transactions starting with transaction first.
+    // The range must be within the block.
+    std::pair<uint64_t, uint64_t> GetTxRange(size_t first, size_t count) const;
+
+    uint64_t GetSizeInBytes() const { return mOffsets.size() * sizeof(uint64_t); }
+
+private:
+    std::vector<uint64_t> mOffsets;
+};
+
+/**
+ * Scan block data on disk and call callback with the offset of every
+ * transaction and, if computeTxIds is set, its id. Transactions are skipped
+ * over rather than deserialised.
+ *
+ * Returns nullptr if block data could not be read.
+ */
+std::unique_ptr<CBlockTxOffsets> ScanBlockTransactions(
+    const CBlockIndex& index,
+    bool computeTxIds,
+    const std::function<void(uint64_t offset, const TxId& txid)>& callback = {});
+
+/**
+ * Get transaction offsets of a block, from the memory cache, the block's
+ * transaction offsets file or by scanning the block data on disk.
+ *
+ * Returns nullptr if block data could not be read.
+ */
+std::shared_ptr<const CBlockTxOffsets> GetBlockTxOffsets(const CBlockIndex& index);
+
+/**
+ * Read transaction txid of a block from disk. The transaction is looked up in
+ * the block's transaction offsets file if it exists, otherwise the block data
+ * is scanned for it.
+ *
+ * Returns nullptr if the transaction is not in the block or block data could
+ * not be read.
+ */
+CTransactionRef ReadBlockTransaction(const CBlockIndex& index, const TxId& txid);
+
+/**
+ * Transaction offsets files are written next to the block files, one for each
+ * block with at least the given number of transactions. Besides the offsets of
+ * transactions in block order they contain a sorted table of txid prefixes
+ * that is used to find a transaction in the block by binary search.
+ *
+ * Files of blocks in block file blk?????.dat are stored in directory
+ * txo?????/ and are removed together with the block file.
+ */
+void SetBlockTxOffsetsFileMinTxs(uint64_t minTxs);
+
+// Write transaction offsets file of a block stored in block file fileNo if
+// the block has enough transactions.
+bool WriteBlockTxOffsetsFile(const CBlock& block, int fileNo);
+
+// Remove transaction offsets files of blocks stored in block file fileNo.
+void RemoveBlockTxOffsetsFiles(int fileNo);
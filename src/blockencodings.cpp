@@ -12,6 +12,7 @@
 #include "random.h"
 #include "streams.h"
 #include "txmempool.h"
+#include "util.h"
 #include "validation.h"
 
 #include <unordered_map>
@@ -157,33 +158,33 @@ ReadStatus PartiallyDownloadedBlock::InitData(
         return READ_STATUS_FAILED;
     }
 
+    // Only ids of mempool transactions are hashed while scanning (in
+    // parallel) so that mempools with millions of transactions don't delay
+    // the reconstruction and only transactions that are in the block get
+    // loaded.
     std::vector<bool> have_txn(txns_available.size());
     {
-        for (const auto& tx : pool->GetTransactions()) {
-            const auto shortid = cmpctblock.GetShortID(tx->GetHash());
-            const auto idit = shorttxids.find(shortid);
-            if (idit != shorttxids.end()) {
-                if (!have_txn[idit->second]) {
-                    txns_available[idit->second] = tx;
-                    have_txn[idit->second] = true;
-                    mempool_count++;
-                } else {
-                    // If we find two mempool txn that match the short id, just
-                    // request it. This should be rare enough that the extra
-                    // bandwidth doesn't matter, but eating a round-trip due to
-                    // FillBlock failure would be annoying.
-                    if (txns_available[idit->second]) {
-                        txns_available[idit->second].reset();
-                        mempool_count--;
-                    }
+        const auto matching = pool->GetTransactions(
+            [&cmpctblock, &shorttxids](const TxId& txid) {
+                return shorttxids.count(cmpctblock.GetShortID(txid)) != 0;
+            },
+            GetNumCores());
+        for (const auto& tx : matching) {
+            const auto idit = shorttxids.find(cmpctblock.GetShortID(tx->GetId()));
+            if (!have_txn[idit->second]) {
+                txns_available[idit->second] = tx;
+                have_txn[idit->second] = true;
+                mempool_count++;
+            } else {
+                // If we find two mempool txn that match the short id, just
+                // request it. This should be rare enough that the extra
+                // bandwidth doesn't matter, but eating a round-trip due to
+                // FillBlock failure would be annoying.
+                if (txns_available[idit->second]) {
+                    txns_available[idit->second].reset();
+                    mempool_count--;
                 }
             }
-            // Though ideally we'd continue scanning for the
-            // two-txn-match-shortid case, the performance win of an early exit
-            // here is too good to pass up and worth the extra risk.
-            if (mempool_count == shorttxids.size()) {
-                break;
-            }
         }
     }
 
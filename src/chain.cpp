@@ -55,6 +55,29 @@ CBlockLocator CChain::GetLocator(const CBlockIndex *pindex) const {
     return CBlockLocator(vHave);
 }
 
+CBlockLocator GetBlockIndexLocator(const CBlockIndex& index) {
+    int nStep = 1;
+    std::vector<uint256> vHave;
+    vHave.reserve(32);
+
+    const CBlockIndex* pindex = &index;
+    while (pindex) {
+        vHave.push_back(pindex->GetBlockHash());
+        // Stop when we have added the genesis block.
+        if (pindex->GetHeight() == 0) {
+            break;
+        }
+        // Exponentially larger steps back, plus the genesis block.
+        int32_t nHeight = std::max(pindex->GetHeight() - nStep, 0);
+        pindex = pindex->GetAncestor(nHeight);
+        if (vHave.size() > 10) {
+            nStep *= 2;
+        }
+    }
+
+    return CBlockLocator(vHave);
+}
+
 const CBlockIndex *CChain::FindFork(const CBlockIndex *pindex) const {
     if (pindex == nullptr) {
         return nullptr;
@@ -96,4 +96,14 @@ public:
     CBlockIndex *FindEarliestAtLeast(int64_t nTime) const;
 };
 
+/**
+ * Return a CBlockLocator that refers to the given block index entry.
+ *
+ * Unlike CChain::GetLocator() the locator is built only by walking the skip
+ * list of the block index entry, which never changes once the entry is
+ * inserted into the block index store, so the caller doesn't need to hold
+ * cs_main.
+ */
+CBlockLocator GetBlockIndexLocator(const CBlockIndex& index);
+
 #endif // BITCOIN_CHAIN_H
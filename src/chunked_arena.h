@@ -0,0 +1,104 @@
+// Copyright (c) 2024 Bitcoin Association
+// Distributed under the Open BSV software license, see the accompanying file LICENSE.
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <utility>
+#include <vector>
+
+/**
+ * Append-only storage of objects in fixed size contiguous chunks.
+ *
+ * Objects are never moved once constructed so pointers and references to them
+ * stay valid until the arena is cleared or destroyed. Objects that were
+ * created one after another are placed next to each other in memory, which
+ * makes walking over them much more cache friendly than over nodes of a node
+ * based container.
+ *
+ * Objects are destroyed only when the whole arena is cleared.
+ *
+ * The class is not thread safe, synchronization is left to the owner.
+ */
+template<typename T, size_t ChunkSize = 1024>
+class ChunkedArena
+{
+public:
+    ChunkedArena() = default;
+    ~ChunkedArena() { Clear(); }
+
+    ChunkedArena(const ChunkedArena&) = delete;
+    ChunkedArena& operator=(const ChunkedArena&) = delete;
+    ChunkedArena(ChunkedArena&&) = delete;
+    ChunkedArena& operator=(ChunkedArena&&) = delete;
+
+    /** Construct a new object at the end of the arena. */
+    template<typename... Args>
+    T& Emplace(Args&&... args)
+    {
+        if (mSize == mChunks.size() * ChunkSize)
+        {
+            // Storage is intentionally left uninitialized.
+            mChunks.emplace_back(new Chunk);
+        }
+
+        T* object = new (&(*mChunks.back())[mSize % ChunkSize]) T(std::forward<Args>(args)...);
+        ++mSize;
+
+        return *object;
+    }
+
+    size_t Size() const { return mSize; }
+
+    T& operator[](size_t idx)
+    {
+        return *std::launder(reinterpret_cast<T*>(&(*mChunks[idx / ChunkSize])[idx % ChunkSize]));
+    }
+
+    const T& operator[](size_t idx) const
+    {
+        return *std::launder(reinterpret_cast<const T*>(&(*mChunks[idx / ChunkSize])[idx % ChunkSize]));
+    }
+
+    /** Call callback for every object in the order in which they were created. */
+    template<class Func>
+    void ForEach(Func callback)
+    {
+        for (size_t i = 0; i < mSize; ++i)
+        {
+            callback( (*this)[i] );
+        }
+    }
+
+    template<class Func>
+    void ForEach(Func callback) const
+    {
+        for (size_t i = 0; i < mSize; ++i)
+        {
+            callback( (*this)[i] );
+        }
+    }
+
+    /** Destroy all objects (in reverse order of creation) and release memory. */
+    void Clear()
+    {
+        while (mSize > 0)
+        {
+            (*this)[--mSize].~T();
+        }
+        mChunks.clear();
+    }
+
+private:
+    struct alignas(T) Slot
+    {
+        std::byte data[sizeof(T)];
+    };
+    using Chunk = std::array<Slot, ChunkSize>;
+
+    std::vector<std::unique_ptr<Chunk>> mChunks;
+    size_t mSize{ 0 };
+};
@@ -0,0 +1,690 @@
+// Copyright (c) 2024 Bitcoin Association
+// Distributed under the Open BSV software license, see the accompanying file LICENSE.
+
+#include "compact_txindex.h"
+
+#include "block_file_access.h"
+#include "block_index.h"
+#include "block_index_store.h"
+#include "block_tx_offsets.h"
+#include "chain.h"
+#include "clientversion.h"
+#include "crypto/common.h"
+#include "disk_tx_pos.h"
+#include "primitives/block.h"
+#include "serialize.h"
+#include "streams.h"
+#include "txdb.h"
+#include "util.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <optional>
+#include <set>
+#include <stdexcept>
+
+std::unique_ptr<CCompactTxIndex> pCompactTxIndex{};
+
+namespace
+{
+    // Segment file consists of a header (version and number of entries), the
+    // entries sorted by txid prefix and fences: the prefix of every
+    // FENCE_INTERVAL-th entry. Fences are kept in memory so that entries with
+    // a given prefix are found by reading one or two runs of entries.
+    constexpr uint32_t SEGMENT_FILE_VERSION = 1;
+    constexpr uint64_t SEGMENT_HEADER_SIZE = 4 + 8;
+    constexpr uint64_t SEGMENT_ENTRY_SIZE = 8 + 4 + 8;
+    constexpr uint64_t FENCE_INTERVAL = 1024;
+
+    constexpr uint32_t METADATA_FILE_VERSION = 1;
+    const char* const METADATA_FILE_NAME = "meta.dat";
+
+    // Number of entries that are read from a segment at once while merging
+    constexpr uint64_t MERGE_READ_ENTRIES = 64 * FENCE_INTERVAL;
+    // Number of entries of the LevelDB index that are migrated at once
+    constexpr size_t MIGRATE_BATCH_ENTRIES = 100000;
+
+    // Serialised size of a block header
+    constexpr uint64_t BLOCK_HEADER_SIZE = 80;
+
+    uint64_t GetFenceCount(uint64_t count)
+    {
+        return (count + FENCE_INTERVAL - 1) / FENCE_INTERVAL;
+    }
+
+    uint64_t GetSegmentFileSize(uint64_t count)
+    {
+        return SEGMENT_HEADER_SIZE + count * SEGMENT_ENTRY_SIZE + GetFenceCount(count) * sizeof(uint64_t);
+    }
+
+    void Seek(CAutoFile& file, uint64_t position)
+    {
+        if (std::fseek(file.Get(), static_cast<long>(position), SEEK_SET) != 0)
+        {
+            throw std::ios_base::failure("Transaction index seek failed");
+        }
+    }
+
+    fs::path GetTmpPath(const fs::path& path)
+    {
+        fs::path tmpPath = path;
+        tmpPath += ".new";
+        return tmpPath;
+    }
+
+    /** Writes entries sorted by prefix to a new segment file */
+    class CSegmentWriter
+    {
+    public:
+        explicit CSegmentWriter(const fs::path& path)
+            : mPath{ path }
+            , mFile{ fsbridge::fopen(GetTmpPath(path), "wb"), SER_DISK, CLIENT_VERSION }
+        {
+            if (mFile.IsNull())
+            {
+                throw std::runtime_error("Failed to create " + GetTmpPath(path).string());
+            }
+            mFile << SEGMENT_FILE_VERSION << mCount;
+        }
+
+        // Entries must be added in sorted order, duplicates are skipped.
+        void Add(const CCompactTxIndexEntry& entry)
+        {
+            if (mCount > 0 && entry == mLast)
+            {
+                return;
+            }
+            if (mCount % FENCE_INTERVAL == 0)
+            {
+                mFences.push_back(entry.txIdPrefix);
+            }
+            mFile << entry.txIdPrefix << entry.height << entry.txOffset;
+            mLast = entry;
+            ++mCount;
+        }
+
+        // Finish writing and move the file into place.
+        void Finish()
+        {
+            for (uint64_t fence : mFences)
+            {
+                mFile << fence;
+            }
+            Seek(mFile, sizeof(SEGMENT_FILE_VERSION));
+            mFile << mCount;
+            FileCommit(mFile.Get());
+            mFile.reset();
+            if (!RenameOver(GetTmpPath(mPath), mPath))
+            {
+                throw std::runtime_error("Failed to rename " + GetTmpPath(mPath).string());
+            }
+        }
+
+    private:
+        const fs::path mPath;
+        CAutoFile mFile;
+        uint64_t mCount{ 0 };
+        CCompactTxIndexEntry mLast{};
+        std::vector<uint64_t> mFences{};
+    };
+
+    uint64_t GetBlockPosKey(const CDiskBlockPos& pos)
+    {
+        return (static_cast<uint64_t>(static_cast<uint32_t>(pos.File())) << 32) | pos.Pos();
+    }
+
+    // Add entries of the LevelDB transaction index for blocks of the active
+    // chain to index. Returns the number of added entries.
+    std::optional<uint64_t> MigrateTxIndex(CCompactTxIndex& index, CBlockTreeDB& blockTree, const CChain& chain)
+    {
+        LogPrintf("Migrating transaction index entries to the compact transaction index...\n");
+
+        // Heights of blocks in the active chain by position of the block on disk
+        std::unordered_map<uint64_t, int32_t> heights{};
+        heights.reserve(static_cast<size_t>(chain.Height()) + 1);
+        for (const CBlockIndex* pindex = chain.Genesis(); pindex != nullptr; pindex = chain.Next(pindex))
+        {
+            heights.emplace(GetBlockPosKey(pindex->GetBlockPos()), pindex->GetHeight());
+        }
+
+        uint64_t migrated{ 0 };
+        uint64_t skipped{ 0 };
+        bool ok{ true };
+        std::vector<CCompactTxIndexEntry> entries{};
+        bool read = blockTree.ForEachTxIndexEntry(
+            [&](const uint256& txid, const CDiskTxPos& pos)
+            {
+                const auto it = heights.find(GetBlockPosKey(pos));
+                if (it == heights.end())
+                {
+                    ++skipped;
+                    return;
+                }
+                entries.push_back({ CCompactTxIndex::GetTxIdPrefix(TxId{ txid }), it->second, pos.TxOffset() });
+                ++migrated;
+                if (entries.size() == MIGRATE_BATCH_ENTRIES)
+                {
+                    ok = ok && index.AddEntries(std::move(entries));
+                    entries.clear();
+                }
+            });
+        ok = ok && index.AddEntries(std::move(entries));
+        if (!read || !ok)
+        {
+            return std::nullopt;
+        }
+
+        LogPrintf("Migrated %u transaction index entries, skipped %u entries of blocks not in the active chain\n",
+            migrated, skipped);
+        return migrated;
+    }
+}
+
+class CCompactTxIndex::Segment
+{
+public:
+    Segment(uint64_t id, const fs::path& path)
+        : mId{ id }
+        , mFile{ fsbridge::fopen(path, "rb"), SER_DISK, CLIENT_VERSION }
+    {
+        if (mFile.IsNull())
+        {
+            throw std::runtime_error("Failed to open " + path.string());
+        }
+
+        uint32_t version;
+        mFile >> version >> mCount;
+        if (version != SEGMENT_FILE_VERSION || fs::file_size(path) != GetSegmentFileSize(mCount))
+        {
+            throw std::runtime_error("Invalid transaction index file " + path.string());
+        }
+
+        mFences.resize(GetFenceCount(mCount));
+        Seek(mFile, SEGMENT_HEADER_SIZE + mCount * SEGMENT_ENTRY_SIZE);
+        for (uint64_t& fence : mFences)
+        {
+            mFile >> fence;
+        }
+    }
+
+    uint64_t GetId() const { return mId; }
+    uint64_t GetCount() const { return mCount; }
+
+    // Read up to count entries starting with entry first
+    std::vector<CCompactTxIndexEntry> Read(uint64_t first, uint64_t count) const
+    {
+        std::vector<CCompactTxIndexEntry> entries{};
+        if (first >= mCount)
+        {
+            return entries;
+        }
+        entries.resize(std::min(count, mCount - first));
+
+        std::lock_guard lock{ mFileMutex };
+        Seek(mFile, SEGMENT_HEADER_SIZE + first * SEGMENT_ENTRY_SIZE);
+        for (auto& entry : entries)
+        {
+            mFile >> entry.txIdPrefix >> entry.height >> entry.txOffset;
+        }
+        return entries;
+    }
+
+    void Find(uint64_t prefix, std::vector<CCompactTxIndexEntry>& result) const
+    {
+        // The first entry with the prefix may be at the end of the run before
+        // the first fence that is not less than the prefix
+        const auto fence = std::lower_bound(mFences.begin(), mFences.end(), prefix);
+        uint64_t run = static_cast<uint64_t>(std::distance(mFences.begin(), fence));
+        run = run > 0 ? run - 1 : 0;
+
+        for (uint64_t first = run * FENCE_INTERVAL; first < mCount; first += FENCE_INTERVAL)
+        {
+            for (const auto& entry : Read(first, FENCE_INTERVAL))
+            {
+                if (entry.txIdPrefix > prefix)
+                {
+                    return;
+                }
+                if (entry.txIdPrefix == prefix)
+                {
+                    result.push_back(entry);
+                }
+            }
+        }
+    }
+
+private:
+    const uint64_t mId;
+    mutable std::mutex mFileMutex{};
+    mutable CAutoFile mFile;
+    uint64_t mCount{ 0 };
+    std::vector<uint64_t> mFences{};
+};
+
+CCompactTxIndex::CCompactTxIndex(const fs::path& dir, bool wipe, size_t bufferEntries)
+    : mDir{ dir }
+    , mBufferEntries{ bufferEntries }
+{
+    if (wipe)
+    {
+        fs::remove_all(mDir);
+    }
+    fs::create_directories(mDir);
+
+    CAutoFile file{ fsbridge::fopen(mDir / METADATA_FILE_NAME, "rb"), SER_DISK, CLIENT_VERSION };
+    if (!file.IsNull())
+    {
+        uint32_t version;
+        file >> version;
+        if (version != METADATA_FILE_VERSION)
+        {
+            throw std::runtime_error("Unsupported compact transaction index version");
+        }
+
+        std::vector<uint64_t> segmentIds{};
+        file >> mBestBlock >> mNextSegmentId >> segmentIds;
+        for (uint64_t id : segmentIds)
+        {
+            mSegments.push_back(std::make_shared<const Segment>(id, GetSegmentPath(id)));
+        }
+    }
+
+    RemoveUnusedFiles();
+}
+
+CCompactTxIndex::~CCompactTxIndex() = default;
+
+uint64_t CCompactTxIndex::GetTxIdPrefix(const TxId& txid)
+{
+    return ReadLE64(txid.begin());
+}
+
+bool CCompactTxIndex::AddBlock(const CBlock& block, int32_t height)
+{
+    std::vector<CCompactTxIndexEntry> entries{};
+    entries.reserve(block.vtx.size());
+
+    uint64_t offset = GetSizeOfCompactSize(block.vtx.size());
+    for (const auto& tx : block.vtx)
+    {
+        entries.push_back({ GetTxIdPrefix(tx->GetId()), height, offset });
+        offset += tx->GetTotalSize();
+    }
+
+    return AddEntries(std::move(entries));
+}
+
+bool CCompactTxIndex::AddEntries(std::vector<CCompactTxIndexEntry>&& entries)
+{
+    bool full{ false };
+    {
+        std::lock_guard lock{ mMutex };
+        for (const auto& entry : entries)
+        {
+            mBuffer.emplace(entry.txIdPrefix, entry);
+        }
+        full = mBuffer.size() >= mBufferEntries;
+    }
+
+    if (full)
+    {
+        try
+        {
+            std::lock_guard writeLock{ mWriteMutex };
+            WriteBuffer();
+        }
+        catch (const std::exception& e)
+        {
+            return error("%s: Error writing compact transaction index: %s", __func__, e.what());
+        }
+    }
+    return true;
+}
+
+bool CCompactTxIndex::Flush(const uint256& bestBlock)
+{
+    try
+    {
+        std::lock_guard writeLock{ mWriteMutex };
+        const bool written = WriteBuffer();
+        {
+            std::lock_guard lock{ mMutex };
+            if (!written && mBestBlock == bestBlock)
+            {
+                return true;
+            }
+            mBestBlock = bestBlock;
+        }
+        WriteMetadata();
+        return true;
+    }
+    catch (const std::exception& e)
+    {
+        return error("%s: Error writing compact transaction index: %s", __func__, e.what());
+    }
+}
+
+uint256 CCompactTxIndex::GetBestBlock() const
+{
+    std::lock_guard lock{ mMutex };
+    return mBestBlock;
+}
+
+std::vector<CCompactTxIndexEntry> CCompactTxIndex::Find(const TxId& txid) const
+{
+    const uint64_t prefix = GetTxIdPrefix(txid);
+    std::vector<CCompactTxIndexEntry> result{};
+    std::vector<SegmentRef> segments{};
+    {
+        std::lock_guard lock{ mMutex };
+        const auto [begin, end] = mBuffer.equal_range(prefix);
+        for (auto it = begin; it != end; ++it)
+        {
+            result.push_back(it->second);
+        }
+        if (mPending)
+        {
+            auto it = std::lower_bound(mPending->begin(), mPending->end(), prefix,
+                [](const CCompactTxIndexEntry& entry, uint64_t p) { return entry.txIdPrefix < p; });
+            for (; it != mPending->end() && it->txIdPrefix == prefix; ++it)
+            {
+                result.push_back(*it);
+            }
+        }
+        segments = mSegments;
+    }
+
+    // Newest segments first as recent transactions are more likely requested
+    for (auto it = segments.rbegin(); it != segments.rend(); ++it)
+    {
+        (*it)->Find(prefix, result);
+    }
+    return result;
+}
+
+size_t CCompactTxIndex::GetSegmentCount() const
+{
+    std::lock_guard lock{ mMutex };
+    return mSegments.size();
+}
+
+bool CCompactTxIndex::WriteBuffer()
+{
+    auto pending = std::make_shared<std::vector<CCompactTxIndexEntry>>();
+    uint64_t id;
+    {
+        std::lock_guard lock{ mMutex };
+        if (mBuffer.empty())
+        {
+            return false;
+        }
+        pending->reserve(mBuffer.size());
+        for (const auto& [prefix, entry] : mBuffer)
+        {
+            pending->push_back(entry);
+        }
+        std::sort(pending->begin(), pending->end());
+        // Entries remain visible to Find() while they are being written
+        mPending = pending;
+        mBuffer.clear();
+        id = mNextSegmentId++;
+    }
+
+    CSegmentWriter writer{ GetSegmentPath(id) };
+    for (const auto& entry : *pending)
+    {
+        writer.Add(entry);
+    }
+    writer.Finish();
+    auto segment = std::make_shared<const Segment>(id, GetSegmentPath(id));
+    {
+        std::lock_guard lock{ mMutex };
+        mSegments.push_back(std::move(segment));
+        mPending.reset();
+    }
+
+    // Merge the newest segments while they are of similar size. Segments are
+    // only changed here and mWriteMutex is held so they can be read without
+    // holding mMutex.
+    std::vector<SegmentRef> obsolete{};
+    while (mSegments.size() >= 2 &&
+           mSegments[mSegments.size() - 1]->GetCount() * 2 >= mSegments[mSegments.size() - 2]->GetCount())
+    {
+        const SegmentRef first = mSegments[mSegments.size() - 2];
+        const SegmentRef second = mSegments[mSegments.size() - 1];
+        SegmentRef merged = MergeSegments(first, second);
+        {
+            std::lock_guard lock{ mMutex };
+            mSegments.pop_back();
+            mSegments.back() = std::move(merged);
+        }
+        obsolete.push_back(first);
+        obsolete.push_back(second);
+    }
+
+    WriteMetadata();
+
+    // Files of merged segments are no longer referenced by the metadata.
+    // Segments that are still being searched keep their files open.
+    for (const auto& segment : obsolete)
+    {
+        fs::remove(GetSegmentPath(segment->GetId()));
+    }
+    return true;
+}
+
+CCompactTxIndex::SegmentRef CCompactTxIndex::MergeSegments(const SegmentRef& first, const SegmentRef& second)
+{
+    uint64_t id;
+    {
+        std::lock_guard lock{ mMutex };
+        id = mNextSegmentId++;
+    }
+
+    // Sequential reader of a segment
+    struct Cursor
+    {
+        const Segment& segment;
+        uint64_t next{ 0 };
+        std::vector<CCompactTxIndexEntry> entries{};
+        size_t pos{ 0 };
+
+        const CCompactTxIndexEntry* Get()
+        {
+            if (pos == entries.size())
+            {
+                entries = segment.Read(next, MERGE_READ_ENTRIES);
+                next += entries.size();
+                pos = 0;
+            }
+            return pos < entries.size() ? &entries[pos] : nullptr;
+        }
+    };
+
+    CSegmentWriter writer{ GetSegmentPath(id) };
+    Cursor a{ *first };
+    Cursor b{ *second };
+    for (;;)
+    {
+        const CCompactTxIndexEntry* entryA = a.Get();
+        const CCompactTxIndexEntry* entryB = b.Get();
+        if (entryA == nullptr && entryB == nullptr)
+        {
+            break;
+        }
+        if (entryB == nullptr || (entryA != nullptr && !(*entryB < *entryA)))
+        {
+            writer.Add(*entryA);
+            ++a.pos;
+        }
+        else
+        {
+            writer.Add(*entryB);
+            ++b.pos;
+        }
+    }
+    writer.Finish();
+
+    return std::make_shared<const Segment>(id, GetSegmentPath(id));
+}
+
+void CCompactTxIndex::WriteMetadata() const
+{
+    uint256 bestBlock;
+    uint64_t nextSegmentId;
+    std::vector<uint64_t> segmentIds{};
+    {
+        std::lock_guard lock{ mMutex };
+        bestBlock = mBestBlock;
+        nextSegmentId = mNextSegmentId;
+        for (const auto& segment : mSegments)
+        {
+            segmentIds.push_back(segment->GetId());
+        }
+    }
+
+    const fs::path path = mDir / METADATA_FILE_NAME;
+    CAutoFile file{ fsbridge::fopen(GetTmpPath(path), "wb"), SER_DISK, CLIENT_VERSION };
+    if (file.IsNull())
+    {
+        throw std::runtime_error("Failed to create " + GetTmpPath(path).string());
+    }
+    file << METADATA_FILE_VERSION << bestBlock << nextSegmentId << segmentIds;
+    FileCommit(file.Get());
+    file.reset();
+    if (!RenameOver(GetTmpPath(path), path))
+    {
+        throw std::runtime_error("Failed to rename " + GetTmpPath(path).string());
+    }
+}
+
+void CCompactTxIndex::RemoveUnusedFiles() const
+{
+    std::set<fs::path> used{ mDir / METADATA_FILE_NAME };
+    for (const auto& segment : mSegments)
+    {
+        used.insert(GetSegmentPath(segment->GetId()));
+    }
+
+    // Leftovers of segments that were being written or merged
+    for (const auto& entry : fs::directory_iterator(mDir))
+    {
+        if (fs::is_regular_file(entry.path()) && used.count(entry.path()) == 0)
+        {
+            LogPrintf("Removing unused transaction index file %s\n", entry.path().string());
+            fs::remove(entry.path());
+        }
+    }
+}
+
+fs::path CCompactTxIndex::GetSegmentPath(uint64_t id) const
+{
+    return mDir / strprintf("seg%08u.dat", id);
+}
+
+bool FindTransactionInCompactTxIndex(
+    const CCompactTxIndex& index,
+    const CChain& chain,
+    const TxId& txid,
+    CTransactionRef& tx,
+    const CBlockIndex*& blockIndex)
+{
+    std::vector<CCompactTxIndexEntry> entries{};
+    try
+    {
+        entries = index.Find(txid);
+    }
+    catch (const std::exception& e)
+    {
+        return error("%s: Error reading compact transaction index: %s", __func__, e.what());
+    }
+
+    for (const auto& entry : entries)
+    {
+        if (entry.height < 0 || entry.height > chain.Height())
+        {
+            continue;
+        }
+        const CBlockIndex* pindex = chain[entry.height];
+        if (!pindex->getStatus().hasData())
+        {
+            continue;
+        }
+
+        uint256 hashBlock;
+        CTransactionRef txOut;
+        if (BlockFileAccess::LoadBlockHashAndTx(CDiskTxPos{ pindex->GetBlockPos(), entry.txOffset }, hashBlock, txOut) &&
+            hashBlock == pindex->GetBlockHash() && txOut->GetId() == txid)
+        {
+            tx = std::move(txOut);
+            blockIndex = pindex;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool SyncCompactTxIndex(CCompactTxIndex& index, CBlockTreeDB& blockTree, const CChain& chain)
+{
+    const CBlockIndex* tip = chain.Tip();
+    if (tip == nullptr)
+    {
+        return true;
+    }
+
+    // Last block of the chain whose transactions are in the index
+    const CBlockIndex* indexed{ nullptr };
+    const uint256 bestBlock = index.GetBestBlock();
+    if (bestBlock.IsNull())
+    {
+        const auto migrated = MigrateTxIndex(index, blockTree, chain);
+        if (!migrated.has_value())
+        {
+            return error("%s: Failed to migrate transaction index", __func__);
+        }
+        // The LevelDB index was complete up to the tip
+        if (migrated.value() > 0)
+        {
+            indexed = tip;
+        }
+    }
+    else if (const CBlockIndex* bestIndex = mapBlockIndex.Get(bestBlock))
+    {
+        indexed = chain.FindFork(bestIndex);
+    }
+
+    // Transactions of the genesis block are not indexed
+    const CBlockIndex* pindex = indexed != nullptr ? chain.Next(indexed) : chain[1];
+    if (pindex != nullptr)
+    {
+        LogPrintf("Adding transactions of blocks %d to %d to the compact transaction index...\n",
+            pindex->GetHeight(), tip->GetHeight());
+    }
+    for (; pindex != nullptr; pindex = chain.Next(pindex))
+    {
+        std::vector<CCompactTxIndexEntry> entries{};
+        const int32_t height = pindex->GetHeight();
+        auto offsets = ScanBlockTransactions(*pindex, true,
+            [&entries, height](uint64_t offset, const TxId& txid)
+            {
+                entries.push_back({ CCompactTxIndex::GetTxIdPrefix(txid), height, offset - BLOCK_HEADER_SIZE });
+            });
+        if (!offsets)
+        {
+            return error("%s: Failed to read block %s", __func__, pindex->GetBlockHash().ToString());
+        }
+        if (!index.AddEntries(std::move(entries)))
+        {
+            return false;
+        }
+    }
+
+    if (!index.Flush(tip->GetBlockHash()))
+    {
+        return false;
+    }
+
+    // Entries of the LevelDB index are no longer needed once the compact index
+    // is flushed. They are also removed if the node stopped while removing them.
+    return blockTree.EraseTxIndex();
+}
@@ -0,0 +1,160 @@
+// Copyright (c) 2024 Bitcoin Association
+// Distributed under the Open BSV software license, see the accompanying file LICENSE.
+
+#pragma once
+
+#include "fs.h"
+#include "primitives/transaction.h"
+#include "uint256.h"
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <tuple>
+#include <unordered_map>
+#include <vector>
+
+class CBlock;
+class CBlockIndex;
+class CBlockTreeDB;
+class CChain;
+class CTransaction;
+
+/** Transaction index backends */
+static const std::string TXINDEX_BACKEND_LEVELDB = "leveldb";
+static const std::string TXINDEX_BACKEND_COMPACT = "compact";
+static const std::string DEFAULT_TXINDEX_BACKEND = TXINDEX_BACKEND_LEVELDB;
+
+/** Number of buffered entries after which they are written to a new segment */
+static constexpr size_t DEFAULT_COMPACT_TXINDEX_BUFFER_ENTRIES{ 1024 * 1024 };
+
+/**
+ * Position of a transaction as stored in the compact transaction index: height
+ * of the block in the active chain and the offset of the transaction in the
+ * block after the block header (as in CDiskTxPos).
+ */
+struct CCompactTxIndexEntry
+{
+    uint64_t txIdPrefix;
+    int32_t height;
+    uint64_t txOffset;
+
+    bool operator<(const CCompactTxIndexEntry& other) const
+    {
+        return std::tie(txIdPrefix, height, txOffset) <
+               std::tie(other.txIdPrefix, other.height, other.txOffset);
+    }
+    bool operator==(const CCompactTxIndexEntry& other) const
+    {
+        return txIdPrefix == other.txIdPrefix && height == other.height &&
+               txOffset == other.txOffset;
+    }
+};
+
+/**
+ * Transaction index that stores only an 8 byte prefix of the transaction id
+ * together with the block height and offset of the transaction instead of the
+ * full id and CDiskTxPos in LevelDB.
+ *
+ * A prefix may match several transactions so every candidate is checked by
+ * reading the transaction from disk and comparing its id.
+ *
+ * Entries of connected blocks are buffered in memory and written to immutable
+ * segment files sorted by prefix. Segments of similar size are merged so that
+ * the number of segments that need to be searched stays logarithmic in the
+ * number of entries. The list of segments and the block up to which the index
+ * is complete are kept in a metadata file that is replaced atomically, so the
+ * index remains consistent if the node crashes while writing a segment.
+ *
+ * Entries are never removed when blocks are disconnected. Such entries point
+ * at a different block or a height above the tip and are filtered out by the
+ * transaction id check.
+ */
+class CCompactTxIndex
+{
+public:
+    CCompactTxIndex(
+        const fs::path& dir,
+        bool wipe,
+        size_t bufferEntries = DEFAULT_COMPACT_TXINDEX_BUFFER_ENTRIES);
+    ~CCompactTxIndex();
+
+    CCompactTxIndex(const CCompactTxIndex&) = delete;
+    CCompactTxIndex& operator=(const CCompactTxIndex&) = delete;
+
+    // Add transactions of a block that is being connected at the given height.
+    // Returns false if buffered entries could not be written.
+    bool AddBlock(const CBlock& block, int32_t height);
+
+    // Add entries of transactions of one block.
+    bool AddEntries(std::vector<CCompactTxIndexEntry>&& entries);
+
+    // Persist all added entries and record that the index contains all
+    // transactions of bestBlock and its ancestors.
+    bool Flush(const uint256& bestBlock);
+
+    // Block up to which the index is complete or null if the index is empty.
+    uint256 GetBestBlock() const;
+
+    // Entries of all transactions whose ids start with the same prefix as txid.
+    std::vector<CCompactTxIndexEntry> Find(const TxId& txid) const;
+
+    size_t GetSegmentCount() const;
+
+    static uint64_t GetTxIdPrefix(const TxId& txid);
+
+private:
+    class Segment;
+    using SegmentRef = std::shared_ptr<const Segment>;
+
+    // Write buffered entries to a new segment and merge segments. Returns
+    // false if the buffer was empty. Caller must hold mWriteMutex.
+    bool WriteBuffer();
+    SegmentRef MergeSegments(const SegmentRef& first, const SegmentRef& second);
+    void WriteMetadata() const;
+    void RemoveUnusedFiles() const;
+    fs::path GetSegmentPath(uint64_t id) const;
+
+    const fs::path mDir;
+    const size_t mBufferEntries;
+
+    // Serialises writing of segments and metadata
+    std::mutex mWriteMutex{};
+
+    mutable std::mutex mMutex{};
+    // Entries added since the last segment was written
+    std::unordered_multimap<uint64_t, CCompactTxIndexEntry> mBuffer{};
+    // Sorted entries that are being written to a new segment
+    std::shared_ptr<const std::vector<CCompactTxIndexEntry>> mPending{};
+    // From the oldest (largest) to the newest
+    std::vector<SegmentRef> mSegments{};
+    uint64_t mNextSegmentId{ 0 };
+    uint256 mBestBlock{};
+};
+
+/**
+ * Find transaction txid in the blocks of chain using index. On success tx is
+ * set to the transaction and blockIndex to the block that contains it.
+ *
+ * Caller must hold cs_main.
+ */
+bool FindTransactionInCompactTxIndex(
+    const CCompactTxIndex& index,
+    const CChain& chain,
+    const TxId& txid,
+    CTransactionRef& tx,
+    const CBlockIndex*& blockIndex);
+
+/**
+ * Bring the index up to date with chain: entries of the existing LevelDB
+ * transaction index are migrated if the compact index is empty, after that
+ * transactions of blocks that were connected after the index was last flushed
+ * are added by reading the blocks from disk.
+ *
+ * Caller must hold cs_main.
+ */
+bool SyncCompactTxIndex(CCompactTxIndex& index, CBlockTreeDB& blockTree, const CChain& chain);
+
+/** Compact transaction index, set if -txindex is used with the compact backend */
+extern std::unique_ptr<CCompactTxIndex> pCompactTxIndex;
@@ -0,0 +1,65 @@
+// Copyright (c) 2024 Bitcoin Association
+// Distributed under the Open BSV software license, see the accompanying file LICENSE.
+
+#include "disconnect_data_prefetcher.h"
+
+#include "block_index.h"
+#include "config.h"
+
+BlockDisconnectData ReadBlockDisconnectData(const Config& config, const CBlockIndex& index)
+{
+    auto block = std::make_shared<CBlock>();
+    if (!index.ReadBlockFromDisk(*block, config))
+    {
+        return {};
+    }
+    return { std::move(block), index.GetBlockUndo() };
+}
+
+CDisconnectDataPrefetcher::CDisconnectDataPrefetcher(
+    const Config& config,
+    const CBlockIndex* stopAt,
+    size_t numOfBlocks)
+    : mConfig{ config }
+    , mStopAt{ stopAt }
+    , mNumOfBlocks{ numOfBlocks }
+{}
+
+BlockDisconnectData CDisconnectDataPrefetcher::Get(const CBlockIndex& index)
+{
+    BlockDisconnectData data;
+    if (!mPending.empty() && mPending.front().first == &index)
+    {
+        data = mPending.front().second.get();
+        mPending.pop_front();
+    }
+    else
+    {
+        // Not the block we were reading ahead for, start over from it.
+        // Destroying the futures waits for the reads in progress.
+        mPending.clear();
+        mNext = index.GetPrev();
+        data = ReadBlockDisconnectData(mConfig, index);
+    }
+
+    ReadAhead();
+
+    return data;
+}
+
+void CDisconnectDataPrefetcher::ReadAhead()
+{
+    while (mPending.size() < mNumOfBlocks &&
+           mNext != nullptr && mNext != mStopAt && mNext->GetHeight() > 0 &&
+           mNext->getStatus().hasData())
+    {
+        mPending.emplace_back(
+            mNext,
+            std::async(
+                std::launch::async,
+                ReadBlockDisconnectData,
+                std::cref(mConfig),
+                std::cref(*mNext)));
+        mNext = mNext->GetPrev();
+    }
+}
@@ -0,0 +1,72 @@
+// Copyright (c) 2024 Bitcoin Association
+// Distributed under the Open BSV software license, see the accompanying file LICENSE.
+
+#pragma once
+
+#include "primitives/block.h"
+#include "undo.h"
+
+#include <cstddef>
+#include <deque>
+#include <future>
+#include <memory>
+#include <optional>
+#include <utility>
+
+class CBlockIndex;
+class Config;
+
+// Default number of blocks whose data is read ahead while disconnecting blocks.
+static constexpr size_t DEFAULT_DISCONNECT_PREFETCH_BLOCKS = 2;
+
+/** Block and its undo data, as needed to disconnect the block. */
+struct BlockDisconnectData
+{
+    // nullptr if the block could not be read
+    std::shared_ptr<CBlock> block;
+    // std::nullopt if the undo data could not be read
+    std::optional<CBlockUndo> undo;
+};
+
+BlockDisconnectData ReadBlockDisconnectData(const Config& config, const CBlockIndex& index);
+
+/**
+ * Reads block and undo data (blk?????.dat and rev?????.dat records) of blocks
+ * that are disconnected one after another, from a tip back towards a stop
+ * point, ahead of time. Up to the configured number of blocks are read and
+ * deserialised in parallel in the background while the caller is restoring
+ * coins of the current block.
+ *
+ * The stop point itself and the genesis block are never read as they are not
+ * disconnected. Reading ahead also stops at a block without data (pruned).
+ *
+ * The class is not thread safe, it is meant to be used by the thread that
+ * disconnects the blocks.
+ */
+class CDisconnectDataPrefetcher
+{
+public:
+    CDisconnectDataPrefetcher(
+        const Config& config,
+        const CBlockIndex* stopAt,
+        size_t numOfBlocks = DEFAULT_DISCONNECT_PREFETCH_BLOCKS);
+
+    CDisconnectDataPrefetcher(const CDisconnectDataPrefetcher&) = delete;
+    CDisconnectDataPrefetcher& operator=(const CDisconnectDataPrefetcher&) = delete;
+
+    // Returns data of the block, either read ahead or read now if the block
+    // is not the one that was expected, and continues reading its ancestors.
+    BlockDisconnectData Get(const CBlockIndex& index);
+
+private:
+    void ReadAhead();
+
+    const Config& mConfig;
+    const CBlockIndex* mStopAt;
+    const size_t mNumOfBlocks;
+
+    // Blocks being read, the one that will be disconnected next is at the front.
+    std::deque<std::pair<const CBlockIndex*, std::future<BlockDisconnectData>>> mPending;
+    // Next block to start reading, nullptr if there is nothing more to read.
+    const CBlockIndex* mNext{ nullptr };
+};
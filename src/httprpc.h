@@ -10,6 +10,9 @@
 
 class HTTPRequest;
 
+/** Default for -resttxsubmission */
+static const bool DEFAULT_REST_TX_SUBMISSION = false;
+
 /** Start HTTP RPC subsystem.
  * Precondition; HTTP and RPC has been started.
  */
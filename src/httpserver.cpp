@@ -5,6 +5,8 @@
 #include "httpserver.h"
 #include "chainparamsbase.h"
 #include "config.h"
+#include "httpworkqueue.h"
+#include "metrics.h"
 #include "net/netbase.h"
 #include "rpc/http_protocol.h" // For HTTP status codes
 #include "task_helpers.h"
@@ -16,6 +18,7 @@
 #include <event2/event.h>
 #include <event2/http.h>
 #include <event2/keyvalq_struct.h>
+#include <event2/listener.h>
 #include <event2/thread.h>
 #include <event2/util.h>
 
@@ -28,8 +31,10 @@
 
 #include <cstdio>
 #include <cstdlib>
+#include <atomic>
 #include <cstring>
 #include <future>
+#include <mutex>
 
 /** Maximum size of http request (request line + headers) */
 static const size_t MAX_HEADERS_SIZE = 8192;
@@ -50,20 +55,43 @@ struct HTTPPathHandler {
     HTTPRequestHandler handler;
 };
 
+/**
+ * Event loop thread with its own HTTP server. Each loop accepts connections on
+ * its own listening sockets and parses requests and writes responses of those
+ * connections.
+ */
+struct HTTPEventLoop {
+    struct event_base *base = nullptr;
+    struct evhttp *http = nullptr;
+    //! Bound listening sockets
+    std::vector<evhttp_bound_socket *> boundSockets;
+    //! Event to resume accepting new connections when the work queue is no
+    //! longer full
+    std::unique_ptr<HTTPEvent> resumeAcceptEvent;
+    std::thread thread;
+    std::future<bool> result;
+};
+
 /** HTTP module state */
 
-//! libevent event loop
-static struct event_base *eventBase = 0;
-//! HTTP server
-struct evhttp *eventHTTP = 0;
+//! libevent event loops, the first one also runs the timers of EventBase()
+static std::vector<HTTPEventLoop> eventLoops;
 //! List of subnets to allow RPC connections from
 static std::vector<CSubNet> rpc_allow_subnets;
-//! Work queue for handling longer requests off the event loop thread
+//! Worker threads for handling longer requests off the event loop thread
 static std::unique_ptr<CThreadPool<CQueueAdaptor>> pWorkQueue {nullptr};
+//! Requests waiting for a worker thread, taken out fairly across clients
+static CHTTPWorkQueue workQueue {};
+//! Number of queued requests above which the work queue is full
+static size_t workQueueDepth {DEFAULT_HTTP_WORKQUEUE};
+//! Whether requests are queued rather than rejected when the work queue is full
+static bool workQueueFullQueue {false};
 //! Handlers for (sub)paths
 std::vector<HTTPPathHandler> pathHandlers;
-//! Bound listening sockets
-std::vector<evhttp_bound_socket *> boundSockets;
+//! Protects bound sockets of the event loops and acceptPaused
+static std::mutex csAccept {};
+//! Whether accepting new connections is paused because the work queue is full
+static std::atomic_bool acceptPaused {false};
 
 /** Check if a network address is allowed to access the HTTP server */
 static bool ClientAllowed(const CNetAddr &netaddr) {
@@ -126,6 +154,88 @@ static std::string RequestMethodString(HTTPRequest::RequestMethod m) {
     }
 }
 
+/** Enable or disable accepting new connections on all bound sockets */
+static void SetAcceptEnabled(bool enabled) {
+    for (HTTPEventLoop &loop : eventLoops) {
+        for (evhttp_bound_socket *socket : loop.boundSockets) {
+            evconnlistener *listener = evhttp_bound_socket_get_listener(socket);
+            if (enabled) {
+                evconnlistener_enable(listener);
+            } else {
+                evconnlistener_disable(listener);
+            }
+        }
+    }
+}
+
+/**
+ * Stop accepting new connections while the work queue is full. Connections
+ * that are already open are served one request at a time by evhttp, so only
+ * new connections can add to the queue.
+ */
+static void PauseAccept() {
+    std::lock_guard<std::mutex> lock { csAccept };
+    if (!acceptPaused) {
+        LogPrint(BCLog::HTTP, "Work queue depth exceeded, pausing accepting new connections\n");
+        // Check right away as workers may have emptied the queue before
+        // seeing the pause. The pending timers also keep the event loops
+        // running once they stop listening.
+        struct timeval tv = {0, 0};
+        for (HTTPEventLoop &loop : eventLoops) {
+            loop.resumeAcceptEvent->trigger(&tv);
+        }
+        SetAcceptEnabled(false);
+        acceptPaused = true;
+    }
+}
+
+/** Resume accepting new connections once the work queue is no longer full,
+ * runs on the thread of the given event loop */
+static void ResumeAccept(HTTPEventLoop &eventLoop) {
+    std::lock_guard<std::mutex> lock { csAccept };
+    if (!acceptPaused) {
+        return;
+    }
+    bool listening = std::any_of(eventLoops.begin(), eventLoops.end(),
+        [](const HTTPEventLoop &loop) { return !loop.boundSockets.empty(); });
+    if (!listening || workQueue.Size() < workQueueDepth) {
+        LogPrint(BCLog::HTTP, "Resuming accepting new connections\n");
+        SetAcceptEnabled(true);
+        acceptPaused = false;
+    } else {
+        // Check again later, the pending timer keeps the event loop running
+        struct timeval tv = {0, 100000};
+        eventLoop.resumeAcceptEvent->trigger(&tv);
+    }
+}
+
+/** Record the depth of the work queue at the time a request was queued and
+ * how long the request waited for a worker thread */
+static void CountWorkQueueMetrics(size_t depth, std::chrono::steady_clock::time_point queuedAt) {
+#ifdef COLLECT_METRICS
+    static metrics::Histogram depths {"HTTP_WORK_QUEUE_DEPTH", 1000};
+    static metrics::Histogram waitTimes {"HTTP_WORK_QUEUE_WAIT_TIME_MS", 5000};
+    static metrics::HistogramWriter histogramLogger {"HTTP", std::chrono::milliseconds {10000}, []() {
+        depths.dump();
+        waitTimes.dump();
+    }};
+    depths.count(depth);
+    waitTimes.count(
+        std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now() - queuedAt).count());
+#endif
+}
+
+/** Worker thread task, runs the next request in the work queue */
+static void RunNextRequest() {
+    if (std::optional<CHTTPWorkQueue::Closure> closure = workQueue.Pop()) {
+        (*closure)();
+    }
+    if (acceptPaused && workQueue.Size() < workQueueDepth) {
+        eventLoops.front().resumeAcceptEvent->trigger(nullptr);
+    }
+}
+
 /** HTTP request callback */
 static void http_request_cb(struct evhttp_request *req, void *arg) {
     Config &config = *reinterpret_cast<Config *>(arg);
@@ -168,20 +278,28 @@ static void http_request_cb(struct evhttp_request *req, void *arg) {
 
     // Dispatch to worker thread.
     if (i != iend) {
-        size_t workQueueDepth = std::max(static_cast<size_t>(gArgs.GetArg("-rpcworkqueue", DEFAULT_HTTP_WORKQUEUE)), size_t{1});
-
         assert(pWorkQueue);
-        if(pWorkQueue->getTaskDepth() < workQueueDepth) {
-            auto handleTask = [&config, hreq = std::move(hreq), path, handler = i->handler]()
+        size_t depth = workQueue.Size();
+        if (depth < workQueueDepth || workQueueFullQueue) {
+            CNetAddr peer = hreq->GetPeer();
+            auto handleTask = [&config, hreq = std::move(hreq), path, handler = i->handler,
+                               depth, queuedAt = std::chrono::steady_clock::now()]()
             {
+                CountWorkQueueMetrics(depth, queuedAt);
                 handler(config, hreq.get(), path);
             };
-            make_task(*pWorkQueue, std::move(handleTask));
+            workQueue.Push(peer, std::move(handleTask));
+            make_task(*pWorkQueue, RunNextRequest);
+
+            if (workQueueFullQueue && depth + 1 >= workQueueDepth) {
+                PauseAccept();
+            }
         }
         else {
             LogPrintf("WARNING: request rejected because http work queue depth "
                       "exceeded, it can be increased with the -rpcworkqueue= "
-                      "setting\n");
+                      "setting or requests can be queued with the "
+                      "-rpcworkqueuefull=queue setting\n");
             hreq->WriteReply(HTTP_INTERNAL, "Work queue depth exceeded");
         }
     } else {
@@ -196,8 +314,8 @@ static void http_reject_request_cb(struct evhttp_request *req, void *) {
 }
 
 /** Event dispatcher thread */
-static bool ThreadHTTP(struct event_base *base, struct evhttp *http) {
-    RenameThread("http");
+static bool ThreadHTTP(struct event_base *base, const std::string &name) {
+    RenameThread(name.c_str());
     LogPrint(BCLog::HTTP, "Entering http event loop\n");
     event_base_dispatch(base);
     // Event loop will be interrupted by InterruptHTTPServer()
@@ -205,8 +323,8 @@ static bool ThreadHTTP(struct event_base *base, struct evhttp *http) {
     return event_base_got_break(base) == 0;
 }
 
-/** Bind HTTP server to specified addresses */
-static bool HTTPBindAddresses(struct evhttp *http) {
+/** Get addresses to bind HTTP server to */
+static std::vector<std::pair<std::string, uint16_t>> HTTPBindEndpoints() {
     int defaultPort = gArgs.GetArg("-rpcport", BaseParams().RPCPort());
     std::vector<std::pair<std::string, uint16_t>> endpoints;
 
@@ -234,22 +352,65 @@ static bool HTTPBindAddresses(struct evhttp *http) {
         endpoints.push_back(std::make_pair("0.0.0.0", defaultPort));
     }
 
-    // Bind addresses
-    for (std::vector<std::pair<std::string, uint16_t>>::iterator i =
-             endpoints.begin();
-         i != endpoints.end(); ++i) {
-        LogPrint(BCLog::HTTP, "Binding RPC on address %s port %i\n", i->first,
-                 i->second);
-        evhttp_bound_socket *bind_handle = evhttp_bind_socket_with_handle(
-            http, i->first.empty() ? nullptr : i->first.c_str(), i->second);
+    return endpoints;
+}
+
+/**
+ * Bind a listening socket with SO_REUSEPORT set, so that the listening
+ * sockets of all event loops can be bound to the same address and the kernel
+ * spreads new connections across them.
+ */
+static evhttp_bound_socket *HTTPBindReusePort(HTTPEventLoop &loop,
+                                              const std::string &host,
+                                              uint16_t port) {
+    struct evutil_addrinfo hints = {};
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    hints.ai_flags = EVUTIL_AI_PASSIVE | EVUTIL_AI_ADDRCONFIG;
+    struct evutil_addrinfo *ai = nullptr;
+    if (evutil_getaddrinfo(host.empty() ? nullptr : host.c_str(),
+                           std::to_string(port).c_str(), &hints, &ai) != 0) {
+        return nullptr;
+    }
+    // Listeners of all event loops are enabled and disabled together when the
+    // work queue is full, which may happen on any of the event loop threads.
+    evconnlistener *listener = evconnlistener_new_bind(
+        loop.base, nullptr, nullptr,
+        LEV_OPT_REUSEABLE | LEV_OPT_REUSEABLE_PORT | LEV_OPT_CLOSE_ON_FREE |
+            LEV_OPT_CLOSE_ON_EXEC | LEV_OPT_THREADSAFE,
+        -1, ai->ai_addr, ai->ai_addrlen);
+    evutil_freeaddrinfo(ai);
+    if (!listener) {
+        return nullptr;
+    }
+    evhttp_bound_socket *bind_handle = evhttp_bind_listener(loop.http, listener);
+    if (!bind_handle) {
+        evconnlistener_free(listener);
+    }
+    return bind_handle;
+}
+
+/** Bind HTTP server of an event loop to specified addresses */
+static bool HTTPBindAddresses(
+    HTTPEventLoop &loop,
+    const std::vector<std::pair<std::string, uint16_t>> &endpoints,
+    bool reusePort) {
+    for (const auto &[host, port] : endpoints) {
+        LogPrint(BCLog::HTTP, "Binding RPC on address %s port %i\n", host,
+                 port);
+        evhttp_bound_socket *bind_handle =
+            reusePort ? HTTPBindReusePort(loop, host, port)
+                      : evhttp_bind_socket_with_handle(
+                            loop.http, host.empty() ? nullptr : host.c_str(),
+                            port);
         if (bind_handle) {
-            boundSockets.push_back(bind_handle);
+            loop.boundSockets.push_back(bind_handle);
         } else {
-            LogPrintf("Binding RPC on address %s port %i failed.\n", i->first,
-                      i->second);
+            LogPrintf("Binding RPC on address %s port %i failed.\n", host,
+                      port);
         }
     }
-    return !boundSockets.empty();
+    return !loop.boundSockets.empty();
 }
 
 /** libevent event log callback */
@@ -281,10 +442,21 @@ ev_ssize_t GetMaxBodySizeSafe(uint64_t maxBlockSize)
     return maxBodySize;
 }
 
-bool InitHTTPServer(Config &config) {
-    struct evhttp *http = 0;
-    struct event_base *base = 0;
+/** Free HTTP servers and event bases of all event loops */
+static void FreeEventLoops() {
+    for (HTTPEventLoop &loop : eventLoops) {
+        loop.resumeAcceptEvent.reset();
+        if (loop.http) {
+            evhttp_free(loop.http);
+        }
+        if (loop.base) {
+            event_base_free(loop.base);
+        }
+    }
+    eventLoops.clear();
+}
 
+bool InitHTTPServer(Config &config) {
     if (!InitHTTPAllowList()) return false;
 
     if (gArgs.GetBoolArg("-rpcssl", false)) {
@@ -294,6 +466,17 @@ bool InitHTTPServer(Config &config) {
         return false;
     }
 
+    std::string workQueueFull = gArgs.GetArg("-rpcworkqueuefull", DEFAULT_HTTP_WORKQUEUE_FULL);
+    if (workQueueFull != "reject" && workQueueFull != "queue") {
+        uiInterface.ThreadSafeMessageBox(
+            strprintf("Invalid -rpcworkqueuefull value: %s. Valid are reject "
+                      "and queue.", workQueueFull),
+            "", CClientUIInterface::MSG_ERROR);
+        return false;
+    }
+    workQueueFullQueue = (workQueueFull == "queue");
+    workQueueDepth = std::max(static_cast<size_t>(gArgs.GetArg("-rpcworkqueue", DEFAULT_HTTP_WORKQUEUE)), size_t{1});
+
     // Redirect libevent's logging to our own log
     event_set_log_callback(&libevent_log_cb);
 #if LIBEVENT_VERSION_NUMBER >= 0x02010100
@@ -311,45 +494,52 @@ bool InitHTTPServer(Config &config) {
     evthread_use_pthreads();
 #endif
 
-    // XXX RAII
-    base = event_base_new();
-    if (!base) {
-        LogPrintf("Couldn't create an event_base: exiting\n");
-        return false;
-    }
-
-    /* Create a new evhttp object to handle requests. */
-    // XXX RAII
-    http = evhttp_new(base);
-    if (!http) {
-        LogPrintf("couldn't create evhttp. Exiting.\n");
-        event_base_free(base);
-        return false;
-    }
+    int eventThreads = std::max(static_cast<long>(gArgs.GetArg("-rpceventthreads", DEFAULT_HTTP_EVENT_THREADS)), 1L);
+    std::vector<std::pair<std::string, uint16_t>> endpoints = HTTPBindEndpoints();
+    eventLoops.resize(eventThreads);
+    for (HTTPEventLoop &loop : eventLoops) {
+        // XXX RAII
+        loop.base = event_base_new();
+        if (!loop.base) {
+            LogPrintf("Couldn't create an event_base: exiting\n");
+            FreeEventLoops();
+            return false;
+        }
 
-    evhttp_set_timeout(
-        http, gArgs.GetArg("-rpcservertimeout", DEFAULT_HTTP_SERVER_TIMEOUT));
-    evhttp_set_max_headers_size(http, MAX_HEADERS_SIZE);
-    evhttp_set_max_body_size(http, GetMaxBodySizeSafe(config.GetMaxBlockSize()));
-    evhttp_set_gencb(http, http_request_cb, &config);
+        /* Create a new evhttp object to handle requests. */
+        // XXX RAII
+        loop.http = evhttp_new(loop.base);
+        if (!loop.http) {
+            LogPrintf("couldn't create evhttp. Exiting.\n");
+            FreeEventLoops();
+            return false;
+        }
 
-    // Only POST and OPTIONS are supported, but we return HTTP 405 for the
-    // others
-    evhttp_set_allowed_methods(http,
-                               EVHTTP_REQ_GET | EVHTTP_REQ_POST |
-                                   EVHTTP_REQ_HEAD | EVHTTP_REQ_PUT |
-                                   EVHTTP_REQ_DELETE | EVHTTP_REQ_OPTIONS);
+        evhttp_set_timeout(
+            loop.http, gArgs.GetArg("-rpcservertimeout", DEFAULT_HTTP_SERVER_TIMEOUT));
+        evhttp_set_max_headers_size(loop.http, MAX_HEADERS_SIZE);
+        evhttp_set_max_body_size(loop.http, GetMaxBodySizeSafe(config.GetMaxBlockSize()));
+        evhttp_set_gencb(loop.http, http_request_cb, &config);
+
+        // Only POST and OPTIONS are supported, but we return HTTP 405 for the
+        // others
+        evhttp_set_allowed_methods(loop.http,
+                                   EVHTTP_REQ_GET | EVHTTP_REQ_POST |
+                                       EVHTTP_REQ_HEAD | EVHTTP_REQ_PUT |
+                                       EVHTTP_REQ_DELETE | EVHTTP_REQ_OPTIONS);
+
+        // With more than one event loop every loop listens on all endpoints
+        if (!HTTPBindAddresses(loop, endpoints, eventThreads > 1)) {
+            LogPrintf("Unable to bind any endpoint for RPC server\n");
+            FreeEventLoops();
+            return false;
+        }
 
-    if (!HTTPBindAddresses(http)) {
-        LogPrintf("Unable to bind any endpoint for RPC server\n");
-        evhttp_free(http);
-        event_base_free(base);
-        return false;
+        loop.resumeAcceptEvent = std::make_unique<HTTPEvent>(
+            loop.base, false, [&loop]() { ResumeAccept(loop); });
     }
 
-    eventBase = base;
-    eventHTTP = http;
-    LogPrint(BCLog::HTTP, "Initialized HTTP server\n");
+    LogPrint(BCLog::HTTP, "Initialized HTTP server with %d event threads\n", eventThreads);
 
     int rpcThreads = std::max(static_cast<long>(gArgs.GetArg("-rpcthreads", DEFAULT_HTTP_THREADS)), 1L);
     LogPrintf("HTTP: creating work queue with %d threads\n", rpcThreads);
@@ -358,27 +548,32 @@ bool InitHTTPServer(Config &config) {
     return true;
 }
 
-std::thread threadHTTP;
-std::future<bool> threadResult;
-
 bool StartHTTPServer() {
     LogPrint(BCLog::HTTP, "Starting HTTP server\n");
-    std::packaged_task<bool(event_base *, evhttp *)> task(ThreadHTTP);
-    threadResult = task.get_future();
-    threadHTTP = std::thread(std::move(task), eventBase, eventHTTP);
+    for (size_t i = 0; i < eventLoops.size(); ++i) {
+        HTTPEventLoop &loop = eventLoops[i];
+        std::packaged_task<bool(event_base *, const std::string &)> task(ThreadHTTP);
+        loop.result = task.get_future();
+        loop.thread = std::thread(std::move(task), loop.base,
+                                  i == 0 ? std::string{"http"} : strprintf("http%d", i));
+    }
 
     return true;
 }
 
 void InterruptHTTPServer() {
     LogPrint(BCLog::HTTP, "Interrupting HTTP server\n");
-    if (eventHTTP) {
-        // Unlisten sockets
-        for (evhttp_bound_socket *socket : boundSockets) {
-            evhttp_del_accept_socket(eventHTTP, socket);
+    {
+        std::lock_guard<std::mutex> lock { csAccept };
+        for (HTTPEventLoop &loop : eventLoops) {
+            // Unlisten sockets
+            for (evhttp_bound_socket *socket : loop.boundSockets) {
+                evhttp_del_accept_socket(loop.http, socket);
+            }
+            loop.boundSockets.clear();
+            // Reject requests on current connections
+            evhttp_set_gencb(loop.http, http_reject_request_cb, nullptr);
         }
-        // Reject requests on current connections
-        evhttp_set_gencb(eventHTTP, http_reject_request_cb, nullptr);
     }
 
     if (pWorkQueue)
@@ -390,38 +585,37 @@ void StopHTTPServer() {
     if (pWorkQueue) {
         LogPrint(BCLog::HTTP, "Waiting for HTTP worker threads to exit\n");
         pWorkQueue.reset();
+        // Drop requests that were not handled
+        while (workQueue.Pop()) {}
     }
-    if (eventBase) {
-        LogPrint(BCLog::HTTP, "Waiting for HTTP event thread to exit\n");
-        // Give event loop a few seconds to exit (to send back last RPC
-        // responses), then break it. Before this was solved with
+    if (!eventLoops.empty()) {
+        LogPrint(BCLog::HTTP, "Waiting for HTTP event threads to exit\n");
+        // Give event loops a few seconds to exit (to send back last RPC
+        // responses), then break them. Before this was solved with
         // event_base_loopexit, but that didn't work as expected in at least
         // libevent 2.0.21 and always introduced a delay. In libevent master
         // that appears to be solved, so in the future that solution could be
         // used again (if desirable).
         // (see discussion in https://github.com/bitcoin/bitcoin/pull/6990)
-        if (threadResult.valid() &&
-            threadResult.wait_for(std::chrono::milliseconds(2000)) ==
-                std::future_status::timeout) {
-            LogPrintf("HTTP event loop did not exit within allotted time, "
-                      "sending loopbreak\n");
-            event_base_loopbreak(eventBase);
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(2000);
+        for (HTTPEventLoop &loop : eventLoops) {
+            if (loop.result.valid() &&
+                loop.result.wait_until(deadline) == std::future_status::timeout) {
+                LogPrintf("HTTP event loop did not exit within allotted time, "
+                          "sending loopbreak\n");
+                event_base_loopbreak(loop.base);
+            }
+            if (loop.thread.joinable()) {
+                loop.thread.join();
+            }
         }
-        threadHTTP.join();
-    }
-    if (eventHTTP) {
-        evhttp_free(eventHTTP);
-        eventHTTP = 0;
-    }
-    if (eventBase) {
-        event_base_free(eventBase);
-        eventBase = 0;
     }
+    FreeEventLoops();
     LogPrint(BCLog::HTTP, "Stopped HTTP server\n");
 }
 
 struct event_base *EventBase() {
-    return eventBase;
+    return eventLoops.empty() ? nullptr : eventLoops.front().base;
 }
 
 // this callback is called after successful or failed transmission
@@ -451,7 +645,10 @@ void HTTPEvent::trigger(struct timeval *tv) {
     }
 }
 HTTPRequest::HTTPRequest(struct evhttp_request *_req)
-    : req(_req), replySent(false) {}
+    : req(_req), replySent(false) {
+    evhttp_connection *con = evhttp_request_get_connection(req);
+    base = con ? evhttp_connection_get_base(con) : EventBase();
+}
 HTTPRequest::~HTTPRequest() {
     if (!replySent) {
         // Keep track of whether reply was sent to avoid request leaks
@@ -509,7 +706,7 @@ void HTTPRequest::WriteReply(int nStatus, const std::string &strReply) {
     assert(evb);
     evbuffer_add(evb, strReply.data(), strReply.size());
     HTTPEvent *ev =
-        new HTTPEvent(eventBase, true, std::bind(evhttp_send_reply, req,
+        new HTTPEvent(base, true, std::bind(evhttp_send_reply, req,
                                                  nStatus, (const char *)nullptr,
                                                  (struct evbuffer *)nullptr));
     ev->trigger(0);
@@ -519,7 +716,7 @@ void HTTPRequest::WriteReply(int nStatus, const std::string &strReply) {
 }
 
 void HTTPRequest::StartWritingChunks(int nStatus) {
-    HTTPEvent *ev = new HTTPEvent(eventBase, true, std::bind(evhttp_send_reply_start, req, nStatus, (const char *)nullptr));
+    HTTPEvent *ev = new HTTPEvent(base, true, std::bind(evhttp_send_reply_start, req, nStatus, (const char *)nullptr));
     ev->trigger(nullptr);
 }
 
@@ -528,15 +725,15 @@ void HTTPRequest::WriteReplyChunk(std::string_view strReply) {
     evbuffer_add(evb, strReply.data(), strReply.length());
 
     // Send event to main http thread to send reply message
-    HTTPEvent *ev = new HTTPEvent(eventBase, true, std::bind(evhttp_send_reply_chunk, req, evb));
+    HTTPEvent *ev = new HTTPEvent(base, true, std::bind(evhttp_send_reply_chunk, req, evb));
     ev->trigger(nullptr);
 
-    HTTPEvent *evDel = new HTTPEvent(eventBase, true, std::bind(evbuffer_free, evb));
+    HTTPEvent *evDel = new HTTPEvent(base, true, std::bind(evbuffer_free, evb));
     evDel->trigger(nullptr);
 }
 
 void HTTPRequest::StopWritingChunks() {
-    HTTPEvent *ev = new HTTPEvent(eventBase, true, std::bind(evhttp_send_reply_end, req));
+    HTTPEvent *ev = new HTTPEvent(base, true, std::bind(evhttp_send_reply_end, req));
     ev->trigger(nullptr);
 
     replySent = true;
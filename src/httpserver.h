@@ -10,7 +10,9 @@
 #include <string>
 
 static const int DEFAULT_HTTP_THREADS = 4;
+static const int DEFAULT_HTTP_EVENT_THREADS = 1;
 static const int DEFAULT_HTTP_WORKQUEUE = 16;
+static const std::string DEFAULT_HTTP_WORKQUEUE_FULL = "reject";
 static const int DEFAULT_HTTP_SERVER_TIMEOUT = 30;
 
 struct evhttp_request;
@@ -58,6 +60,8 @@ struct event_base *EventBase();
 class HTTPRequest {
 private:
     struct evhttp_request *req;
+    //! Event loop of the connection, replies must be sent from its thread
+    struct event_base *base;
     bool replySent;
 
 public:
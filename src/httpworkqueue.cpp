@@ -0,0 +1,53 @@
+// Copyright (c) 2024 Bitcoin Association
+// Distributed under the Open BSV software license, see the accompanying file LICENSE.
+
+#include "httpworkqueue.h"
+
+void CHTTPWorkQueue::Push(const CNetAddr& client, Closure&& closure)
+{
+    std::lock_guard<std::mutex> lock { mMtx };
+
+    auto& requests { mRequests[client] };
+    if(requests.empty())
+    {
+        mClients.push_back(client);
+    }
+    requests.push_back(std::move(closure));
+    ++mSize;
+}
+
+std::optional<CHTTPWorkQueue::Closure> CHTTPWorkQueue::Pop()
+{
+    std::lock_guard<std::mutex> lock { mMtx };
+
+    if(mClients.empty())
+    {
+        return std::nullopt;
+    }
+
+    CNetAddr client { std::move(mClients.front()) };
+    mClients.pop_front();
+
+    auto it { mRequests.find(client) };
+    Closure closure { std::move(it->second.front()) };
+    it->second.pop_front();
+    --mSize;
+
+    if(it->second.empty())
+    {
+        mRequests.erase(it);
+    }
+    else
+    {
+        // Client goes to the back of the line for its next request
+        mClients.push_back(std::move(client));
+    }
+
+    return closure;
+}
+
+size_t CHTTPWorkQueue::Size() const
+{
+    std::lock_guard<std::mutex> lock { mMtx };
+    return mSize;
+}
@@ -0,0 +1,45 @@
+// Copyright (c) 2024 Bitcoin Association
+// Distributed under the Open BSV software license, see the accompanying file LICENSE.
+
+#pragma once
+
+#include "net/netaddress.h"
+
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <optional>
+
+/**
+ * HTTP requests waiting for a worker thread.
+ *
+ * Requests are queued per client (peer address, regardless of the port) and
+ * are taken out round-robin across clients, so a client sending a burst of
+ * requests delays its own requests rather than the requests of other clients.
+ * Requests of a single client are taken out in the order they were added.
+ */
+class CHTTPWorkQueue
+{
+  public:
+    using Closure = std::function<void()>;
+
+    // Add a request from the given client
+    void Push(const CNetAddr& client, Closure&& closure);
+
+    // Take the next request out of the queue, std::nullopt if it is empty
+    std::optional<Closure> Pop();
+
+    // Number of queued requests
+    size_t Size() const;
+
+  private:
+    mutable std::mutex mMtx {};
+
+    // Queued requests of each client
+    std::map<CNetAddr, std::deque<Closure>> mRequests {};
+    // Clients with queued requests, the one that is served next is at the front
+    std::deque<CNetAddr> mClients {};
+    size_t mSize {0};
+};
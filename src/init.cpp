@@ -10,14 +10,18 @@
 #include "init.h"
 #include "addrman.h"
 #include "amount.h"
+#include "async_block_data_writer.h"
 #include "block_index_store.h"
 #include "block_index_store_loader.h"
+#include "block_tx_offsets.h"
 #include "chain.h"
 #include "chainparams.h"
+#include "compact_txindex.h"
 #include "compat/sanity.h"
 #include "config.h"
 #include "consensus/validation.h"
 #include "consensus/consensus.h"
+#include "disconnect_data_prefetcher.h"
 #include "double_spend/dsattempt_handler.h"
 #include "fs.h"
 #include "httprpc.h"
@@ -221,6 +225,8 @@ void Shutdown() {
             FlushStateToDisk();
         }
         pcoinsTip.reset();
+        pCompactTxIndex.reset();
+        pBlockDataWriter.reset();
         delete pblocktree;
         pblocktree = nullptr;
     }
@@ -371,6 +377,13 @@ std::string HelpMessage(HelpMessageMode mode, const Config& config) {
         strprintf(
             _("Set database cache size in megabytes (%d to %d, default: %d). The value may be given in megabytes or with unit (B, KiB, MiB, GiB)."),
             nMinDbCache, nMaxDbCache, nDefaultDbCache));
+    strUsage += HelpMessageOpt(
+        "-disconnectprefetchblocks=<n>",
+        strprintf(
+            _("Number of blocks whose block and undo data are read ahead in "
+              "parallel while blocks are being disconnected during reorgs and "
+              "rollbacks (0 = disabled, default: %u)"),
+            DEFAULT_DISCONNECT_PREFETCH_BLOCKS));
 
     strUsage += HelpMessageOpt(
         "-frozentxodbcache=<n>",
@@ -420,6 +433,13 @@ std::string HelpMessage(HelpMessageMode mode, const Config& config) {
                        strprintf(_("Do not keep transactions in the mempool "
                                    "longer than <n> hours (default: %u)"),
                                  DEFAULT_MEMPOOL_EXPIRY));
+    strUsage +=
+        HelpMessageOpt("-mempoolviewmaxage=<n>",
+                       strprintf(_("Allow getrawmempool, getmempoolentry, getmempoolinfo and the REST "
+                                   "mempool requests to return mempool data that is up to <n> "
+                                   "milliseconds old instead of reading the mempool again after every "
+                                   "change (default: %u)"),
+                                 DEFAULT_MEMPOOL_VIEW_MAX_AGE));
     strUsage += HelpMessageOpt("-maxmempoolnonfinal=<n>",
                                strprintf(_("Keep the non-final transaction memory pool "
                                            "below <n> megabytes (default: %u). The value may be given in megabytes or with unit (B, KiB, MiB, GiB)."),
@@ -563,6 +583,19 @@ std::string HelpMessage(HelpMessageMode mode, const Config& config) {
         "-txindex", strprintf(_("Maintain a full transaction index, used by "
                                 "the getrawtransaction rpc call (default: %d)"),
                               DEFAULT_TXINDEX));
+    strUsage += HelpMessageOpt(
+        "-txindexbackend=<backend>", strprintf(_("Storage of the transaction index: '%s' stores full "
+        "transaction ids and positions in the block index database, '%s' stores 8 byte transaction id "
+        "prefixes with block heights in sorted files in the blocks/txindex directory, which takes about a "
+        "third of the space. Switching to '%s' migrates the existing index, switching back requires "
+        "-reindex-chainstate (default: %s)"),
+        TXINDEX_BACKEND_LEVELDB, TXINDEX_BACKEND_COMPACT, TXINDEX_BACKEND_COMPACT, DEFAULT_TXINDEX_BACKEND));
+    strUsage += HelpMessageOpt(
+        "-blocktxoffsets=<n>", strprintf(_("Write a transaction offsets file next to the block files "
+        "for every block with at least <n> transactions. It is used to read a transaction or a range of "
+        "transactions of the block without parsing the whole block, for example by the getrawtransaction "
+        "rpc call with a block hash and the REST block transactions interface. 0 disables writing of the "
+        "files (default: %u)"), DEFAULT_BLOCK_TX_OFFSETS_FILE_MIN_TXS));
     strUsage += HelpMessageOpt(
         "-maxmerkletreediskspace", strprintf(_("Maximum disk size in bytes that "
         "can be taken by stored merkle trees. This size should not be less than default size "
@@ -853,6 +886,19 @@ std::string HelpMessage(HelpMessageMode mode, const Config& config) {
     strUsage += HelpMessageOpt("-zmqpubremovedfrommempoolblock=<address>",
                                _("Enable publish removal of transaction (txid and the reason in json format) in <address>. "
                                "For more information see doc/zmq.md."));
+    strUsage += HelpMessageOpt("-zmqpubmempooldelta=<address>",
+                               _("Enable publish of sequence numbered mempool additions and removals in binary format in <address>. "
+                               "For more information see doc/zmq.md."));
+    strUsage += HelpMessageOpt("-zmqtopicqueuesize=<topic>:<n>",
+                               strprintf(_("Maximal memory that messages of a topic waiting to be published can take, in megabytes "
+                               "(default: %u). Can be specified multiple times for different topics."),
+                               CZMQPublisher::DEFAULT_TOPIC_QUEUE_SIZE));
+    strUsage += HelpMessageOpt("-zmqtopicqueuepolicy=<topic>:<policy>",
+                               strprintf(_("What to do with a new message of a topic when its queue is full: block (wait until "
+                               "there is room), drop (drop the new message) or coalesce (drop the oldest queued messages of the topic) "
+                               "(default: %s). Dropped messages show as gaps in sequence numbers. Can be specified multiple times "
+                               "for different topics."),
+                               CZMQPublisher::QueuePolicyToString(CZMQPublisher::DEFAULT_TOPIC_QUEUE_POLICY)));
     strUsage += HelpMessageOpt("-zmqpubhashtx2=<address>",
                        _("Enable publish hash transaction in <address>. "
                        "For more information see doc/zmq.md."));
@@ -1274,6 +1320,12 @@ std::string HelpMessage(HelpMessageMode mode, const Config& config) {
     strUsage += HelpMessageOpt(
         "-rest", strprintf(_("Accept public REST requests (default: %d)"),
                            DEFAULT_REST_ENABLE));
+    strUsage += HelpMessageOpt(
+        "-resttxsubmission",
+        strprintf(_("Accept transactions submitted with POST /rest/txs when "
+                    "REST requests are accepted. REST requests are not "
+                    "authenticated (default: %d)"),
+                  DEFAULT_REST_TX_SUBMISSION));
     strUsage += HelpMessageOpt(
         "-rpcbind=<addr>",
         _("Bind to given address to listen for JSON-RPC connections. Use "
@@ -1315,6 +1367,14 @@ std::string HelpMessage(HelpMessageMode mode, const Config& config) {
         strprintf(
             _("Set the number of threads to service RPC calls (default: %d)"),
             DEFAULT_HTTP_THREADS));
+    strUsage += HelpMessageOpt(
+        "-rpceventthreads=<n>",
+        strprintf(
+            _("Set the number of threads accepting RPC connections and "
+              "reading requests and writing responses of those connections. "
+              "With more than one thread the RPC listening sockets are bound "
+              "with SO_REUSEPORT (default: %d)"),
+            DEFAULT_HTTP_EVENT_THREADS));
     strUsage += HelpMessageOpt(
         "-rpccorsdomain=value",
         "Domain from which to accept cross origin requests (browser enforced)");
@@ -1326,6 +1386,14 @@ std::string HelpMessage(HelpMessageMode mode, const Config& config) {
             "-rpcworkqueue=<n>", strprintf("Set the depth of the work queue to "
                                            "service RPC calls (default: %d)",
                                            DEFAULT_HTTP_WORKQUEUE));
+        strUsage += HelpMessageOpt(
+            "-rpcworkqueuefull=<policy>",
+            strprintf("What to do with RPC calls when the work queue is full: "
+                      "reject them or queue them and stop accepting new RPC "
+                      "connections until the queue depth drops below "
+                      "-rpcworkqueue. Queued calls are served round-robin "
+                      "across client addresses (reject, queue, default: %s)",
+                      DEFAULT_HTTP_WORKQUEUE_FULL));
         strUsage += HelpMessageOpt(
             "-rpcservertimeout=<n>",
             strprintf("Timeout during HTTP requests (default: %d)",
@@ -2036,6 +2104,11 @@ bool AppInitParameterInteraction(ConfigInit &config) {
             return InitError(_("Prune mode is incompatible with -txindex."));
     }
 
+    const std::string txIndexBackend = gArgs.GetArg("-txindexbackend", DEFAULT_TXINDEX_BACKEND);
+    if (txIndexBackend != TXINDEX_BACKEND_LEVELDB && txIndexBackend != TXINDEX_BACKEND_COMPACT) {
+        return InitError(strprintf(_("Unknown -txindexbackend: '%s'"), txIndexBackend));
+    }
+
     // Make sure enough file descriptors are available
     const int nBind = std::max(
         (gArgs.IsArgSet("-bind") ? gArgs.GetArgs("-bind").size() : 0) +
@@ -3038,6 +3111,15 @@ bool AppInitParameterInteraction(ConfigInit &config) {
             return InitError(err);
     }
 
+    {
+        const int64_t blockTxOffsetsMinTxs = gArgs.GetArg("-blocktxoffsets", DEFAULT_BLOCK_TX_OFFSETS_FILE_MIN_TXS);
+        if (blockTxOffsetsMinTxs < 0)
+        {
+            return InitError(_("-blocktxoffsets must not be negative"));
+        }
+        SetBlockTxOffsetsFileMinTxs(static_cast<uint64_t>(blockTxOffsetsMinTxs));
+    }
+
     const uint64_t value = gArgs.GetArg("-maxprotocolrecvpayloadlength", DEFAULT_MAX_PROTOCOL_RECV_PAYLOAD_LENGTH);
     if (std::string err; !config.SetMaxProtocolRecvPayloadLength(value, &err))
     {
@@ -3464,6 +3546,7 @@ bool AppInitMain(ConfigInit &config, boost::thread_group &threadGroup,
 
     fReindex = gArgs.GetBoolArg("-reindex", false);
     bool fReindexChainState = gArgs.GetBoolArg("-reindex-chainstate", false);
+    const std::string txIndexBackend = gArgs.GetArg("-txindexbackend", DEFAULT_TXINDEX_BACKEND);
 
     // cache size calculations
     int64_t nTotalCache = gArgs.GetArgAsBytes("-dbcache", nDefaultDbCache, ONE_MEBIBYTE);
@@ -3522,10 +3605,13 @@ bool AppInitMain(ConfigInit &config, boost::thread_group &threadGroup,
             try {
                 UnloadBlockIndex();
                 pcoinsTip.reset();
+                pCompactTxIndex.reset();
+                pBlockDataWriter.reset();
                 delete pblocktree;
 
                 pblocktree =
                     new CBlockTreeDB(nBlockTreeDBCache, false, fReindex);
+                pBlockDataWriter = std::make_unique<CAsyncBlockDataWriter>(*pblocktree, chainparams.DiskMagic());
                 pMerkleTreeFactory = std::make_unique<CMerkleTreeFactory>(GetDataDir() / "merkle", static_cast<size_t>(nMerkleTreeIndexDBCache), GetMaxNumberOfMerkleTreeThreads());
                 pcoinsTip =
                     std::make_unique<CoinsDB>(
@@ -3578,6 +3664,20 @@ bool AppInitMain(ConfigInit &config, boost::thread_group &threadGroup,
                     break;
                 }
 
+                // The LevelDB transaction index is removed when it is migrated
+                // to the compact one so it can't be used any more
+                const bool useCompactTxIndex = fTxIndex && txIndexBackend == TXINDEX_BACKEND_COMPACT;
+                if (fReindex || fReindexChainState) {
+                    pblocktree->WriteFlag("compacttxindex", useCompactTxIndex);
+                }
+                bool fCompactTxIndex = false;
+                pblocktree->ReadFlag("compacttxindex", fCompactTxIndex);
+                if (fTxIndex && fCompactTxIndex && !useCompactTxIndex) {
+                    strLoadError = _("You need to rebuild the database using "
+                                     "-reindex-chainstate to change -txindexbackend");
+                    break;
+                }
+
                 // Check for changed -prune state.  What we are concerned about
                 // is a user who has pruned blocks in the past, but is now
                 // trying to run unpruned.
@@ -3611,6 +3711,21 @@ bool AppInitMain(ConfigInit &config, boost::thread_group &threadGroup,
                     }
                 }
 
+                // Created after the chain tip is final so that the index is
+                // not flushed with a tip whose transactions were not added
+                if (useCompactTxIndex) {
+                    uiInterface.InitMessage(_("Updating transaction index..."));
+                    pCompactTxIndex = std::make_unique<CCompactTxIndex>(
+                        GetDataDir() / "blocks" / "txindex", fReindex || fReindexChainState);
+                    pblocktree->WriteFlag("compacttxindex", true);
+
+                    LOCK(cs_main);
+                    if (!SyncCompactTxIndex(*pCompactTxIndex, *pblocktree, chainActive)) {
+                        strLoadError = _("Error updating the transaction index");
+                        break;
+                    }
+                }
+
                 uiInterface.InitMessage(_("Verifying blocks..."));
                 if (fHavePruned &&
                     gArgs.GetArg("-checkblocks", DEFAULT_CHECKBLOCKS) >
@@ -5,6 +5,8 @@
 #include "task_helpers.h"
 #include "blockstreams.h"
 
+#include <unordered_set>
+
 CMerkleTree::CMerkleTree(const std::vector<CTransactionRef>& transactions, const uint256& blockHashIn, int32_t blockHeightIn, CThreadPool<CQueueAdaptor>* pThreadPool)
     : numberOfLeaves(transactions.size()), blockHash(blockHashIn), blockHeight(blockHeightIn)
 {
@@ -342,6 +344,30 @@ CMerkleTree::MerkleProof CMerkleTree::GetMerkleProof(size_t transactionIndex, bo
     return merkleProof;
 }
 
+std::unordered_map<TxId, size_t, std::hash<TxId>> CMerkleTree::GetTransactionIndices(const std::vector<TxId>& transactionIds) const
+{
+    std::unordered_map<TxId, size_t, std::hash<TxId>> transactionIndices;
+    if (merkleTreeLevelsWithNodeHashes.empty() || transactionIds.empty())
+    {
+        return transactionIndices;
+    }
+
+    // Requested transaction ids that were not yet found
+    std::unordered_set<TxId, std::hash<TxId>> remainingTxIds(transactionIds.cbegin(), transactionIds.cend());
+    transactionIndices.reserve(remainingTxIds.size());
+    const std::vector<uint256>& leaves = merkleTreeLevelsWithNodeHashes[0];
+    for (size_t index = 0; index < leaves.size() && !remainingTxIds.empty(); ++index)
+    {
+        auto found = remainingTxIds.find(TxId(leaves[index]));
+        if (found != remainingTxIds.end())
+        {
+            transactionIndices.emplace(*found, index);
+            remainingTxIds.erase(found);
+        }
+    }
+    return transactionIndices;
+}
+
 uint64_t CMerkleTree::GetSizeInBytes() const
 {
     uint64_t numberOfNodes = 0;
@@ -7,6 +7,7 @@
 #include "consensus/consensus.h"
 #include "primitives/transaction.h"
 #include <future>
+#include <unordered_map>
 
 /*
     Class MerkleTree allows incremental construction and parallel calculation of a
@@ -237,6 +238,14 @@ public:
      */
     MerkleProof GetMerkleProof(size_t transactionIndex, bool skipDuplicates) const;
 
+    /**
+     * Returns indices in this tree/block of those given transaction ids that are found in it.
+     * All transaction ids are looked up in a single pass over the leaves, so this should be
+     * used instead of GetMerkleProof(const TxId&, bool) when proofs of many transactions
+     * from the same block are needed.
+     */
+    std::unordered_map<TxId, size_t, std::hash<TxId>> GetTransactionIndices(const std::vector<TxId>& transactionIds) const;
+
     /*
      * Returns size of Merkle Tree in bytes by calculating number of all hashes stored
      * multiplied by 32 bytes (uint256).
@@ -58,6 +58,7 @@
 #include <chrono>
 #include <exception>
 #include <memory>
+#include <mutex>
 #include <optional>
 #include <shared_mutex>
 
@@ -79,7 +80,10 @@ namespace {
 /** Number of nodes with fSyncStarted. */
 std::atomic<int> nSyncStarted = 0;
 
+/** Chain tip at the last reset of recent rejects, protected by
+ * cs_recentRejectsChainTip. */
 uint256 hashRecentRejectsChainTip;
+std::mutex cs_recentRejectsChainTip;
 
 /** Track blocks in flight and where they're coming from */
 BlockDownloadTracker blockDownloadTracker {};
@@ -87,12 +91,15 @@ BlockDownloadTracker blockDownloadTracker {};
 /** Number of preferable block download peers. */
 std::atomic<int> nPreferredDownload = 0;
 
-/** Relay map, protected by cs_main. */
+/** Relay map, protected by cs_mapRelay. */
 typedef std::map<uint256, CTransactionRef> MapRelay;
 MapRelay mapRelay;
 /** Expiration-time ordered list of (expire time, relay map entry) pairs,
- * protected by cs_main). */
+ * protected by cs_mapRelay). */
 std::deque<std::pair<int64_t, MapRelay::iterator>> vRelayExpiration;
+/** Guards mapRelay and vRelayExpiration so that transaction getdata requests
+ * can be served without cs_main. */
+std::mutex cs_mapRelay;
 } // namespace
 
 //////////////////////////////////////////////////////////////////////////////
@@ -253,10 +260,14 @@ void FinalizeNode(NodeId nodeid, bool &fUpdateConnectionTime)
     blockDownloadTracker.ClearPeer(nodeid, state, lastPeer);
 }
 
-/** Check whether the last unknown block a peer advertised is not yet known. */
+/**
+ * Check whether the last unknown block a peer advertised is not yet known.
+ *
+ * Only touches the node state (locked by the caller through CNodeStateRef) and
+ * the block index store (internally locked) so cs_main is not required.
+ */
 void ProcessBlockAvailability(const CNodeStatePtr& state) {
 
-    AssertLockHeld(cs_main);
     assert(state);
 
     if (!state->hashLastUnknownBlock.IsNull()) {
@@ -275,10 +286,13 @@ void ProcessBlockAvailability(const CNodeStatePtr& state) {
     }
 }
 
-/** Update tracking information about which blocks a peer is assumed to have. */
+/**
+ * Update tracking information about which blocks a peer is assumed to have.
+ *
+ * Same locking requirements as ProcessBlockAvailability().
+ */
 void UpdateBlockAvailability(const uint256 &hash, const CNodeStatePtr& state) {
 
-    AssertLockHeld(cs_main);
     assert(state);
 
     ProcessBlockAvailability(state);
@@ -926,16 +940,19 @@ bool AlreadyHave(const CInv &inv) {
 
 bool IsTxnKnown(const CInv &inv) {
     if (MSG_TX == inv.type) {
-        const uint256& activeTipBlockHash {
-            chainActive.Tip()->GetBlockHash()
-        };
-        if (activeTipBlockHash != hashRecentRejectsChainTip) {
-            // If the chain tip has changed previously rejected transactions
-            // might be now valid, e.g. due to a nLockTime'd tx becoming
-            // valid, or a double-spend. Reset the rejects filter and give
-            // those txs a second chance.
-            hashRecentRejectsChainTip = activeTipBlockHash;
-            g_connman->ResetRecentRejects();
+        {
+            const uint256& activeTipBlockHash {
+                chainActive.Tip()->GetBlockHash()
+            };
+            std::lock_guard lock { cs_recentRejectsChainTip };
+            if (activeTipBlockHash != hashRecentRejectsChainTip) {
+                // If the chain tip has changed previously rejected transactions
+                // might be now valid, e.g. due to a nLockTime'd tx becoming
+                // valid, or a double-spend. Reset the rejects filter and give
+                // those txs a second chance.
+                hashRecentRejectsChainTip = activeTipBlockHash;
+                g_connman->ResetRecentRejects();
+            }
         }
         // Use pcoinsTip->HaveCoinInCache as a quick approximation to
         // exclude requesting or processing some txs which have already been
@@ -1160,8 +1177,8 @@ static void ProcessGetData(const Config &config, const CNodePtr& pfrom,
     std::vector<CInv> vNotFound;
     const CNetMsgMaker msgMaker(pfrom->GetSendVersion());
 
-    LOCK(cs_main);
-
+    // cs_main is only taken while serving block requests; transaction and
+    // dataref requests are served from structures that have their own locks.
     while (it != pfrom->vRecvGetData.end()) {
         // Don't bother if send buffer is too full to respond anyway.
         if (pfrom->GetPausedForSending()) {
@@ -1178,6 +1195,7 @@ static void ProcessGetData(const Config &config, const CNodePtr& pfrom,
 
             if (inv.type == MSG_BLOCK || inv.type == MSG_FILTERED_BLOCK ||
                 inv.type == MSG_CMPCT_BLOCK) {
+                LOCK(cs_main);
                 bool send = false;
                 auto index = mapBlockIndex.Get(inv.hash);
                 const auto& bestHeader = mapBlockIndex.GetBestHeader();
@@ -1372,11 +1390,17 @@ static void ProcessGetData(const Config &config, const CNodePtr& pfrom,
             } else if (inv.type == MSG_TX) {
                 // Send stream from relay memory
                 bool push = false;
-                auto mi = mapRelay.find(inv.hash);
-                if (mi != mapRelay.end()) {
+                CTransactionRef relayTx {};
+                {
+                    std::lock_guard lock { cs_mapRelay };
+                    if (auto mi = mapRelay.find(inv.hash); mi != mapRelay.end()) {
+                        relayTx = mi->second;
+                    }
+                }
+                if (relayTx) {
                     connman.PushMessage(
                         pfrom,
-                        msgMaker.Make(NetMsgType::TX, *mi->second));
+                        msgMaker.Make(NetMsgType::TX, *relayTx));
                     push = true;
                 } else if (pfrom->timeLastMempoolReq) {
                     auto txinfo = mempool.Info(inv.hash);
@@ -2410,7 +2434,9 @@ static void ProcessInvMessage(const CNodePtr& pfrom,
         fBlocksOnly = false;
     }
 
-    LOCK(cs_main);
+    // No cs_main here; block availability is tracked under the node state
+    // lock and the block index store is internally locked, so inv processing
+    // doesn't serialise against block connection.
     for(size_t nInv = 0; nInv < vInv.size(); nInv++) {
         CInv &inv = vInv[nInv];
 
@@ -2436,7 +2462,7 @@ static void ProcessInvMessage(const CNodePtr& pfrom,
                 connman.PushMessage(
                     pfrom,
                     msgMaker.Make(NetMsgType::GETHEADERS,
-                                  chainActive.GetLocator(&bestHeader),
+                                  GetBlockIndexLocator(bestHeader),
                                   inv.hash));
                 LogPrint(BCLog::NETMSG, "getheaders (%d) %s to peer=%d\n",
                          bestHeader.GetHeight(), inv.hash.ToString(),
@@ -3365,7 +3391,8 @@ static bool ProcessHeadersMessage(const Config& config,
 
     const CBlockIndex *pindexLast = nullptr;
     {
-        LOCK(cs_main);
+        // Nothing in here needs cs_main: the block index store is internally
+        // locked and the node state is locked through CNodeStateRef.
 
         // If this looks like it could be a block announcement (nCount <
         // MAX_BLOCKS_TO_ANNOUNCE), use special logic for handling headers
@@ -3390,7 +3417,7 @@ static bool ProcessHeadersMessage(const Config& config,
             connman.PushMessage(
                 pfrom,
                 msgMaker.Make(NetMsgType::GETHEADERS,
-                              chainActive.GetLocator(&bestHeader),
+                              GetBlockIndexLocator(bestHeader),
                               uint256()));
             LogPrint(BCLog::NETMSG, "received header %s: missing prev block "
                                  "%s, sending getheaders (%d) to end "
@@ -3442,7 +3469,6 @@ static bool ProcessHeadersMessage(const Config& config,
     }
 
     {
-        LOCK(cs_main);
         // Try to obtain an access to the node's state data.
         const CNodeStateRef nodestateRef { GetState(pfrom->GetId()) };
         const CNodeStatePtr& nodestate { nodestateRef.get() };
@@ -3470,9 +3496,22 @@ static bool ProcessHeadersMessage(const Config& config,
             connman.PushMessage(
                 pfrom,
                 msgMaker.Make(NetMsgType::GETHEADERS,
-                              chainActive.GetLocator(pindexLast),
+                              GetBlockIndexLocator(*pindexLast),
                               uint256()));
         }
+    }
+
+    // Only direct fetching needs a consistent view of the active chain. Cheap
+    // pre-check on the (atomic) tip first so that the common case of headers
+    // that don't beat our tip never touches cs_main.
+    if(pindexLast->IsValid(BlockValidity::TREE) &&
+        chainActive.Tip()->GetChainWork() <= pindexLast->GetChainWork())
+    {
+        LOCK(cs_main);
+        // Try to obtain an access to the node's state data.
+        const CNodeStateRef nodestateRef { GetState(pfrom->GetId()) };
+        const CNodeStatePtr& nodestate { nodestateRef.get() };
+        assert(nodestate);
 
         bool fCanDirectFetch = CanDirectFetch(chainparams.GetConsensus());
         // If this set of headers is valid and ends in a block with at least
@@ -5349,6 +5388,7 @@ void SendTxnInventory(const Config &config, const CNodePtr& pto, CConnman &connm
         }
 
         // Expire old relay messages
+        std::lock_guard lock { cs_mapRelay };
         while(!vRelayExpiration.empty() && vRelayExpiration.front().first < nNow)
         {
             mapRelay.erase(vRelayExpiration.front().second);
@@ -93,3 +93,16 @@ DisconnectResult ProcessingBlockIndex::DisconnectBlock(const CBlock &block,
             view,
             shutdownToken );
 }
+
+DisconnectResult ProcessingBlockIndex::DisconnectBlock(const CBlockUndo &blockUndo,
+                                        const CBlock &block,
+                                        CCoinsViewCache &view,
+                                        const task::CCancellationToken& shutdownToken) const
+{
+    return
+        ApplyBlockUndo(
+            blockUndo,
+            block,
+            view,
+            shutdownToken );
+}
@@ -19,6 +19,13 @@ public:
         CCoinsViewCache& view,
         const task::CCancellationToken& shutdownToken) const;
 
+    // Same as above but with undo data that was already read from disk
+    DisconnectResult DisconnectBlock(
+        const CBlockUndo& blockUndo,
+        const CBlock& block,
+        CCoinsViewCache& view,
+        const task::CCancellationToken& shutdownToken) const;
+
 private:
 
     DisconnectResult ApplyBlockUndo(
@@ -4,12 +4,16 @@
 // file COPYING or http://www.opensource.org/licenses/mit-license.php.
 
 #include "block_index_store.h"
+#include "block_tx_offsets.h"
 #include "chain.h"
 #include "config.h"
+#include "httprpc.h"
 #include "httpserver.h"
 #include "core_io.h"
 #include "merkletreestore.h"
+#include "net/net.h"
 #include "primitives/transaction.h"
+#include "rawtxvalidator.h"
 #include "rpc/blockchain.h"
 #include "rpc/http_protocol.h"
 #include "rpc/jsonwriter.h"
@@ -19,12 +23,17 @@
 #include "sync.h"
 #include "txdb.h"
 #include "txmempool.h"
+#include "txn_validator.h"
+#include "util.h"
 #include "utilstrencodings.h"
 #include "validation.h"
 #include "version.h"
 #include <boost/algorithm/string.hpp>
 #include <univalue.h>
 
+#include <future>
+#include <unordered_set>
+
 // Allow a max of 15 outpoints to be queried at once.
 static const size_t MAX_GETUTXOS_OUTPOINTS = 15;
 
@@ -378,8 +387,271 @@ static bool rest_block(const Config &config, HTTPRequest *req,
     return true;
 }
 
+// Parses a Range header value of the form "bytes=<first>-[<last>]" or
+// "bytes=-<suffix length>" for data of the given size. Returns false if the
+// range is malformed, otherwise length is set to 0 if the range does not
+// overlap the data.
+static bool ParseByteRange(const std::string &rangeHeader, uint64_t dataSize,
+                           uint64_t &offset, uint64_t &length) {
+    const std::string prefix = "bytes=";
+    if (rangeHeader.compare(0, prefix.size(), prefix) != 0) {
+        return false;
+    }
+    const std::string range = rangeHeader.substr(prefix.size());
+    const std::string::size_type delimiterPos = range.find('-');
+    if (delimiterPos == std::string::npos) {
+        return false;
+    }
+
+    if (delimiterPos == 0) {
+        uint64_t suffixLength;
+        if (!ParseUInt64(range.substr(1), &suffixLength)) {
+            return false;
+        }
+        length = std::min(suffixLength, dataSize);
+        offset = dataSize - length;
+        return true;
+    }
+
+    uint64_t first;
+    if (!ParseUInt64(range.substr(0, delimiterPos), &first)) {
+        return false;
+    }
+    uint64_t last = std::numeric_limits<uint64_t>::max();
+    const std::string lastStr = range.substr(delimiterPos + 1);
+    if (!lastStr.empty() && !ParseUInt64(lastStr, &last)) {
+        return false;
+    }
+    if (first > last) {
+        return false;
+    }
+
+    offset = first;
+    length = first >= dataSize ? 0 : std::min(last, dataSize - 1) - first + 1;
+    return true;
+}
+
+// Reads exactly size bytes from the stream
+static std::vector<uint8_t> ReadFromStream(CForwardReadonlyStream &stream,
+                                           size_t size) {
+    std::vector<uint8_t> data;
+    data.reserve(size);
+    while (data.size() < size) {
+        if (stream.EndOfStream()) {
+            throw block_parse_error("Unexpected end of block data");
+        }
+        const CSpan chunk = stream.Read(size - data.size());
+        data.insert(data.end(), chunk.Begin(), chunk.Begin() + chunk.Size());
+    }
+    return data;
+}
+
+/**
+ * Handles /rest/block/<hash>/txs/<start>/<count> and /rest/block/<hash>/txids.
+ *
+ * Transactions are read directly from their position in the block data on
+ * disk using the block's transaction offsets, so only the requested part of
+ * the block is read.
+ */
+static bool rest_block_transactions(const Config &config, HTTPRequest *req,
+                                    const std::string &strURIPart) {
+    if (!CheckWarmup(req)) {
+        return false;
+    }
+
+    std::string param;
+    const RetFormat rf = ParseDataFormat(param, strURIPart);
+
+    std::vector<std::string> path;
+    boost::split(path, param, boost::is_any_of("/"));
+
+    const bool isTxIds = path.size() == 2 && path[1] == "txids";
+    const bool isTxs = path.size() == 4 && path[1] == "txs";
+    if (!isTxIds && !isTxs) {
+        return RESTERR(req, HTTP_BAD_REQUEST,
+                       "Invalid URI format. Expected "
+                       "/rest/block/<hash>/txs/<start>/<count>.<ext> or "
+                       "/rest/block/<hash>/txids.<ext>");
+    }
+
+    const std::string &hashStr = path[0];
+    uint256 hash;
+    if (!ParseHashStr(hashStr, hash)) {
+        return RESTERR(req, HTTP_BAD_REQUEST, "Invalid hash: " + hashStr);
+    }
+
+    uint64_t start {0};
+    uint64_t count {0};
+    if (isTxs && (!ParseUInt64(path[2], &start) || !ParseUInt64(path[3], &count) || count == 0)) {
+        return RESTERR(req, HTTP_BAD_REQUEST,
+                       "Invalid transaction range: " + path[2] + "/" + path[3]);
+    }
+
+    if (rf != RF_BINARY && rf != RF_HEX && rf != RF_JSON) {
+        return RESTERR(req, HTTP_NOT_FOUND,
+                       "output format not found (available: " +
+                           AvailableDataFormatsString() + ")");
+    }
+
+    const CBlockIndex *pblockindex = mapBlockIndex.Get(hash);
+    if (!pblockindex) {
+        return RESTERR(req, HTTP_NOT_FOUND, hashStr + " not found");
+    }
+
+    if (fHavePruned && !pblockindex->getStatus().hasData() &&
+        pblockindex->GetBlockTxCount() > 0) {
+        return RESTERR(req, HTTP_NOT_FOUND,
+                       hashStr + " not available (pruned data)");
+    }
+
+    if (isTxIds) {
+        CHttpTextWriter httpWriter(*req);
+        std::optional<CJSONWriter> jWriter {};
+        bool started {false};
+        auto writeTxId = [&](uint64_t, const TxId &txid) {
+            if (!started) {
+                req->WriteHeader("Content-Type",
+                                 rf == RF_BINARY ? "application/octet-stream"
+                                 : rf == RF_HEX  ? "text/plain"
+                                                 : "application/json");
+                req->StartWritingChunks(HTTP_OK);
+                if (rf == RF_JSON) {
+                    jWriter.emplace(httpWriter, false);
+                    jWriter->writeBeginArray();
+                }
+                started = true;
+            }
+            switch (rf) {
+                case RF_BINARY:
+                    httpWriter.Write(std::string(txid.begin(), txid.end()));
+                    break;
+                case RF_HEX:
+                    httpWriter.Write(HexStr(txid.begin(), txid.end()));
+                    break;
+                default:
+                    jWriter->pushV(txid.GetHex());
+                    break;
+            }
+        };
+
+        if (!ScanBlockTransactions(*pblockindex, true, writeTxId)) {
+            if (!started) {
+                return RESTERR(req, HTTP_NOT_FOUND, hashStr + " not found on disk");
+            }
+            // Headers were already sent, all we can do is end the reply
+            LogPrintf("Error streaming transaction ids of block %s\n", hashStr);
+        }
+        if (jWriter) {
+            jWriter->writeEndArray();
+        }
+        if (rf != RF_BINARY) {
+            httpWriter.WriteLine();
+        }
+        httpWriter.Flush();
+        req->StopWritingChunks();
+        return true;
+    }
+
+    const auto offsets = GetBlockTxOffsets(*pblockindex);
+    if (!offsets) {
+        return RESTERR(req, HTTP_NOT_FOUND, hashStr + " not found on disk");
+    }
+    if (start >= offsets->GetTxCount()) {
+        return RESTERR(req, HTTP_BAD_REQUEST,
+                       strprintf("Start %d is beyond the number of transactions in the block (%d)",
+                                 start, offsets->GetTxCount()));
+    }
+    count = std::min<uint64_t>(count, offsets->GetTxCount() - start);
+    const auto [sliceOffset, sliceSize] = offsets->GetTxRange(start, count);
+
+    try {
+        switch (rf) {
+            case RF_BINARY: {
+                uint64_t offset {0};
+                uint64_t length {sliceSize};
+                const auto rangeHeader = req->GetHeader("Range");
+                if (rangeHeader.first) {
+                    if (!ParseByteRange(rangeHeader.second, sliceSize, offset, length)) {
+                        return RESTERR(req, HTTP_BAD_REQUEST,
+                                       "Invalid Range header: " + rangeHeader.second);
+                    }
+                    if (length == 0) {
+                        req->WriteHeader("Content-Range", "bytes */" + std::to_string(sliceSize));
+                        return RESTERR(req, HTTP_RANGE_NOT_SATISFIABLE,
+                                       "Range is beyond the end of the data");
+                    }
+                    req->WriteHeader("Content-Range",
+                                     strprintf("bytes %d-%d/%d", offset, offset + length - 1, sliceSize));
+                }
+
+                auto stream = pblockindex->StreamSyncPartialBlockFromDisk(sliceOffset + offset, length);
+                if (!stream) {
+                    return RESTERR(req, HTTP_NOT_FOUND, hashStr + " not found on disk");
+                }
+                req->WriteHeader("Content-Type", "application/octet-stream");
+                req->WriteHeader("Content-Length", std::to_string(length));
+                req->StartWritingChunks(rangeHeader.first ? HTTP_PARTIAL_CONTENT : HTTP_OK);
+                do {
+                    const CSpan chunk = stream->Read(4096);
+                    req->WriteReplyChunk({reinterpret_cast<const char *>(chunk.Begin()), chunk.Size()});
+                } while (!stream->EndOfStream());
+                req->StopWritingChunks();
+                break;
+            }
+
+            case RF_HEX: {
+                auto stream = pblockindex->StreamSyncPartialBlockFromDisk(sliceOffset, sliceSize);
+                if (!stream) {
+                    return RESTERR(req, HTTP_NOT_FOUND, hashStr + " not found on disk");
+                }
+                req->WriteHeader("Content-Type", "text/plain");
+                req->StartWritingChunks(HTTP_OK);
+                do {
+                    const CSpan chunk = stream->Read(4096);
+                    req->WriteReplyChunk(HexStr(chunk.Begin(), chunk.Begin() + chunk.Size()));
+                } while (!stream->EndOfStream());
+                req->WriteReplyChunk("\n");
+                req->StopWritingChunks();
+                break;
+            }
+
+            default: {
+                auto stream = pblockindex->StreamSyncPartialBlockFromDisk(sliceOffset, sliceSize);
+                if (!stream) {
+                    return RESTERR(req, HTTP_NOT_FOUND, hashStr + " not found on disk");
+                }
+                const bool isGenesisEnabled = IsGenesisEnabled(config, pblockindex->GetHeight());
+                req->WriteHeader("Content-Type", "application/json");
+                req->StartWritingChunks(HTTP_OK);
+                CHttpTextWriter httpWriter(*req);
+                CJSONWriter jWriter(httpWriter, false);
+                jWriter.writeBeginArray();
+                for (uint64_t i = start; i < start + count; ++i) {
+                    const auto [txOffset, txSize] = offsets->GetTxRange(i, 1);
+                    const std::vector<uint8_t> txData = ReadFromStream(*stream, txSize);
+                    CDataStream ssTx(txData, SER_NETWORK, PROTOCOL_VERSION);
+                    const CTransaction tx {deserialize, ssTx};
+                    TxToJSON(tx, hash, isGenesisEnabled, RPCSerializationFlags(), jWriter);
+                }
+                jWriter.writeEndArray();
+                httpWriter.WriteLine();
+                httpWriter.Flush();
+                req->StopWritingChunks();
+                break;
+            }
+        }
+    } catch (block_parse_error &ex) {
+        return RESTERR(req, HTTP_NOT_FOUND, std::string(ex.what()));
+    }
+
+    return true;
+}
+
 static bool rest_block_extended(Config &config, HTTPRequest *req,
                                 const std::string &strURIPart) {
+    if (strURIPart.find('/') != std::string::npos) {
+        return rest_block_transactions(config, req, strURIPart);
+    }
     return rest_block(config, req, strURIPart, true);
 }
 
@@ -772,6 +1044,522 @@ static bool rest_getutxos(Config &config, HTTPRequest *req,
     return true;
 }
 
+namespace {
+
+/** Outcome of a transaction submitted through /rest/txs. */
+enum class TxSubmissionStatus : uint8_t
+{
+    // Validated and accepted to the mempool.
+    accepted = 0,
+    // Already in the mempool, not validated again.
+    known = 1,
+    // Rejected by validation.
+    rejected = 2,
+    // Accepted and then evicted from the mempool while the request was processed.
+    evicted = 3
+};
+
+const char* TxSubmissionStatusToString(TxSubmissionStatus status)
+{
+    switch (status) {
+        case TxSubmissionStatus::accepted: return "accepted";
+        case TxSubmissionStatus::known:    return "known";
+        case TxSubmissionStatus::rejected: return "rejected";
+        case TxSubmissionStatus::evicted:  return "evicted";
+    }
+    return "unknown";
+}
+
+void WriteTxSubmissionResult(CHttpTextWriter& httpWriter,
+                             RetFormat rf,
+                             const TxId& txid,
+                             TxSubmissionStatus status,
+                             const CValidationState* state)
+{
+    if (rf == RF_BINARY) {
+        // txid, status, reject code and reject reason (empty unless rejected)
+        CDataStream ss(SER_NETWORK, PROTOCOL_VERSION);
+        ss << txid << static_cast<uint8_t>(status)
+           << static_cast<uint32_t>(state ? state->GetRejectCode() : 0)
+           << (state ? state->GetRejectReason() : std::string{});
+        httpWriter.Write(ss.str());
+        return;
+    }
+
+    // One JSON object per line
+    CJSONWriter jWriter(httpWriter, false);
+    jWriter.writeBeginObject();
+    jWriter.pushKV("txid", txid.GetHex());
+    jWriter.pushKV("status", TxSubmissionStatusToString(status));
+    if (state) {
+        jWriter.pushKV("reject_code", static_cast<int64_t>(state->GetRejectCode()));
+        jWriter.pushKV("reject_reason", state->GetRejectReason());
+    }
+    jWriter.writeEndObject();
+    jWriter.flush();
+    httpWriter.Write('\n');
+}
+
+} // namespace
+
+/**
+ * Submit a batch of transactions.
+ *
+ * The request body is a sequence of raw transactions, each prefixed with its
+ * size as a CompactSize. All transactions are handed to the validator in one
+ * batch and a result per transaction is streamed back in request order, as
+ * the results become available:
+ * - .bin:  txid, status byte, 4 byte reject code and reject reason string,
+ *          serialised in the network format
+ * - .json: one JSON object per line
+ */
+static bool rest_txs(Config &config, HTTPRequest *req,
+                     const std::string &strURIPart) {
+    if (!CheckWarmup(req)) {
+        return false;
+    }
+
+    if (req->GetRequestMethod() != HTTPRequest::POST) {
+        return RESTERR(req, HTTP_BAD_METHOD, "Only POST requests are allowed");
+    }
+
+    std::string param;
+    const RetFormat rf = ParseDataFormat(param, strURIPart);
+    if (!param.empty()) {
+        return RESTERR(req, HTTP_NOT_FOUND, "Unknown path: " + param);
+    }
+    if (rf != RF_BINARY && rf != RF_JSON) {
+        return RESTERR(req, HTTP_NOT_FOUND,
+                       "output format not found (available: .bin, .json)");
+    }
+
+    if (!g_connman) {
+        return RESTERR(req, HTTP_SERVICE_UNAVAILABLE,
+                       "Peer-to-peer functionality missing or disabled");
+    }
+
+    // Parse the whole request before submitting anything
+    const std::string body = req->ReadBody();
+    if (body.empty()) {
+        return RESTERR(req, HTTP_BAD_REQUEST, "Error: empty request");
+    }
+    std::vector<CTransactionRef> txns {};
+    try {
+        CDataStream stream(body.data(), body.data() + body.size(), SER_NETWORK, PROTOCOL_VERSION);
+        while (!stream.empty()) {
+            const uint64_t txSize = ReadCompactSize(stream);
+            if (txSize > stream.size()) {
+                return RESTERR(req, HTTP_BAD_REQUEST,
+                               strprintf("Parse error: transaction %d is truncated", txns.size()));
+            }
+            CDataStream txStream(stream.data(), stream.data() + txSize, SER_NETWORK, PROTOCOL_VERSION);
+            stream.ignore(txSize);
+
+            CMutableTransaction mtx;
+            txStream >> mtx;
+            if (!txStream.empty()) {
+                return RESTERR(req, HTTP_BAD_REQUEST,
+                               strprintf("Parse error: transaction %d has trailing data", txns.size()));
+            }
+            txns.emplace_back(MakeTransactionRef(std::move(mtx)));
+        }
+    } catch (const std::ios_base::failure &e) {
+        return RESTERR(req, HTTP_BAD_REQUEST,
+                       strprintf("Parse error: transaction %d", txns.size()));
+    }
+
+    // Transactions already in the mempool are reported as known, the rest is
+    // validated in a single batch. txnResults holds for each transaction an
+    // index into the submitted batch or std::nullopt if it is known.
+    std::vector<std::unique_ptr<CTxInputData>> vTxInputData {};
+    vTxInputData.reserve(txns.size());
+    std::vector<std::optional<size_t>> txnResults {};
+    txnResults.reserve(txns.size());
+    // TxIds of transactions that were already enqueued for asynchronous validation
+    std::unordered_set<TxId, std::hash<TxId>> usetP2PEnqueuedTxIds {};
+    for (auto& tx : txns) {
+        const TxId& txid = tx->GetId();
+        if (mempool.Exists(txid) || mempool.getNonFinalPool().exists(txid)) {
+            txnResults.emplace_back(std::nullopt);
+            continue;
+        }
+        txnResults.emplace_back(vTxInputData.size());
+        const auto& txInputData = vTxInputData.emplace_back(
+            std::make_unique<CTxInputData>(
+                g_connman->GetTxIdTracker(),    // a pointer to the TxIdTracker
+                tx,                             // a pointer to the tx
+                TxSource::rpc,                  // tx source
+                TxValidationPriority::normal,   // tx validation priority
+                TxStorage::memory,              // tx storage
+                GetTime(),                      // nAcceptTime
+                maxTxFee,                       // nAbsurdFee
+                std::weak_ptr<CNode>(),         // pNode
+                false));                        // fOrphan
+        if (!txInputData->IsTxIdStored()) {
+            usetP2PEnqueuedTxIds.insert(txid);
+        }
+    }
+
+    auto resultVec = g_connman->getRawTxValidator()->SubmitMany(vTxInputData);
+    const auto& p2pOrphans = g_connman->getTxnValidator()->getOrphanTxnsPtr();
+
+    req->WriteHeader("Content-Type",
+                     rf == RF_BINARY ? "application/octet-stream" : "application/x-ndjson");
+    req->StartWritingChunks(HTTP_OK);
+    CHttpTextWriter httpWriter(*req);
+
+    for (size_t i = 0; i < txns.size(); ++i) {
+        const TxId& txid = txns[i]->GetId();
+        if (!txnResults[i].has_value()) {
+            WriteTxSubmissionResult(httpWriter, rf, txid, TxSubmissionStatus::known, nullptr);
+            continue;
+        }
+
+        // Send what we have so far before waiting for the validation
+        auto& resultFuture = resultVec[txnResults[i].value()];
+        if (resultFuture.wait_for(std::chrono::seconds::zero()) != std::future_status::ready) {
+            httpWriter.Flush();
+        }
+        auto result = resultFuture.get();
+
+        if (result.state.has_value()) {
+            WriteTxSubmissionResult(httpWriter, rf, txid, TxSubmissionStatus::rejected, &result.state.value());
+            continue;
+        }
+
+        // A duplicate may have been enqueued to the p2p orphan pool meanwhile
+        if (usetP2PEnqueuedTxIds.count(txid) && p2pOrphans->checkTxnExists(txid)) {
+            p2pOrphans->eraseTxn(txid);
+            LogPrint(BCLog::TXNSRC, "txn= %s duplicate removed from the p2p orphan pool\n", txid.ToString());
+        }
+
+        if (result.evicted) {
+            WriteTxSubmissionResult(httpWriter, rf, txid, TxSubmissionStatus::evicted, nullptr);
+            continue;
+        }
+
+        // Announce the transaction if it is still in the mempool
+        TxMempoolInfo txinfo {};
+        if (mempool.Exists(txid)) {
+            txinfo = mempool.Info(txid);
+        } else if (mempool.getNonFinalPool().exists(txid)) {
+            txinfo = mempool.getNonFinalPool().getInfo(txid);
+        }
+        if (txinfo.GetTx() != nullptr) {
+            CInv inv(MSG_TX, txid);
+            if (g_connman->EnqueueTransaction({ inv, txinfo })) {
+                LogPrint(BCLog::TXNSRC, "txn= %s inv message enqueued, txnsrc-rest\n",
+                         inv.hash.ToString());
+            }
+        }
+        WriteTxSubmissionResult(httpWriter, rf, txid, TxSubmissionStatus::accepted, nullptr);
+    }
+
+    httpWriter.Flush();
+    req->StopWritingChunks();
+
+    LogPrint(BCLog::TXNSRC, "REST processing completed: batch size= %ld\n", txns.size());
+    return true;
+}
+
+namespace {
+
+enum class MerkleProofTarget { hash, header, merkleroot };
+
+// Merkle proof in the binary format of the TSC merkle proof standard
+void WriteMerkleProofBinary(CDataStream &ss,
+                            const CMerkleTree::MerkleProof &proof,
+                            const TxId &txid,
+                            const CTransactionRef &tx,
+                            MerkleProofTarget target,
+                            const CBlockIndex &blockIndex) {
+    uint8_t flags = tx ? 0x01 : 0x00;
+    if (target == MerkleProofTarget::header) {
+        flags |= 0x02;
+    } else if (target == MerkleProofTarget::merkleroot) {
+        flags |= 0x04;
+    }
+    ss << flags;
+    WriteCompactSize(ss, proof.transactionIndex);
+    if (tx) {
+        WriteCompactSize(ss, tx->GetTotalSize());
+        ss << *tx;
+    } else {
+        ss << txid;
+    }
+
+    switch (target) {
+        case MerkleProofTarget::hash:
+            ss << blockIndex.GetBlockHash();
+            break;
+        case MerkleProofTarget::header:
+            ss << blockIndex.GetBlockHeader();
+            break;
+        case MerkleProofTarget::merkleroot:
+            ss << blockIndex.GetMerkleRoot();
+            break;
+    }
+
+    WriteCompactSize(ss, proof.merkleTreeHashes.size());
+    for (const uint256 &node : proof.merkleTreeHashes) {
+        // Type 1 is a duplicate of the calculated node and has no value
+        if (node.IsNull()) {
+            ss << uint8_t{1};
+        } else {
+            ss << uint8_t{0} << node;
+        }
+    }
+}
+
+// Merkle proof as returned by getmerkleproof2 with the txid in front
+void WriteMerkleProofJSON(CJSONWriter &jWriter,
+                          const CMerkleTree::MerkleProof &proof,
+                          const TxId &txid,
+                          const CTransactionRef &tx,
+                          MerkleProofTarget target,
+                          const CBlockIndex &blockIndex) {
+    jWriter.writeBeginObject();
+    jWriter.pushKV("txid", txid.GetHex());
+    jWriter.pushKV("index", static_cast<uint64_t>(proof.transactionIndex));
+    jWriter.pushKV("txOrId", tx ? EncodeHexTx(*tx, RPCSerializationFlags()) : txid.GetHex());
+    switch (target) {
+        case MerkleProofTarget::hash:
+            jWriter.pushKV("target", blockIndex.GetBlockHash().GetHex());
+            break;
+        case MerkleProofTarget::header: {
+            CDataStream ssHeader(SER_NETWORK, PROTOCOL_VERSION);
+            ssHeader << blockIndex.GetBlockHeader();
+            jWriter.pushKV("targetType", "header");
+            jWriter.pushKV("target", HexStr(ssHeader.begin(), ssHeader.end()));
+            break;
+        }
+        case MerkleProofTarget::merkleroot:
+            jWriter.pushKV("targetType", "merkleroot");
+            jWriter.pushKV("target", blockIndex.GetMerkleRoot().GetHex());
+            break;
+    }
+    jWriter.writeBeginArray("nodes");
+    for (const uint256 &node : proof.merkleTreeHashes) {
+        jWriter.pushV(node.IsNull() ? std::string{"*"} : node.GetHex());
+    }
+    jWriter.writeEndArray();
+    jWriter.writeEndObject();
+}
+
+// Block in the active chain that contains the transaction according to the
+// UTXO set or the transaction index
+const CBlockIndex *FindBlockOfTransaction(const Config &config,
+                                          CoinsDBView &tipView,
+                                          const TxId &txid) {
+    if (auto coin = tipView.GetCoinByTxId(txid); coin.has_value()) {
+        LOCK(cs_main);
+        if (const CBlockIndex *pindex = chainActive[coin->GetHeight()]) {
+            return pindex;
+        }
+    }
+
+    CTransactionRef tx;
+    uint256 hashBlock;
+    bool isGenesisEnabled;
+    if (GetTransaction(config, txid, tx, false, hashBlock, isGenesisEnabled) &&
+        !hashBlock.IsNull()) {
+        return mapBlockIndex.Get(hashBlock);
+    }
+    return nullptr;
+}
+
+} // namespace
+
+/**
+ * Merkle proofs of a batch of transactions.
+ *
+ * The request body is a JSON object:
+ *   {"txids": [...], "blockhash": "...", "includeFullTx": bool,
+ *    "targetType": "hash"|"header"|"merkleroot"}
+ * of which only txids is required. Without blockhash the block of each
+ * transaction is found in the UTXO set or the transaction index.
+ * Transactions are grouped by block so the merkle tree of every block is
+ * loaded once, and a result per transaction is streamed back block by block:
+ * - .bin:  txid, CompactSize size of the proof and the proof in the binary
+ *          TSC format; the size is 0 if there is no proof
+ * - .json: one JSON object per line with the txid and the fields returned by
+ *          getmerkleproof2, or the txid and an error
+ */
+static bool rest_merkleproofs(Config &config, HTTPRequest *req,
+                              const std::string &strURIPart) {
+    if (!CheckWarmup(req)) {
+        return false;
+    }
+
+    if (req->GetRequestMethod() != HTTPRequest::POST) {
+        return RESTERR(req, HTTP_BAD_METHOD, "Only POST requests are allowed");
+    }
+
+    std::string param;
+    const RetFormat rf = ParseDataFormat(param, strURIPart);
+    if (!param.empty()) {
+        return RESTERR(req, HTTP_NOT_FOUND, "Unknown path: " + param);
+    }
+    if (rf != RF_BINARY && rf != RF_JSON) {
+        return RESTERR(req, HTTP_NOT_FOUND,
+                       "output format not found (available: .bin, .json)");
+    }
+
+    UniValue request;
+    if (!request.read(req->ReadBody()) || !request.isObject()) {
+        return RESTERR(req, HTTP_BAD_REQUEST, "Error: request must be a JSON object");
+    }
+
+    const UniValue &txidsValue = find_value(request, "txids");
+    if (!txidsValue.isArray() || txidsValue.empty()) {
+        return RESTERR(req, HTTP_BAD_REQUEST, "Error: txids must be a non-empty array");
+    }
+    std::vector<TxId> txids {};
+    txids.reserve(txidsValue.size());
+    for (const UniValue &value : txidsValue.getValues()) {
+        uint256 hash;
+        if (!value.isStr() || !ParseHashStr(value.get_str(), hash)) {
+            return RESTERR(req, HTTP_BAD_REQUEST, "Invalid txid: " + value.write());
+        }
+        txids.emplace_back(hash);
+    }
+
+    const UniValue &includeFullTxValue = find_value(request, "includeFullTx");
+    if (!includeFullTxValue.isNull() && !includeFullTxValue.isBool()) {
+        return RESTERR(req, HTTP_BAD_REQUEST, "Error: includeFullTx must be a boolean");
+    }
+    const bool includeFullTx = includeFullTxValue.isTrue();
+
+    MerkleProofTarget target {MerkleProofTarget::hash};
+    const UniValue &targetTypeValue = find_value(request, "targetType");
+    if (!targetTypeValue.isNull()) {
+        const std::string targetType = targetTypeValue.isStr() ? targetTypeValue.get_str() : "";
+        if (targetType == "header") {
+            target = MerkleProofTarget::header;
+        } else if (targetType == "merkleroot") {
+            target = MerkleProofTarget::merkleroot;
+        } else if (targetType != "hash") {
+            return RESTERR(req, HTTP_BAD_REQUEST,
+                           "Error: targetType must be 'hash', 'header' or 'merkleroot'");
+        }
+    }
+
+    // Requested transactions grouped by block in order of first appearance
+    std::vector<std::pair<const CBlockIndex *, std::vector<TxId>>> blocks {};
+    std::vector<TxId> notInBlock {};
+    const UniValue &blockHashValue = find_value(request, "blockhash");
+    if (!blockHashValue.isNull()) {
+        uint256 blockHash;
+        if (!blockHashValue.isStr() || !ParseHashStr(blockHashValue.get_str(), blockHash)) {
+            return RESTERR(req, HTTP_BAD_REQUEST, "Invalid blockhash: " + blockHashValue.write());
+        }
+        const CBlockIndex *pblockindex = mapBlockIndex.Get(blockHash);
+        if (!pblockindex) {
+            return RESTERR(req, HTTP_NOT_FOUND, blockHashValue.get_str() + " not found");
+        }
+        blocks.emplace_back(pblockindex, std::move(txids));
+    } else {
+        std::unordered_map<const CBlockIndex *, size_t> blockPositions {};
+        CoinsDBView tipView {*pcoinsTip};
+        for (const TxId &txid : txids) {
+            const CBlockIndex *pblockindex = FindBlockOfTransaction(config, tipView, txid);
+            if (!pblockindex) {
+                notInBlock.push_back(txid);
+                continue;
+            }
+            const auto [it, inserted] = blockPositions.try_emplace(pblockindex, blocks.size());
+            if (inserted) {
+                blocks.emplace_back(pblockindex, std::vector<TxId> {});
+            }
+            blocks[it->second].second.push_back(txid);
+        }
+    }
+
+    req->WriteHeader("Content-Type",
+                     rf == RF_BINARY ? "application/octet-stream" : "application/x-ndjson");
+    req->StartWritingChunks(HTTP_OK);
+    CHttpTextWriter httpWriter(*req);
+
+    const auto writeProof = [&](const TxId &txid, const CMerkleTree::MerkleProof &proof,
+                                const CTransactionRef &tx, const CBlockIndex &blockIndex) {
+        if (rf == RF_BINARY) {
+            CDataStream ssProof(SER_NETWORK, PROTOCOL_VERSION);
+            WriteMerkleProofBinary(ssProof, proof, txid, tx, target, blockIndex);
+            CDataStream ss(SER_NETWORK, PROTOCOL_VERSION);
+            ss << txid;
+            WriteCompactSize(ss, ssProof.size());
+            httpWriter.Write(ss.str());
+            httpWriter.Write(ssProof.str());
+            return;
+        }
+        CJSONWriter jWriter(httpWriter, false);
+        WriteMerkleProofJSON(jWriter, proof, txid, tx, target, blockIndex);
+        jWriter.flush();
+        httpWriter.Write('\n');
+    };
+    const auto writeError = [&](const TxId &txid, const std::string &error) {
+        if (rf == RF_BINARY) {
+            CDataStream ss(SER_NETWORK, PROTOCOL_VERSION);
+            ss << txid;
+            WriteCompactSize(ss, 0);
+            httpWriter.Write(ss.str());
+            return;
+        }
+        CJSONWriter jWriter(httpWriter, false);
+        jWriter.writeBeginObject();
+        jWriter.pushKV("txid", txid.GetHex());
+        jWriter.pushKV("error", error);
+        jWriter.writeEndObject();
+        jWriter.flush();
+        httpWriter.Write('\n');
+    };
+
+    for (const TxId &txid : notInBlock) {
+        writeError(txid, "Transaction not yet in block or -txindex is not enabled");
+    }
+
+    for (const auto &[pblockindex, blockTxIds] : blocks) {
+        int32_t currentChainHeight;
+        {
+            LOCK(cs_main);
+            currentChainHeight = chainActive.Height();
+        }
+        CMerkleTreeRef merkleTree =
+            pMerkleTreeFactory->GetMerkleTree(config, *pblockindex, currentChainHeight);
+        if (!merkleTree) {
+            for (const TxId &txid : blockTxIds) {
+                writeError(txid, "Can't read block from disk");
+            }
+            continue;
+        }
+
+        const auto indices = merkleTree->GetTransactionIndices(blockTxIds);
+        for (const TxId &txid : blockTxIds) {
+            const auto index = indices.find(txid);
+            if (index == indices.end()) {
+                writeError(txid, "Transaction not found in block");
+                continue;
+            }
+            CTransactionRef tx {};
+            if (includeFullTx) {
+                tx = ReadBlockTransaction(*pblockindex, txid);
+                if (!tx) {
+                    writeError(txid, "Can't read transaction from disk");
+                    continue;
+                }
+            }
+            writeProof(txid, merkleTree->GetMerkleProof(index->second, true), tx, *pblockindex);
+        }
+
+        // Send proofs of each block as soon as they are ready
+        httpWriter.Flush();
+    }
+
+    httpWriter.Flush();
+    req->StopWritingChunks();
+    return true;
+}
+
 static const struct {
     const char *prefix;
     bool (*handler)(Config &config, HTTPRequest *req,
@@ -786,6 +1574,7 @@ static const struct {
     {"/rest/headers/extended/", rest_headers_extended},
     {"/rest/headers/", rest_headers_not_extended},
     {"/rest/getutxos", rest_getutxos},
+    {"/rest/merkleproofs", rest_merkleproofs},
 };
 
 bool StartREST() {
@@ -793,6 +1582,10 @@ bool StartREST() {
         RegisterHTTPHandler(uri_prefixes[i].prefix, false,
                             uri_prefixes[i].handler);
     }
+    // Transaction submission is not read-only so it needs to be enabled separately
+    if (gArgs.GetBoolArg("-resttxsubmission", DEFAULT_REST_TX_SUBMISSION)) {
+        RegisterHTTPHandler("/rest/txs", false, rest_txs);
+    }
 
     return true;
 }
@@ -803,4 +1596,5 @@ void StopREST() {
     for (size_t i = 0; i < ARRAYLEN(uri_prefixes); i++) {
         UnregisterHTTPHandler(uri_prefixes[i].prefix, false);
     }
+    UnregisterHTTPHandler("/rest/txs", false);
 }
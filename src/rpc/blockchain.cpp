@@ -404,27 +404,62 @@ void writeMempoolEntryToJsonNL(const CTxMemPoolEntry& e,
     jWriter.writeEndObject();
 }
 
+static void writeMempoolEntryToJson(const CTxMemPool::View::Entry& e,
+                                    CJSONWriter& jWriter, bool pushId = true)
+{
+    if (pushId)
+    {
+        jWriter.writeBeginObject(e.txid.ToString());
+    }
+    else
+    {
+        jWriter.writeBeginObject();
+    }
+
+    jWriter.pushKV("size", static_cast<uint64_t>(e.size));
+    jWriter.pushKV("fee", e.fee);
+    jWriter.pushKV("modifiedfee", e.modifiedFee);
+    jWriter.pushKV("time", e.time);
+    jWriter.pushKV("height", static_cast<uint64_t>(e.height));
+    std::set<std::string> deps;
+    for (const auto& hash : e.depends)
+    {
+        deps.insert(hash.ToString());
+    }
+    jWriter.writeBeginArray("depends");
+    for (const auto& dep : deps)
+    {
+        jWriter.pushV(dep);
+    }
+    jWriter.writeEndArray();
+    jWriter.writeEndObject();
+}
+
+static std::shared_ptr<const CTxMemPool::View> GetMempoolView()
+{
+    return mempool.GetView(
+        std::chrono::milliseconds{
+            gArgs.GetArg("-mempoolviewmaxage", DEFAULT_MEMPOOL_VIEW_MAX_AGE)});
+}
+
 void writeMempoolToJson(CJSONWriter& jWriter, bool fVerbose = false)
 {
+    const auto view = GetMempoolView();
     if (fVerbose)
     {
-        const auto snapshot = mempool.GetSnapshot();
         jWriter.writeBeginObject();
-        for (const auto& entry : snapshot)
+        for (const auto& entry : *view)
         {
-            writeMempoolEntryToJsonNL(entry, snapshot, jWriter);
+            writeMempoolEntryToJson(entry, jWriter);
         }
         jWriter.writeEndObject();
     }
     else
     {
-        std::vector<uint256> vtxids;
-        mempool.QueryHashes(vtxids);
-
         jWriter.writeBeginArray();
-        for (const uint256 &txid : vtxids)
+        for (const auto& entry : *view)
         {
-            jWriter.pushV(txid.ToString());
+            jWriter.pushV(entry.txid.ToString());
         }
         jWriter.writeEndArray();
     }
@@ -492,6 +527,73 @@ void getrawmempool(const Config& config,
     }
 }
 
+void getmempoolsnapshot(const Config& config,
+                        const JSONRPCRequest& request,
+                        HTTPRequest* httpReq,
+                        bool processedInBatch)
+{
+    if (request.fHelp || request.params.size() > 0) {
+        throw std::runtime_error(
+            "getmempoolsnapshot\n"
+            "\nReturns all transactions in memory pool together with the "
+            "sequence number of the last mempool delta (see -zmqpubmempooldelta) "
+            "that is included in the result.\n"
+            "Subscribers of the mempool delta feed should apply only deltas "
+            "with a higher sequence number on top of the snapshot.\n"
+            "\nResult:\n"
+            "{                           (json object)\n"
+            "  \"sequence\" : n,          (numeric) Sequence number of the "
+            "last mempool delta included in the snapshot\n"
+            "  \"transactions\" : {       (json object)\n"
+            "    \"transactionid\" : {     (json object)\n" +
+            EntryDescriptionString() +
+            "    }, ...\n"
+            "  }\n"
+            "}\n"
+            "\nExamples:\n" +
+            HelpExampleCli("getmempoolsnapshot", "") +
+            HelpExampleRpc("getmempoolsnapshot", ""));
+    }
+
+    if(httpReq == nullptr)
+        return;
+
+    // Sequence number and contents are taken under the same mempool lock.
+    const auto view = GetMempoolView();
+
+    if (!processedInBatch)
+    {
+        httpReq->WriteHeader("Content-Type", "application/json");
+        httpReq->StartWritingChunks(HTTP_OK);
+    }
+
+    {
+        CHttpTextWriter httpWriter(*httpReq);
+        CJSONWriter jWriter(httpWriter, false);
+
+        jWriter.writeBeginObject();
+        jWriter.pushKNoComma("result");
+        jWriter.writeBeginObject();
+        jWriter.pushKV("sequence", view->GetDeltaSequence());
+        jWriter.writeBeginObject("transactions");
+        for (const auto& entry : *view)
+        {
+            writeMempoolEntryToJson(entry, jWriter);
+        }
+        jWriter.writeEndObject();
+        jWriter.writeEndObject();
+        jWriter.pushKV("error", nullptr);
+        jWriter.pushKVJSONFormatted("id", request.id.write());
+        jWriter.writeEndObject();
+        jWriter.flush();
+    }
+
+    if (!processedInBatch)
+    {
+        httpReq->StopWritingChunks();
+    }
+}
+
 void getrawnonfinalmempool(const Config& config,
                            const JSONRPCRequest& request,
                            HTTPRequest* httpReq,
@@ -756,11 +858,11 @@ void getmempoolentry(const Config& config,
 
     uint256 hash = ParseHashV(request.params[0], "parameter 1");
 
-    const auto kind = CTxMemPool::TxSnapshotKind::SINGLE;
-    const auto snapshot = mempool.GetTxSnapshot(hash, kind);
+    const auto view = GetMempoolView();
+    const auto* entry = view->Find(hash);
 
     // Check if tx is present in the mempool
-    if (!snapshot.IsValid() || snapshot.empty()) {
+    if (entry == nullptr) {
         throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY,
                            "Transaction not in mempool");
     }
@@ -777,7 +879,7 @@ void getmempoolentry(const Config& config,
         jWriter.writeBeginObject();
         jWriter.pushKNoComma("result");
 
-        writeMempoolEntryToJsonNL(*snapshot.cbegin(), snapshot, jWriter, false);
+        writeMempoolEntryToJson(*entry, jWriter, false);
 
         jWriter.pushKV("error", nullptr);
         jWriter.pushKVJSONFormatted("id", request.id.write());
@@ -2587,14 +2689,15 @@ UniValue getchaintips(const Config &config, const JSONRPCRequest &request) {
 }
 
 UniValue mempoolInfoToJSON(const Config& config) {
+    const auto view = GetMempoolView();
     UniValue ret(UniValue::VOBJ);
-    ret.push_back(Pair("size", (int64_t)mempool.Size()));
+    ret.push_back(Pair("size", (int64_t)view->size()));
     ret.push_back(Pair(
         "journalsize",
         (int64_t)mempool.getJournalBuilder().getCurrentJournal()->size()));
     ret.push_back(
         Pair("nonfinalsize", (int64_t)mempool.getNonFinalPool().getNumTxns()));
-    ret.push_back(Pair("bytes", (int64_t)mempool.GetTotalTxSize()));
+    ret.push_back(Pair("bytes", (int64_t)view->GetTotalTxSize()));
     ret.push_back(Pair("usage", (int64_t)mempool.DynamicMemoryUsage()));
     ret.push_back(Pair("usagedisk", (int64_t)mempool.GetDiskUsage()));
     ret.push_back(Pair("usagecpfp", (int64_t)mempool.SecondaryMempoolUsage()));
@@ -2608,6 +2711,7 @@ UniValue mempoolInfoToJSON(const Config& config) {
     ret.push_back(
         Pair("mempoolminfee",
              ValueFromAmount(mempool.GetMinFee(limits.Total()).GetFeePerK())));
+    ret.push_back(Pair("viewage", view->GetAge().count()));
 
     return ret;
 }
@@ -2633,7 +2737,10 @@ UniValue getmempoolinfo(const Config &config, const JSONRPCRequest &request) {
             "  \"maxmempool\": xxxxx,         (numeric) Maximum memory usage for the mempool\n"
             "  \"maxmempoolsizedisk\": xxxxx, (numeric) Maximum disk usage for storing mempool transactions\n"
             "  \"maxmempoolsizecpfp\": xxxxx, (numeric) Maximum memory usage for the low paying transactions\n"
-            "  \"mempoolminfee\": xxxxx       (numeric) Minimum fee (in BSV/kB) for tx to be accepted\n"
+            "  \"mempoolminfee\": xxxxx,      (numeric) Minimum fee (in BSV/kB) for tx to be accepted\n"
+            "  \"viewage\": xxxxx             (numeric) Age in milliseconds of the mempool data returned\n"
+            "                                by getrawmempool, getmempoolentry and this call (size, bytes);\n"
+            "                                bounded by -mempoolviewmaxage once the mempool changes\n"
             "}\n"
             "\nExamples:\n" +
             HelpExampleCli("getmempoolinfo", "") +
@@ -3759,6 +3866,7 @@ static const CRPCCommand commands[] = {
     { "blockchain",         "getmempooldescendants",  getmempooldescendants,  true,  {"txid","verbose"} },
     { "blockchain",         "getmempoolentry",        getmempoolentry,        true,  {"txid"} },
     { "blockchain",         "getmempoolinfo",         getmempoolinfo,         true,  {} },
+    { "blockchain",         "getmempoolsnapshot",     getmempoolsnapshot,     true,  {} },
     { "blockchain",         "getrawmempool",          getrawmempool,          true,  {"verbose"} },
     { "blockchain",         "getrawnonfinalmempool",  getrawnonfinalmempool,  true,  {} },
     { "blockchain",         "gettxout",               gettxout,               true,  {"txid","n","include_mempool"} },
@@ -1098,7 +1098,13 @@ static UniValue activezmqnotifications(const Config &config, const JSONRPCReques
             "[ (array) active zmq notifications\n"
             "    {\n"
             "       \"notification\": \"xxxx\", (string) name of zmq notification\n"
-            "       \"address\": \"xxxx\"       (string) address of zmq notification\n"
+            "       \"address\": \"xxxx\",      (string) address of zmq notification\n"
+            "       \"queuepolicy\": \"xxxx\",  (string) what happens to new messages when the topic queue is full (block, drop or coalesce)\n"
+            "       \"maxqueuedbytes\": n,     (numeric) memory that messages of the topic can take in the queue\n"
+            "       \"queuedbytes\": n,        (numeric) memory currently taken by queued messages of the topic\n"
+            "       \"queuedmessages\": n,     (numeric) number of queued messages of the topic\n"
+            "       \"sentmessages\": n,       (numeric) number of messages of the topic handed to ZMQ\n"
+            "       \"droppedmessages\": n     (numeric) number of messages of the topic dropped because the queue was full\n"
             "    }, ...\n"
             "]\n"
             "\nExamples:\n" +
@@ -1117,6 +1123,12 @@ static UniValue activezmqnotifications(const Config &config, const JSONRPCReques
             UniValue notifierData(UniValue::VOBJ);
             notifierData.push_back(Pair("notification", n.notifierName));
             notifierData.push_back(Pair("address", n.notifierAddress));
+            notifierData.push_back(Pair("queuepolicy", CZMQPublisher::QueuePolicyToString(n.queue.limits.policy)));
+            notifierData.push_back(Pair("maxqueuedbytes", static_cast<uint64_t>(n.queue.limits.maxQueuedBytes)));
+            notifierData.push_back(Pair("queuedbytes", static_cast<uint64_t>(n.queue.queuedBytes)));
+            notifierData.push_back(Pair("queuedmessages", static_cast<uint64_t>(n.queue.queuedMessages)));
+            notifierData.push_back(Pair("sentmessages", n.queue.sentMessages));
+            notifierData.push_back(Pair("droppedmessages", n.queue.droppedMessages));
             obj.push_back(notifierData);
 
         }
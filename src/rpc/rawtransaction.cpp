@@ -6,6 +6,7 @@
 #include "base58.h"
 #include "block_file_access.h"
 #include "block_index_store.h"
+#include "block_tx_offsets.h"
 #include "chain.h"
 #include "coins.h"
 #include "config.h"
@@ -55,14 +56,16 @@ void getrawtransaction(const Config& config,
                        bool processedInBatch)
 {
     if (request.fHelp || request.params.size() < 1 ||
-        request.params.size() > 2) 
+        request.params.size() > 3) 
     {
         throw std::runtime_error(
-            "getrawtransaction \"txid\" ( verbose )\n"
+            "getrawtransaction \"txid\" ( verbose \"blockhash\" )\n"
 
             "\nNOTE: By default this function only works for mempool "
             "transactions. If the -txindex option is\n"
-            "enabled, it also works for blockchain transactions.\n"
+            "enabled, it also works for blockchain transactions. If the block "
+            "which contains the transaction\n"
+            "is known, its hash can be provided even for nodes without -txindex.\n"
             "DEPRECATED: for now, it also works for transactions with unspent "
             "outputs.\n"
 
@@ -76,6 +79,8 @@ void getrawtransaction(const Config& config,
             "1. \"txid\"      (string, required) The transaction id\n"
             "2. verbose       (bool, optional, default=false) If false, return "
             "a string, otherwise return a json object\n"
+            "3. \"blockhash\"   (string, optional) The block in which to look "
+            "for the transaction\n"
 
             "\nResult (if verbose is not set or set to false):\n"
             "\"data\"      (string) The serialized, hex-encoded data for "
@@ -137,6 +142,7 @@ void getrawtransaction(const Config& config,
             "\nExamples:\n" +
             HelpExampleCli("getrawtransaction", "\"mytxid\"") +
             HelpExampleCli("getrawtransaction", "\"mytxid\" true") +
+            HelpExampleCli("getrawtransaction", "\"mytxid\" false \"myblockhash\"") +
             HelpExampleRpc("getrawtransaction", "\"mytxid\", true"));
     }
 
@@ -192,7 +198,27 @@ void getrawtransaction(const Config& config,
     CTransactionRef tx;
     uint256 hashBlock;
     bool isGenesisEnabled;
-    if (!GetTransaction(config, txid, tx, true, hashBlock, isGenesisEnabled)) 
+    if (request.params.size() > 2 && !request.params[2].isNull())
+    {
+        hashBlock = ParseHashV(request.params[2], "parameter 3");
+        const CBlockIndex* blockIndex = mapBlockIndex.Get(hashBlock);
+        if (!blockIndex)
+        {
+            throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "Block hash not found");
+        }
+        if (!blockIndex->getStatus().hasData())
+        {
+            throw JSONRPCError(RPC_MISC_ERROR, "Block not available");
+        }
+        tx = ReadBlockTransaction(*blockIndex, txid);
+        if (!tx)
+        {
+            throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY,
+                               "No such transaction found in the provided block");
+        }
+        isGenesisEnabled = IsGenesisEnabled(config, blockIndex->GetHeight());
+    }
+    else if (!GetTransaction(config, txid, tx, true, hashBlock, isGenesisEnabled)) 
     {
         throw JSONRPCError(
             RPC_INVALID_ADDRESS_OR_KEY,
@@ -2410,24 +2436,13 @@ static UniValue getmerkleproof2(const Config& config, const JSONRPCRequest& requ
         }
         else
         {
-            CTransactionRef tx;
-            uint256 hashBlock;
-            bool isGenesisEnabled;
-            if (!GetTransaction(config, txid, tx, true, hashBlock, isGenesisEnabled))
+            // Read the transaction directly from the block that was found
+            CTransactionRef tx = ReadBlockTransaction(*blockIndex, txid);
+            if (!tx)
             {
-                if (fTxIndex)
-                    hints << "No such mempool or blockchain transaction";
-                else
-                    hints << "No such mempool transaction. Use -txindex "
-                             "to enable blockchain transaction queries";
-                hints << ". Use gettransaction for wallet transactions.";
-
-                throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, hints.str());
+                throw JSONRPCError(RPC_INTERNAL_ERROR, "Can't read transaction from disk");
             }
 
-            if (!blockHashString.empty())
-                assert(requestedBlockHash == hashBlock);
-
             CStringWriter writer;
             writer.ReserveAdditional(tx->GetTotalSize() * 2);
             EncodeHexTx(*tx, writer, RPCSerializationFlags());
@@ -2552,7 +2567,7 @@ static UniValue verifymerkleproof(const Config& config,
 static const CRPCCommand commands[] = {
     //  category            name                      actor (function)        okSafeMode
     //  ------------------- ------------------------  ----------------------  ----------
-    { "rawtransactions",    "getrawtransaction",      getrawtransaction,      true,  {"txid","verbose"} },
+    { "rawtransactions",    "getrawtransaction",      getrawtransaction,      true,  {"txid","verbose","blockhash"} },
     { "rawtransactions",    "createrawtransaction",   createrawtransaction,   true,  {"inputs","outputs","locktime"} },
     { "rawtransactions",    "decoderawtransaction",   decoderawtransaction,   true,  {"hexstring"} },
     { "rawtransactions",    "decodescript",           decodescript,           true,  {"hexstring"} },
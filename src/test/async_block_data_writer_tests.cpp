@@ -0,0 +1,105 @@
+// Copyright (c) 2024 Bitcoin Association
+// Distributed under the Open BSV software license, see the accompanying file LICENSE.
+
+#include "async_block_data_writer.h"
+#include "block_file_access.h"
+#include "blockfileinfostore.h"
+#include "chainparams.h"
+#include "clientversion.h"
+#include "consensus/validation.h"
+#include "test/test_bitcoin.h"
+#include "txdb.h"
+#include "undo.h"
+#include "validation.h"
+
+#include <boost/test/unit_test.hpp>
+
+namespace
+{
+    CBlockUndo MakeUndo(size_t numOfTxs)
+    {
+        CBlockUndo undo;
+        for (size_t i = 0; i < numOfTxs; ++i)
+        {
+            CTxUndo txUndo;
+            txUndo.vprevout.push_back(CoinWithScript::MakeOwning(
+                CTxOut{ Amount{ static_cast<int64_t>(i + 1) }, CScript() << OP_TRUE }, 1, false, false));
+            undo.vtxundo.push_back(std::move(txUndo));
+        }
+        return undo;
+    }
+
+    std::vector<uint8_t> Serialize(const CBlockUndo& undo)
+    {
+        CDataStream stream{ SER_DISK, CLIENT_VERSION };
+        stream << undo;
+        return { stream.begin(), stream.end() };
+    }
+}
+
+BOOST_FIXTURE_TEST_SUITE(async_block_data_writer_tests, TestChain100Setup)
+
+BOOST_AUTO_TEST_CASE(write_undo)
+{
+    CAsyncBlockDataWriter writer{ *pblocktree, Params().DiskMagic(), 2 };
+    const uint256 prevBlockHash = chainActive.Tip()->GetBlockHash();
+
+    std::vector<std::pair<CDiskBlockPos, CBlockUndo>> written{};
+    for (size_t i = 1; i <= 10; ++i)
+    {
+        CBlockUndo undo = MakeUndo(i);
+        const uint64_t undoSize = ::GetSerializeSize(undo, SER_DISK, CLIENT_VERSION);
+
+        CValidationState state;
+        CDiskBlockPos allocatedPos;
+        bool fCheckForPruning = false;
+        BOOST_REQUIRE(pBlockFileInfoStore->FindUndoPos(state, 0, allocatedPos, undoSize + 40, fCheckForPruning));
+
+        const CDiskBlockPos pos = writer.WriteUndo(std::make_shared<const CBlockUndo>(MakeUndo(i)), allocatedPos, prevBlockHash);
+        BOOST_CHECK(pos == BlockFileAccess::GetUndoDataPos(allocatedPos, undoSize));
+        // Until it is written undo data is available from the writer
+        if (auto pending = writer.GetPendingUndo(pos))
+        {
+            BOOST_CHECK(Serialize(*pending) == Serialize(undo));
+        }
+        written.emplace_back(pos, std::move(undo));
+    }
+
+    BOOST_CHECK(writer.Sync());
+    for (const auto& [pos, undo] : written)
+    {
+        BOOST_CHECK(!writer.GetPendingUndo(pos));
+        CBlockUndo read;
+        BOOST_REQUIRE(BlockFileAccess::UndoReadFromDisk(read, pos, prevBlockHash));
+        BOOST_CHECK(Serialize(read) == Serialize(undo));
+    }
+}
+
+BOOST_AUTO_TEST_CASE(write_tx_index_in_order)
+{
+    const uint256 txid = coinbaseTxns[0].GetId();
+    {
+        CAsyncBlockDataWriter writer{ *pblocktree, Params().DiskMagic(), 2 };
+        // Later writes of the same entry win
+        for (unsigned int i = 1; i <= 20; ++i)
+        {
+            writer.WriteTxIndex({ { txid, CDiskTxPos{ CDiskBlockPos{ 0, i }, i * 10 } } });
+        }
+        BOOST_CHECK(writer.Sync());
+        BOOST_CHECK(!writer.HasPendingTxIndex());
+
+        CDiskTxPos pos;
+        BOOST_REQUIRE(pblocktree->ReadTxIndex(txid, pos));
+        BOOST_CHECK_EQUAL(pos.Pos(), 20U);
+        BOOST_CHECK_EQUAL(pos.TxOffset(), 200U);
+
+        writer.WriteTxIndex({ { txid, CDiskTxPos{ CDiskBlockPos{ 0, 21 }, 210 } } });
+    }
+
+    // Queued writes are done before the writer is destroyed
+    CDiskTxPos pos;
+    BOOST_REQUIRE(pblocktree->ReadTxIndex(txid, pos));
+    BOOST_CHECK_EQUAL(pos.Pos(), 21U);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
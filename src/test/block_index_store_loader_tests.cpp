@@ -0,0 +1,97 @@
+// Copyright (c) 2024 Bitcoin Association
+// Distributed under the Open BSV software license, see the accompanying file LICENSE.
+
+#include "block_index_store_loader.h"
+#include "chainparams.h"
+#include "config.h"
+#include "dbwrapper.h"
+#include "pow.h"
+#include "test/test_bitcoin.h"
+#include "txdb.h"
+
+#include <boost/test/unit_test.hpp>
+
+#include <vector>
+
+namespace
+{
+    struct RegtestingSetup : public BasicTestingSetup
+    {
+        RegtestingSetup() : BasicTestingSetup(CBaseChainParams::REGTEST) {}
+    };
+
+    CBlockHeader SolveHeader(const Config& config, CBlockHeader header)
+    {
+        while (!CheckProofOfWork(header.GetHash(), header.nBits, config))
+        {
+            ++header.nNonce;
+        }
+        return header;
+    }
+
+    // Insert a chain of count headers on top of prev into the store
+    const CBlockIndex* ExtendChain(
+        const Config& config,
+        BlockIndexStore& store,
+        const CBlockIndex& prev,
+        size_t count)
+    {
+        const CBlockIndex* tip = &prev;
+        for (size_t i = 0; i < count; ++i)
+        {
+            CBlockHeader header = tip->GetBlockHeader();
+            header.hashPrevBlock = tip->GetBlockHash();
+            header.nTime += 1;
+            header.nNonce = 0;
+            tip = store.Insert( SolveHeader(config, header) );
+        }
+        return tip;
+    }
+}
+
+BOOST_FIXTURE_TEST_SUITE(block_index_store_loader_tests, RegtestingSetup)
+
+BOOST_AUTO_TEST_CASE(parallel_load)
+{
+    const Config& config = GlobalConfig::GetConfig();
+
+    // Main chain with a few forks
+    BlockIndexStore source;
+    const CBlockIndex* genesis = source.Insert( config.GetChainParams().GenesisBlock() );
+    const CBlockIndex* tip = ExtendChain(config, source, *genesis, 1000);
+    ExtendChain(config, source, *tip->GetAncestor(500), 20);
+    ExtendChain(config, source, *tip->GetAncestor(900), 50);
+
+    CBlockTreeDB blockTree{ 1 << 20, true };
+    BOOST_REQUIRE(blockTree.WriteBatchSync({}, 0, source.ExtractDirtyBlockIndices()));
+
+    for (size_t numThreads : { 1, 3, 8, 300 })
+    {
+        BlockIndexStore loaded;
+        BOOST_REQUIRE(
+            BlockIndexStoreLoader(loaded).ForceLoad(
+                config,
+                [&]{ return blockTree.GetIterator(); },
+                numThreads));
+
+        BOOST_CHECK_EQUAL(loaded.Count(), source.Count());
+        source.ForEach(
+            [&](const CBlockIndex& expected)
+            {
+                const CBlockIndex* index = loaded.Get( expected.GetBlockHash() );
+                BOOST_REQUIRE(index);
+                BOOST_CHECK_EQUAL(index->GetHeight(), expected.GetHeight());
+                if (expected.GetPrev())
+                {
+                    BOOST_REQUIRE(index->GetPrev());
+                    BOOST_CHECK(index->GetPrev()->GetBlockHash() == expected.GetPrev()->GetBlockHash());
+                }
+                else
+                {
+                    BOOST_CHECK(index->GetPrev() == nullptr);
+                }
+            });
+    }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,153 @@
+// Copyright (c) 2024 Bitcoin Association
+// Distributed under the Open BSV software license, see the accompanying file LICENSE.
+
+#include "block_index_store.h"
+#include "block_tx_offsets.h"
+#include "config.h"
+#include "fs.h"
+#include "key.h"
+#include "script/sighashtype.h"
+#include "script/sign.h"
+#include "streams.h"
+#include "test/test_bitcoin.h"
+#include "util.h"
+#include "validation.h"
+
+#include <boost/test/unit_test.hpp>
+
+namespace
+{
+    // Block with the coinbase and transactions spending coinbases of the test
+    // chain starting with the given one to outputs of varying size
+    CBlock CreateBlockWithTransactions(TestChain100Setup& setup, size_t firstCoinbase, size_t numOfTxs)
+    {
+        CScript scriptPubKey = CScript() << ToByteVector(setup.coinbaseKey.GetPubKey()) << OP_CHECKSIG;
+        std::vector<CMutableTransaction> txns;
+        for (size_t i = 0; i < numOfTxs; ++i)
+        {
+            CMutableTransaction tx;
+            tx.nVersion = 1;
+            tx.vin.resize(1);
+            tx.vin[0].prevout = COutPoint(setup.coinbaseTxns[firstCoinbase + i].GetId(), 0);
+            tx.vout.resize(i + 1);
+            for (auto& out : tx.vout)
+            {
+                out.nValue = 11 * CENT;
+                out.scriptPubKey = scriptPubKey;
+            }
+
+            std::vector<uint8_t> vchSig;
+            uint256 hash = SignatureHash(scriptPubKey, CTransaction(tx), 0,
+                                         SigHashType().withForkId(),
+                                         setup.coinbaseTxns[firstCoinbase + i].vout[0].nValue);
+            BOOST_REQUIRE(setup.coinbaseKey.Sign(hash, vchSig));
+            vchSig.push_back(uint8_t(SIGHASH_ALL | SIGHASH_FORKID));
+            tx.vin[0].scriptSig << vchSig;
+            txns.push_back(tx);
+        }
+        return setup.CreateAndProcessBlock(txns, scriptPubKey);
+    }
+}
+
+BOOST_FIXTURE_TEST_SUITE(block_tx_offsets_tests, TestChain100Setup)
+
+BOOST_AUTO_TEST_CASE(tx_range)
+{
+    CBlockTxOffsets offsets{ { 81, 150, 300, 310 } };
+    BOOST_CHECK_EQUAL(offsets.GetTxCount(), 3U);
+    BOOST_CHECK_EQUAL(offsets.GetBlockSize(), 310U);
+    BOOST_CHECK_EQUAL(offsets.GetTxOffset(1), 150U);
+    BOOST_CHECK(offsets.GetTxRange(0, 3) == std::make_pair(uint64_t{81}, uint64_t{229}));
+    BOOST_CHECK(offsets.GetTxRange(1, 1) == std::make_pair(uint64_t{150}, uint64_t{150}));
+    BOOST_CHECK_THROW(offsets.GetTxRange(2, 2), std::out_of_range);
+
+    BOOST_CHECK_THROW(CBlockTxOffsets{ {} }, std::invalid_argument);
+}
+
+BOOST_AUTO_TEST_CASE(scan_block)
+{
+    const CBlock block = CreateBlockWithTransactions(*this, 0, 4);
+    const CBlockIndex* index = mapBlockIndex.Get(block.GetHash());
+    BOOST_REQUIRE(index);
+    BOOST_REQUIRE_EQUAL(index->GetBlockTxCount(), 5U);
+
+    std::vector<TxId> txids;
+    auto offsets = ScanBlockTransactions(*index, true,
+        [&txids](uint64_t, const TxId& txid) { txids.push_back(txid); });
+    BOOST_REQUIRE(offsets);
+    BOOST_REQUIRE_EQUAL(offsets->GetTxCount(), block.vtx.size());
+    BOOST_CHECK_EQUAL(offsets->GetBlockSize(), ::GetSerializeSize(block, SER_NETWORK, PROTOCOL_VERSION));
+
+    // Every transaction is found at its offset in the serialised block
+    CDataStream ssBlock(SER_NETWORK, PROTOCOL_VERSION);
+    ssBlock << block;
+    for (size_t i = 0; i < block.vtx.size(); ++i)
+    {
+        BOOST_CHECK(txids[i] == block.vtx[i]->GetId());
+
+        const auto [offset, size] = offsets->GetTxRange(i, 1);
+        BOOST_CHECK_EQUAL(size, ::GetSerializeSize(*block.vtx[i], SER_NETWORK, PROTOCOL_VERSION));
+        CDataStream ssTx(ssBlock.begin() + offset, ssBlock.begin() + offset + size, SER_NETWORK, PROTOCOL_VERSION);
+        CMutableTransaction tx;
+        ssTx >> tx;
+        BOOST_CHECK(tx.GetId() == block.vtx[i]->GetId());
+    }
+
+    // Cached offsets are the same as the scanned ones
+    auto cached = GetBlockTxOffsets(*index);
+    BOOST_REQUIRE(cached);
+    BOOST_CHECK(GetBlockTxOffsets(*index) == cached);
+    for (size_t i = 0; i <= block.vtx.size(); ++i)
+    {
+        BOOST_CHECK_EQUAL(cached->GetTxOffset(i), offsets->GetTxOffset(i));
+    }
+}
+
+BOOST_AUTO_TEST_CASE(tx_offsets_file)
+{
+    // Only blocks with enough transactions get a file
+    SetBlockTxOffsetsFileMinTxs(3);
+    const CBlock smallBlock = CreateBlockWithTransactions(*this, 0, 1);
+    const CBlock block = CreateBlockWithTransactions(*this, 1, 4);
+    SetBlockTxOffsetsFileMinTxs(DEFAULT_BLOCK_TX_OFFSETS_FILE_MIN_TXS);
+
+    const CBlockIndex* smallIndex = mapBlockIndex.Get(smallBlock.GetHash());
+    const CBlockIndex* index = mapBlockIndex.Get(block.GetHash());
+    BOOST_REQUIRE(smallIndex);
+    BOOST_REQUIRE(index);
+    const fs::path dir = GetDataDir() / "blocks" / strprintf("txo%05u", index->GetBlockPos().File());
+    BOOST_CHECK(!fs::exists(dir / (smallBlock.GetHash().GetHex() + ".dat")));
+    BOOST_CHECK(fs::exists(dir / (block.GetHash().GetHex() + ".dat")));
+
+    // Offsets read from the file are the same as the scanned ones
+    auto offsets = GetBlockTxOffsets(*index);
+    auto scanned = ScanBlockTransactions(*index, false);
+    BOOST_REQUIRE(offsets);
+    BOOST_REQUIRE(scanned);
+    BOOST_REQUIRE_EQUAL(offsets->GetTxCount(), scanned->GetTxCount());
+    for (size_t i = 0; i <= block.vtx.size(); ++i)
+    {
+        BOOST_CHECK_EQUAL(offsets->GetTxOffset(i), scanned->GetTxOffset(i));
+    }
+
+    // Transactions are found with and without the file
+    for (const CBlock* b : { &block, &smallBlock })
+    {
+        const CBlockIndex* blockIndex = mapBlockIndex.Get(b->GetHash());
+        for (const auto& tx : b->vtx)
+        {
+            CTransactionRef found = ReadBlockTransaction(*blockIndex, tx->GetId());
+            BOOST_REQUIRE(found);
+            BOOST_CHECK(found->GetId() == tx->GetId());
+        }
+        BOOST_CHECK(!ReadBlockTransaction(*blockIndex, TxId{ InsecureRand256() }));
+    }
+    BOOST_CHECK(!ReadBlockTransaction(*index, smallBlock.vtx[1]->GetId()));
+
+    // Files are removed together with the block file
+    RemoveBlockTxOffsetsFiles(index->GetBlockPos().File());
+    BOOST_CHECK(!fs::exists(dir));
+    BOOST_CHECK(ReadBlockTransaction(*index, block.vtx[2]->GetId()));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -405,6 +405,61 @@ BOOST_AUTO_TEST_CASE(EmptyBlockRoundTripTest) {
     }
 }
 
+BOOST_AUTO_TEST_CASE(LargeMempoolRoundTripTest) {
+    CTxMemPool pool;
+    TestMemPoolEntryHelper entry(DEFAULT_TEST_TX_FEE);
+    CBlock block(BuildBlockTestCase());
+
+    // Enough unrelated transactions for the mempool to be scanned on
+    // several threads.
+    constexpr size_t NUM_UNRELATED {50000};
+    std::set<TxId> unrelated {};
+    for (size_t i = 0; i < NUM_UNRELATED; ++i) {
+        CMutableTransaction tx;
+        tx.vin.resize(1);
+        tx.vin[0].prevout = COutPoint(InsecureRand256(), 0);
+        tx.vout.resize(1);
+        tx.vout[0].nValue = Amount(42);
+        const CTransaction transaction {tx};
+        pool.AddUnchecked(transaction.GetId(), entry.FromTx(transaction), TxStorage::memory, nullChangeSet);
+        unrelated.insert(transaction.GetId());
+    }
+    pool.AddUnchecked(block.vtx[1]->GetId(), entry.FromTx(*block.vtx[1]), TxStorage::memory, nullChangeSet);
+    pool.AddUnchecked(block.vtx[2]->GetId(), entry.FromTx(*block.vtx[2]), TxStorage::memory, nullChangeSet);
+
+    // Filtering returns exactly the accepted transactions regardless of the
+    // number of threads.
+    for (size_t threads : {1, 2, 7}) {
+        const auto found = pool.GetTransactions(
+            [&unrelated](const TxId& txid) { return unrelated.count(txid) == 0; },
+            threads);
+        BOOST_CHECK_EQUAL(found.size(), 2U);
+        for (const auto& tx : found) {
+            BOOST_CHECK(tx->GetId() == block.vtx[1]->GetId() ||
+                        tx->GetId() == block.vtx[2]->GetId());
+        }
+        BOOST_CHECK_EQUAL(
+            pool.GetTransactions([](const TxId&) { return true; }, threads).size(),
+            NUM_UNRELATED + 2);
+    }
+
+    CBlockHeaderAndShortTxIDs shortIDs(block);
+    CDataStream stream(SER_NETWORK, PROTOCOL_VERSION);
+    stream << shortIDs;
+    CBlockHeaderAndShortTxIDs shortIDs2;
+    stream >> shortIDs2;
+
+    PartiallyDownloadedBlock partialBlock(GlobalConfig::GetConfig(), &pool);
+    BOOST_CHECK(partialBlock.InitData(shortIDs2, extra_txn) == READ_STATUS_OK);
+    BOOST_CHECK(partialBlock.IsTxAvailable(0));
+    BOOST_CHECK(partialBlock.IsTxAvailable(1));
+    BOOST_CHECK(partialBlock.IsTxAvailable(2));
+
+    CBlock block2;
+    BOOST_CHECK(partialBlock.FillBlock(block2, {}, 0) == READ_STATUS_OK);
+    BOOST_CHECK_EQUAL(block.GetHash().ToString(), block2.GetHash().ToString());
+}
+
 BOOST_AUTO_TEST_CASE(TransactionsRequestSerializationTest) {
     BlockTransactionsRequest req1;
     req1.blockhash = InsecureRand256();
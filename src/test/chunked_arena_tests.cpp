@@ -0,0 +1,82 @@
+// Copyright (c) 2024 Bitcoin Association
+// Distributed under the Open BSV software license, see the accompanying file LICENSE.
+
+#include "chunked_arena.h"
+
+#include <boost/test/unit_test.hpp>
+
+#include <string>
+#include <vector>
+
+namespace
+{
+    // Records destruction order
+    struct Tracked
+    {
+        Tracked(int idIn, std::vector<int>& destroyedIn)
+            : id{idIn}, destroyed{destroyedIn}
+        {}
+        Tracked(const Tracked&) = delete;
+        Tracked& operator=(const Tracked&) = delete;
+        ~Tracked() { destroyed.push_back(id); }
+
+        int id;
+        std::vector<int>& destroyed;
+    };
+}
+
+BOOST_AUTO_TEST_SUITE(chunked_arena_tests)
+
+BOOST_AUTO_TEST_CASE(emplace_and_access)
+{
+    ChunkedArena<std::string, 4> arena;
+    BOOST_CHECK_EQUAL(arena.Size(), 0U);
+
+    std::vector<const std::string*> addresses;
+    for (int i = 0; i < 10; ++i)
+    {
+        addresses.push_back( &arena.Emplace(std::to_string(i)) );
+    }
+    BOOST_CHECK_EQUAL(arena.Size(), 10U);
+
+    // Objects don't move when new chunks are added
+    for (size_t i = 0; i < addresses.size(); ++i)
+    {
+        BOOST_CHECK_EQUAL(&arena[i], addresses[i]);
+        BOOST_CHECK_EQUAL(arena[i], std::to_string(i));
+    }
+
+    // Objects within one chunk are contiguous
+    BOOST_CHECK_EQUAL(addresses[1], addresses[0] + 1);
+    BOOST_CHECK_EQUAL(addresses[3], addresses[0] + 3);
+
+    std::vector<std::string> visited;
+    arena.ForEach([&](const std::string& s){ visited.push_back(s); });
+    BOOST_CHECK_EQUAL(visited.size(), 10U);
+    BOOST_CHECK_EQUAL(visited.front(), "0");
+    BOOST_CHECK_EQUAL(visited.back(), "9");
+}
+
+BOOST_AUTO_TEST_CASE(clear_destroys_in_reverse_order)
+{
+    std::vector<int> destroyed;
+    {
+        ChunkedArena<Tracked, 2> arena;
+        for (int i = 0; i < 5; ++i)
+        {
+            arena.Emplace(i, destroyed);
+        }
+        arena.Clear();
+        BOOST_CHECK_EQUAL(arena.Size(), 0U);
+        BOOST_CHECK((destroyed == std::vector<int>{4, 3, 2, 1, 0}));
+
+        // Arena can be reused after it was cleared
+        destroyed.clear();
+        arena.Emplace(7, destroyed);
+        BOOST_CHECK_EQUAL(arena[0].id, 7);
+    }
+    // Destructor destroys remaining objects
+    BOOST_CHECK((destroyed == std::vector<int>{7}));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,165 @@
+// Copyright (c) 2024 Bitcoin Association
+// Distributed under the Open BSV software license, see the accompanying file LICENSE.
+
+#include "compact_txindex.h"
+#include "chain.h"
+#include "fs.h"
+#include "test/test_bitcoin.h"
+#include "txdb.h"
+#include "util.h"
+#include "validation.h"
+
+#include <boost/test/unit_test.hpp>
+
+namespace
+{
+    TxId MakeTxId(uint64_t prefix, uint8_t suffix)
+    {
+        uint256 id;
+        WriteLE64(id.begin(), prefix);
+        *(id.end() - 1) = suffix;
+        return TxId{ id };
+    }
+
+    CCompactTxIndexEntry MakeEntry(uint64_t prefix, int32_t height)
+    {
+        return { prefix, height, static_cast<uint64_t>(height) * 100 + 1 };
+    }
+
+    size_t Count(const CCompactTxIndex& index, uint64_t prefix, int32_t height)
+    {
+        const auto entries = index.Find(MakeTxId(prefix, 0));
+        return std::count(entries.begin(), entries.end(), MakeEntry(prefix, height));
+    }
+}
+
+BOOST_FIXTURE_TEST_SUITE(compact_txindex_tests, BasicTestingSetup)
+
+BOOST_AUTO_TEST_CASE(add_flush_reopen)
+{
+    const fs::path dir = GetDataDir() / "compact_txindex";
+    const uint256 best = MakeTxId(12345, 1);
+    {
+        CCompactTxIndex index{ dir, true, 4 };
+        BOOST_CHECK(index.GetBestBlock().IsNull());
+        BOOST_CHECK(index.AddEntries({ MakeEntry(1, 1), MakeEntry(2, 1) }));
+        // Found in the buffer
+        BOOST_CHECK_EQUAL(Count(index, 1, 1), 1U);
+        BOOST_CHECK_EQUAL(index.GetSegmentCount(), 0U);
+
+        BOOST_CHECK(index.AddEntries({ MakeEntry(3, 2), MakeEntry(1, 2) }));
+        // Buffer was full and has been written to a segment
+        BOOST_CHECK_EQUAL(index.GetSegmentCount(), 1U);
+        BOOST_CHECK_EQUAL(Count(index, 1, 1), 1U);
+        BOOST_CHECK_EQUAL(Count(index, 1, 2), 1U);
+
+        BOOST_CHECK(index.AddEntries({ MakeEntry(4, 3) }));
+        BOOST_CHECK(index.Flush(best));
+        BOOST_CHECK(index.GetBestBlock() == best);
+    }
+
+    // Leftovers of an interrupted write are removed
+    fs::ofstream{ dir / "seg99999999.dat.new" } << "x";
+
+    {
+        CCompactTxIndex index{ dir, false, 4 };
+        BOOST_CHECK(index.GetBestBlock() == best);
+        BOOST_CHECK_EQUAL(Count(index, 1, 1), 1U);
+        BOOST_CHECK_EQUAL(Count(index, 1, 2), 1U);
+        BOOST_CHECK_EQUAL(Count(index, 4, 3), 1U);
+        BOOST_CHECK(index.Find(MakeTxId(5, 0)).empty());
+        BOOST_CHECK(!fs::exists(dir / "seg99999999.dat.new"));
+    }
+
+    // Entries that were not flushed are lost, wiping removes everything
+    {
+        CCompactTxIndex index{ dir, false, 4 };
+        BOOST_CHECK(index.AddEntries({ MakeEntry(5, 4) }));
+    }
+    {
+        CCompactTxIndex index{ dir, false, 4 };
+        BOOST_CHECK(index.Find(MakeTxId(5, 0)).empty());
+    }
+    {
+        CCompactTxIndex index{ dir, true, 4 };
+        BOOST_CHECK(index.GetBestBlock().IsNull());
+        BOOST_CHECK(index.Find(MakeTxId(1, 0)).empty());
+    }
+}
+
+BOOST_AUTO_TEST_CASE(merge_segments)
+{
+    const fs::path dir = GetDataDir() / "compact_txindex";
+    CCompactTxIndex index{ dir, true, 2 };
+
+    // Every other call writes a segment, segments of similar size are merged
+    constexpr int32_t count = 2000;
+    for (int32_t i = 0; i < count; ++i)
+    {
+        BOOST_CHECK(index.AddEntries({ MakeEntry(static_cast<uint64_t>(i % 7) << 60 | i, i) }));
+    }
+    BOOST_CHECK(index.Flush(MakeTxId(1, 1)));
+    BOOST_CHECK_LE(index.GetSegmentCount(), 11U);
+
+    // Duplicates are dropped when merging
+    BOOST_CHECK(index.AddEntries({ MakeEntry(7, count), MakeEntry(7, count) }));
+    BOOST_CHECK(index.Flush(MakeTxId(1, 1)));
+
+    CCompactTxIndex reopened{ dir, false, 2 };
+    BOOST_CHECK_EQUAL(reopened.GetSegmentCount(), index.GetSegmentCount());
+    for (int32_t i = 0; i < count; ++i)
+    {
+        BOOST_CHECK_EQUAL(Count(reopened, static_cast<uint64_t>(i % 7) << 60 | i, i), 1U);
+    }
+    BOOST_CHECK_EQUAL(Count(reopened, 7, count), 1U);
+}
+
+BOOST_AUTO_TEST_CASE(prefix_collision)
+{
+    CCompactTxIndex index{ GetDataDir() / "compact_txindex", true, 1000 };
+    const TxId first = MakeTxId(42, 1);
+    const TxId second = MakeTxId(42, 2);
+    BOOST_CHECK_EQUAL(CCompactTxIndex::GetTxIdPrefix(first), CCompactTxIndex::GetTxIdPrefix(second));
+
+    BOOST_CHECK(index.AddEntries({ MakeEntry(42, 1), MakeEntry(42, 2), MakeEntry(43, 3) }));
+    BOOST_CHECK_EQUAL(index.Find(first).size(), 2U);
+    BOOST_CHECK(index.Flush(MakeTxId(1, 1)));
+    BOOST_CHECK_EQUAL(index.Find(second).size(), 2U);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+BOOST_FIXTURE_TEST_SUITE(compact_txindex_chain_tests, TestChain100Setup)
+
+BOOST_AUTO_TEST_CASE(sync_and_find)
+{
+    CCompactTxIndex index{ GetDataDir() / "blocks" / "txindex", true };
+
+    LOCK(cs_main);
+    BOOST_CHECK(SyncCompactTxIndex(index, *pblocktree, chainActive));
+    BOOST_CHECK(index.GetBestBlock() == chainActive.Tip()->GetBlockHash());
+
+    for (size_t i = 0; i < coinbaseTxns.size(); i += 10)
+    {
+        CTransactionRef tx;
+        const CBlockIndex* blockIndex{ nullptr };
+        BOOST_CHECK(FindTransactionInCompactTxIndex(index, chainActive, coinbaseTxns[i].GetId(), tx, blockIndex));
+        BOOST_REQUIRE(tx);
+        BOOST_CHECK(tx->GetId() == coinbaseTxns[i].GetId());
+        BOOST_REQUIRE(blockIndex);
+        BOOST_CHECK_EQUAL(blockIndex->GetHeight(), static_cast<int32_t>(i) + 1);
+    }
+
+    // Same prefix as an existing transaction but a different id
+    uint256 id = coinbaseTxns[0].GetId();
+    *(id.end() - 1) ^= 1;
+    CTransactionRef tx;
+    const CBlockIndex* blockIndex{ nullptr };
+    BOOST_CHECK(!FindTransactionInCompactTxIndex(index, chainActive, TxId{ id }, tx, blockIndex));
+
+    // Nothing to add when the index is up to date
+    BOOST_CHECK(SyncCompactTxIndex(index, *pblocktree, chainActive));
+    BOOST_CHECK_EQUAL(index.Find(coinbaseTxns[0].GetId()).size(), 1U);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -356,6 +356,61 @@ BOOST_AUTO_TEST_CASE(group) {
 }
 
 
+BOOST_AUTO_TEST_CASE(eviction_batch) {
+    MempoolMockup mempool;
+    auto confirmedEntry = std::make_tuple<TxId, int, Amount>(TxId(), 0, Amount(100000000));
+    auto entry = MakeEntry(1,{confirmedEntry}, {}, 100, 0);
+    mempool.AddTx(entry);
+
+    // two fee rate groups which are far enough apart to never share a bucket
+    for(int i = 0; i < 100; i++)
+    {
+        auto feerate = (i % 2 == 0) ? 10 + (i * 0.001) : 1000 + (i * 0.001);
+        mempool.AddTx(MakeEntry(feerate, {}, { std::make_tuple<CTransactionRef, int>(entry.GetSharedTx(), std::move(i))}, 1, 0));
+    }
+    mempool.InitializeTracker();
+
+    auto feeRate = [](CTxMemPoolTestAccess::txiter it) { return double(it->GetFee().GetSatoshis()) / it->GetTxSize(); };
+    auto usage = [](CTxMemPoolTestAccess::txiter it) { return it->DynamicMemoryUsage(); };
+
+    // a single candidate is returned even if nothing needs to be freed
+    auto batch = mempool.tracker->GetEvictionBatch(0, usage);
+    BOOST_CHECK_EQUAL(batch.size(), 1U);
+    BOOST_CHECK_EQUAL(feeRate(batch.front()), feeRate(mempool.tracker->GetMostWorthless()));
+
+    // a part of the lowest bucket, the most worthless candidates first
+    batch = mempool.tracker->GetEvictionBatch(batch.front()->DynamicMemoryUsage() * 10, usage);
+    BOOST_CHECK_EQUAL(batch.size(), 10U);
+    for(size_t i = 1; i < batch.size(); i++)
+    {
+        BOOST_CHECK(feeRate(batch[i - 1]) <= feeRate(batch[i]));
+    }
+
+    // the whole lowest bucket and a part of the next one
+    size_t lowBytes = 0;
+    for(const auto& candidate: mempool.tracker->GetAllCandidates())
+    {
+        if(feeRate(candidate) < 100)
+        {
+            lowBytes += candidate->DynamicMemoryUsage();
+        }
+    }
+    batch = mempool.tracker->GetEvictionBatch(lowBytes + 1, usage);
+    BOOST_CHECK_EQUAL(batch.size(), 51U);
+    BOOST_CHECK_EQUAL(std::count_if(batch.begin(), batch.end(), [&](auto it) { return feeRate(it) < 100; }), 50);
+
+    // everything if more memory is needed than candidates take
+    batch = mempool.tracker->GetEvictionBatch(std::numeric_limits<size_t>::max(), usage);
+    BOOST_CHECK_EQUAL(batch.size(), 100U);
+
+    for(auto it: batch)
+    {
+        mempool.RemoveTx(it);
+    }
+    BOOST_CHECK_EQUAL(mempool.tracker->GetAllCandidates().size(), 1U);
+    BOOST_CHECK_EQUAL(mempool.tracker->GetEvictionBatch(1, usage).size(), 1U);
+}
+
 BOOST_AUTO_TEST_CASE(performance, * boost::unit_test::disabled()) {
     MempoolMockup mempool;
     
@@ -0,0 +1,76 @@
+// Copyright (c) 2024 Bitcoin Association
+// Distributed under the Open BSV software license, see the accompanying file LICENSE.
+
+#include "httpworkqueue.h"
+#include "net/netbase.h"
+
+#include <string>
+#include <vector>
+
+#include <boost/test/unit_test.hpp>
+
+namespace
+{
+    CNetAddr ResolveIP(const char* ip)
+    {
+        CNetAddr addr;
+        LookupHost(ip, addr, false);
+        return addr;
+    }
+
+    // Run all queued requests and return the order they were run in
+    std::vector<std::string> RunAll(CHTTPWorkQueue& queue, std::vector<std::string>& log)
+    {
+        while(std::optional<CHTTPWorkQueue::Closure> closure = queue.Pop())
+        {
+            (*closure)();
+        }
+        std::vector<std::string> order {};
+        order.swap(log);
+        return order;
+    }
+}
+
+BOOST_AUTO_TEST_SUITE(httpworkqueue_tests)
+
+BOOST_AUTO_TEST_CASE(empty)
+{
+    CHTTPWorkQueue queue {};
+    BOOST_CHECK_EQUAL(queue.Size(), 0U);
+    BOOST_CHECK(!queue.Pop());
+}
+
+BOOST_AUTO_TEST_CASE(fair_across_clients)
+{
+    CHTTPWorkQueue queue {};
+    std::vector<std::string> log {};
+    auto request = [&log](const std::string& name) { return [&log, name]() { log.push_back(name); }; };
+
+    const CNetAddr a { ResolveIP("10.0.0.1") };
+    const CNetAddr b { ResolveIP("10.0.0.2") };
+    const CNetAddr c { ResolveIP("10.0.0.3") };
+
+    // Burst from one client followed by single requests from others
+    queue.Push(a, request("a1"));
+    queue.Push(a, request("a2"));
+    queue.Push(a, request("a3"));
+    queue.Push(b, request("b1"));
+    queue.Push(c, request("c1"));
+    queue.Push(b, request("b2"));
+    BOOST_CHECK_EQUAL(queue.Size(), 6U);
+
+    std::vector<std::string> expected { "a1", "b1", "c1", "a2", "b2", "a3" };
+    std::vector<std::string> order { RunAll(queue, log) };
+    BOOST_CHECK_EQUAL_COLLECTIONS(order.begin(), order.end(), expected.begin(), expected.end());
+    BOOST_CHECK_EQUAL(queue.Size(), 0U);
+
+    // Client that was just served goes behind the clients already waiting
+    queue.Push(a, request("a4"));
+    queue.Push(b, request("b3"));
+    queue.Push(a, request("a5"));
+    expected = { "a4", "b3", "a5" };
+    order = RunAll(queue, log);
+    BOOST_CHECK_EQUAL_COLLECTIONS(order.begin(), order.end(), expected.begin(), expected.end());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
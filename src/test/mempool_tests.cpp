@@ -9,6 +9,7 @@
 #include "txmempool.h"
 #include "util.h"
 #include "validation.h"
+#include "validationinterface.h"
 
 #include "mempool_test_access.h"
 
@@ -17,6 +18,7 @@
 
 #include <boost/test/unit_test.hpp>
 #include <list>
+#include <thread>
 #include <vector>
 
 namespace
@@ -805,4 +807,156 @@ BOOST_AUTO_TEST_CASE(rolling_min_tests)
     BOOST_CHECK_EQUAL(CTxMemPool::MAX_ROLLING_FEE_HALFLIFE, pool.GetRollingMinFee());
 }
 
+BOOST_AUTO_TEST_CASE(MempoolConcurrentAddTest) {
+    // Entries added concurrently without a change set are committed in
+    // batches; every entry must be added exactly once with correct links.
+    constexpr int NUM_THREADS = 8;
+    constexpr int CHAIN_LENGTH = 50;
+
+    TestMemPoolEntryHelper entry(DEFAULT_TEST_TX_FEE);
+    std::vector<std::vector<CTransactionRef>> chains(NUM_THREADS);
+    for (auto& chain : chains) {
+        CMutableTransaction tx;
+        tx.vin.resize(1);
+        tx.vin[0].prevout = COutPoint(InsecureRand256(), 0);
+        tx.vin[0].scriptSig = CScript() << OP_11;
+        tx.vout.resize(1);
+        tx.vout[0].scriptPubKey = CScript() << OP_11 << OP_EQUAL;
+        tx.vout[0].nValue = Amount(33000LL);
+        for (int i = 0; i < CHAIN_LENGTH; i++) {
+            chain.push_back(MakeTransactionRef(tx));
+            tx.vin[0].prevout = COutPoint(chain.back()->GetId(), 0);
+        }
+    }
+
+    CTxMemPool testPool;
+    CTxMemPoolTestAccess testPoolAccess{testPool};
+    std::vector<std::thread> threads;
+    for (const auto& chain : chains) {
+        threads.emplace_back(
+            [&testPool, &entry, &chain] {
+                for (const auto& ptx : chain) {
+                    testPool.AddUnchecked(ptx->GetId(), entry.FromTx(*ptx), TxStorage::memory, nullChangeSet);
+                }
+            });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    BOOST_CHECK_EQUAL(testPool.Size(), static_cast<size_t>(NUM_THREADS * CHAIN_LENGTH));
+    BOOST_CHECK_EQUAL(testPoolAccess.mapNextTx().size(), static_cast<size_t>(NUM_THREADS * CHAIN_LENGTH));
+    BOOST_CHECK_EQUAL(testPool.CheckJournal(), "");
+
+    // Parent/child links must be intact: removing the first txn of a chain
+    // removes the whole chain.
+    for (const auto& chain : chains) {
+        const size_t sizeBefore = testPool.Size();
+        testPoolAccess.RemoveRecursive(*chain[0], nullChangeSet);
+        BOOST_CHECK_EQUAL(sizeBefore - testPool.Size(), static_cast<size_t>(CHAIN_LENGTH));
+    }
+    BOOST_CHECK_EQUAL(testPool.Size(), 0UL);
+}
+
+BOOST_AUTO_TEST_CASE(MempoolViewTest) {
+    TestMemPoolEntryHelper entry(DEFAULT_TEST_TX_FEE);
+    CMutableTransaction txParent;
+    txParent.vin.resize(1);
+    txParent.vin[0].prevout = COutPoint(InsecureRand256(), 0);
+    txParent.vin[0].scriptSig = CScript() << OP_11;
+    txParent.vout.resize(1);
+    txParent.vout[0].scriptPubKey = CScript() << OP_11 << OP_EQUAL;
+    txParent.vout[0].nValue = Amount(33000LL);
+    CMutableTransaction txChild {txParent};
+    txChild.vin[0].prevout = COutPoint(txParent.GetId(), 0);
+
+    CTxMemPool testPool;
+    const auto emptyView = testPool.GetView(std::chrono::milliseconds{0});
+    BOOST_CHECK(emptyView->empty());
+    // An unchanged mempool gives the same view.
+    BOOST_CHECK(testPool.GetView(std::chrono::milliseconds{0}) == emptyView);
+
+    testPool.AddUnchecked(txParent.GetId(), entry.FromTx(txParent), TxStorage::memory, nullChangeSet);
+    // A view that is too old is not reused once the mempool has changed...
+    const auto parentView = testPool.GetView(std::chrono::milliseconds{0});
+    BOOST_CHECK(parentView != emptyView);
+    BOOST_CHECK_EQUAL(parentView->size(), 1U);
+    BOOST_CHECK_EQUAL(parentView->GetTotalTxSize(), testPool.GetTotalTxSize());
+
+    // ...but one that is young enough is.
+    testPool.AddUnchecked(txChild.GetId(), entry.FromTx(txChild), TxStorage::memory, nullChangeSet);
+    BOOST_CHECK(testPool.GetView(std::chrono::hours{1}) == parentView);
+
+    const auto view = testPool.GetView(std::chrono::milliseconds{0});
+    BOOST_CHECK_EQUAL(view->size(), 2U);
+    const auto* parent = view->Find(txParent.GetId());
+    const auto* child = view->Find(txChild.GetId());
+    BOOST_REQUIRE(parent != nullptr);
+    BOOST_REQUIRE(child != nullptr);
+    BOOST_CHECK(view->Find(InsecureRand256()) == nullptr);
+    BOOST_CHECK(parent->depends.empty());
+    BOOST_REQUIRE_EQUAL(child->depends.size(), 1U);
+    BOOST_CHECK(child->depends[0] == txParent.GetId());
+    BOOST_CHECK_EQUAL(child->fee, DEFAULT_TEST_TX_FEE);
+
+    // Prioritisation changes the mempool too.
+    testPool.PrioritiseTransaction(txChild.GetId(), txChild.GetId().ToString(), Amount{1000});
+    const auto prioritisedView = testPool.GetView(std::chrono::milliseconds{0});
+    BOOST_CHECK(prioritisedView != view);
+    BOOST_CHECK_EQUAL(prioritisedView->Find(txChild.GetId())->modifiedFee, DEFAULT_TEST_TX_FEE + Amount{1000});
+}
+
+BOOST_AUTO_TEST_CASE(MempoolDeltaTest) {
+    TestMemPoolEntryHelper entry(DEFAULT_TEST_TX_FEE);
+    CMutableTransaction txParent;
+    txParent.vin.resize(1);
+    txParent.vin[0].prevout = COutPoint(InsecureRand256(), 0);
+    txParent.vin[0].scriptSig = CScript() << OP_11;
+    txParent.vout.resize(1);
+    txParent.vout[0].scriptPubKey = CScript() << OP_11 << OP_EQUAL;
+    txParent.vout[0].nValue = Amount(33000LL);
+    CMutableTransaction txChild {txParent};
+    txChild.vin[0].prevout = COutPoint(txParent.GetId(), 0);
+
+    CTxMemPool testPool;
+    CTxMemPoolTestAccess testPoolAccess{testPool};
+    std::vector<CMempoolDelta> deltas;
+    boost::signals2::scoped_connection connection {
+        GetMainSignals().MempoolDelta.connect(
+            [&deltas](const CMempoolDelta& delta) { deltas.push_back(delta); })};
+
+    testPool.AddUnchecked(txParent.GetId(), entry.FromTx(txParent), TxStorage::memory, nullChangeSet);
+    testPool.AddUnchecked(txChild.GetId(), entry.FromTx(txChild), TxStorage::memory, nullChangeSet);
+
+    // The view knows which deltas it contains.
+    const auto view = testPool.GetView(std::chrono::milliseconds{0});
+    BOOST_CHECK_EQUAL(view->GetDeltaSequence(), 2U);
+
+    testPoolAccess.RemoveRecursive(CTransaction{txParent}, nullChangeSet);
+    BOOST_CHECK_EQUAL(testPool.Size(), 0UL);
+
+    BOOST_REQUIRE_EQUAL(deltas.size(), 4U);
+    for (size_t i = 0; i < deltas.size(); ++i)
+    {
+        BOOST_CHECK_EQUAL(deltas[i].sequence, i + 1);
+        BOOST_CHECK_EQUAL(deltas[i].fee, DEFAULT_TEST_TX_FEE);
+    }
+    BOOST_CHECK(deltas[0].type == CMempoolDelta::Type::ADDED);
+    BOOST_CHECK(deltas[0].txid == txParent.GetId());
+    BOOST_CHECK_EQUAL(deltas[0].size, CTransaction{txParent}.GetTotalSize());
+    BOOST_CHECK(deltas[1].type == CMempoolDelta::Type::ADDED);
+    BOOST_CHECK(deltas[1].txid == txChild.GetId());
+    BOOST_CHECK(deltas[2].type == CMempoolDelta::Type::REMOVED);
+    BOOST_CHECK(deltas[3].type == CMempoolDelta::Type::REMOVED);
+    BOOST_CHECK((std::set<TxId>{deltas[2].txid, deltas[3].txid} ==
+                 std::set<TxId>{txParent.GetId(), txChild.GetId()}));
+
+    // Clearing the mempool leaves a gap in the sequence.
+    testPool.AddUnchecked(txParent.GetId(), entry.FromTx(txParent), TxStorage::memory, nullChangeSet);
+    testPool.Clear();
+    testPool.AddUnchecked(txParent.GetId(), entry.FromTx(txParent), TxStorage::memory, nullChangeSet);
+    BOOST_REQUIRE_EQUAL(deltas.size(), 6U);
+    BOOST_CHECK_EQUAL(deltas[5].sequence, deltas[4].sequence + 2);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -228,6 +228,41 @@ BOOST_AUTO_TEST_CASE(merkle_tree_test)
     }
 }
 
+BOOST_AUTO_TEST_CASE(merkle_tree_transaction_indices)
+{
+    CBlock block;
+    block.vtx.resize(101);
+    for (size_t txIndex = 0; txIndex < block.vtx.size(); ++txIndex)
+    {
+        CMutableTransaction mtx;
+        mtx.nLockTime = txIndex;
+        block.vtx[txIndex] = MakeTransactionRef(std::move(mtx));
+    }
+    CMerkleTree merkleTree(block.vtx, uint256(), 0);
+
+    // Unknown and repeated transaction ids are allowed in the request
+    const TxId unknownTxId{ InsecureRand256() };
+    std::vector<TxId> txIds{ block.vtx[100]->GetId(), unknownTxId, block.vtx[0]->GetId(), block.vtx[57]->GetId(), block.vtx[100]->GetId() };
+    auto indices = merkleTree.GetTransactionIndices(txIds);
+    BOOST_CHECK_EQUAL(indices.size(), 3U);
+    BOOST_CHECK(indices.count(unknownTxId) == 0);
+    for (size_t txIndex : { 0, 57, 100 })
+    {
+        const TxId txId = block.vtx[txIndex]->GetId();
+        BOOST_REQUIRE(indices.count(txId));
+        BOOST_CHECK_EQUAL(indices[txId], txIndex);
+
+        // Proofs by index are the same as proofs by transaction id
+        CMerkleTree::MerkleProof proof = merkleTree.GetMerkleProof(indices[txId], false);
+        BOOST_CHECK_EQUAL(proof.transactionIndex, txIndex);
+        BOOST_CHECK(proof.merkleTreeHashes == merkleTree.GetMerkleProof(txId, false).merkleTreeHashes);
+        BOOST_CHECK(ComputeMerkleRootFromBranch(txId, proof.merkleTreeHashes, txIndex) == BlockMerkleRoot(block));
+    }
+
+    BOOST_CHECK(CMerkleTree().GetTransactionIndices(txIds).empty());
+    BOOST_CHECK(merkleTree.GetTransactionIndices({}).empty());
+}
+
 BOOST_AUTO_TEST_SUITE_END()
 
 BOOST_AUTO_TEST_SUITE(merkle_proof_tests)
@@ -163,6 +163,9 @@ BOOST_AUTO_TEST_CASE(getlocator_test) {
                               dist);
             dist *= 2;
         }
+
+        // Locator built from the skip list only must be the same.
+        BOOST_CHECK(GetBlockIndexLocator(*tip).vHave == locator.vHave);
     }
 }
 
@@ -10,7 +10,9 @@
 #include "test/test_bitcoin.h"
 
 #include <boost/test/unit_test.hpp>
+#include <atomic>
 #include <memory>
+#include <thread>
 
 using namespace std;
 
@@ -140,4 +142,72 @@ BOOST_AUTO_TEST_CASE(test_detector_clear_txn_inputs)
     BOOST_CHECK(dsDetector.getKnownSpendsSize() == 0);
 }
 
+BOOST_AUTO_TEST_CASE(test_detector_concurrent_insert_txn_inputs)
+{
+    CTxnDoubleSpendDetector dsDetector;
+
+    // Every thread gets its own txn from each group and all txns in a group
+    // spend one common input (at a different position) besides their own.
+    constexpr size_t NUM_THREADS = 8;
+    constexpr size_t NUM_GROUPS = 500;
+    std::vector<std::vector<CTransactionRef>> txns(NUM_THREADS);
+    for(size_t group = 0; group < NUM_GROUPS; ++group)
+    {
+        const COutPoint common{InsecureRand256(), 0};
+        for(size_t thread = 0; thread < NUM_THREADS; ++thread)
+        {
+            CMutableTransaction tx{*CreateTxnWithNInputs(5)};
+            tx.vin[(group + thread) % tx.vin.size()].prevout = common;
+            txns[thread].push_back(MakeTransactionRef(tx));
+        }
+    }
+
+    std::vector<std::atomic<size_t>> inserted(NUM_GROUPS);
+    std::atomic<size_t> unexpectedRejects{0};
+    std::vector<std::thread> threads;
+    for(size_t thread = 0; thread < NUM_THREADS; ++thread)
+    {
+        threads.emplace_back(
+            [&, thread]
+            {
+                for(size_t group = 0; group < NUM_GROUPS; ++group)
+                {
+                    CValidationState state;
+                    if(dsDetector.insertTxnInputs(txns[thread][group], mempool, state, true))
+                    {
+                        ++inserted[group];
+                    }
+                    else if(!state.IsDoubleSpendDetected())
+                    {
+                        // Boost.Test assertions are not thread safe.
+                        ++unexpectedRejects;
+                    }
+                }
+            });
+    }
+    for(auto& thread : threads)
+    {
+        thread.join();
+    }
+
+    BOOST_CHECK_EQUAL(unexpectedRejects.load(), 0U);
+    // Exactly one txn from each group must win and all of its inputs must be
+    // stored.
+    for(const auto& count : inserted)
+    {
+        BOOST_CHECK_EQUAL(count.load(), 1U);
+    }
+    BOOST_CHECK_EQUAL(dsDetector.getKnownSpendsSize(), NUM_GROUPS * 5);
+
+    // Removing the losers is a no-op, removing everything empties the detector.
+    for(const auto& threadTxns : txns)
+    {
+        for(const auto& ptx : threadTxns)
+        {
+            dsDetector.removeTxnInputs(*ptx);
+        }
+    }
+    BOOST_CHECK_EQUAL(dsDetector.getKnownSpendsSize(), 0U);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
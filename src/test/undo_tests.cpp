@@ -3,7 +3,9 @@
 // file COPYING or http://www.opensource.org/licenses/mit-license.php.
 
 #include "chainparams.h"
+#include "config.h"
 #include "consensus/validation.h"
+#include "disconnect_data_prefetcher.h"
 #include "processing_block_index.h"
 #include "undo.h"
 #include "validation.h"
@@ -135,4 +137,27 @@ BOOST_AUTO_TEST_CASE(connect_utxo_extblock) {
     BOOST_CHECK(HasSpendableCoin(view, prevTx0.GetId()));
 }
 
+BOOST_FIXTURE_TEST_CASE(disconnect_data_prefetcher, TestChain100Setup) {
+    LOCK(cs_main);
+
+    const CBlockIndex* stopAt = chainActive[90];
+    CDisconnectDataPrefetcher prefetcher{ GlobalConfig::GetConfig(), stopAt, 3 };
+
+    // Blocks are returned in disconnect order, from the tip to the stop point
+    for (const CBlockIndex* index = chainActive.Tip(); index != stopAt; index = index->GetPrev())
+    {
+        BlockDisconnectData data = prefetcher.Get(*index);
+        BOOST_REQUIRE(data.block);
+        BOOST_CHECK(data.block->GetHash() == index->GetBlockHash());
+        BOOST_REQUIRE(data.undo.has_value());
+        BOOST_CHECK_EQUAL(data.undo->vtxundo.size(), data.block->vtx.size() - 1);
+    }
+
+    // Asking for a block that was not read ahead still returns its data
+    BlockDisconnectData data = prefetcher.Get(*chainActive[50]);
+    BOOST_REQUIRE(data.block);
+    BOOST_CHECK(data.block->GetHash() == chainActive[50]->GetBlockHash());
+    BOOST_CHECK(data.undo.has_value());
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -3,11 +3,16 @@
 // Copyright (c) 2019 Bitcoin Association
 // Distributed under the Open BSV software license, see the accompanying file LICENSE.
 
+#include "block_index_store.h"
 #include "chainparams.h"
 #include "config.h"
 #include "consensus/consensus.h"
+#include "consensus/validation.h"
+#include "pow.h"
 #include "primitives/transaction.h"
+#include "script/sighashtype.h"
 #include "test/test_bitcoin.h"
+#include "txdb.h"
 #include "util.h"
 #include "validation.h"
 
@@ -28,6 +33,63 @@ static CBlock makeLargeDummyBlock(const size_t num_tx) {
     return block;
 }
 
+static std::vector<CBlockHeader> makeHeaders(const Config& config, const CBlockIndex& tip, size_t count) {
+    std::vector<CBlockHeader> headers;
+    CBlockHeader header = tip.GetBlockHeader();
+    for (size_t i = 0; i < count; i++) {
+        header.hashPrevBlock = header.GetHash();
+        header.nTime += 1;
+        header.nNonce = 0;
+        while (!CheckProofOfWork(header.GetHash(), header.nBits, config)) {
+            ++header.nNonce;
+        }
+        headers.push_back(header);
+    }
+    return headers;
+}
+
+namespace{ class validation_tests_uid; } // only used as unique identifier
+
+template <>
+struct CoinsDB::UnitTestAccess<validation_tests_uid>
+{
+    UnitTestAccess() = delete;
+
+    // Leave the database marked as if writing the transition from oldTip to
+    // newTip was interrupted, the same way as CoinsDB::DBBatchWrite() does.
+    static void InterruptFlush(CoinsDB& provider, const uint256& newTip, const uint256& oldTip)
+    {
+        CDBBatch batch{ provider.db };
+        batch.Erase('B');
+        batch.Write('H', std::vector<uint256>{ newTip, oldTip });
+        BOOST_REQUIRE(provider.db.WriteBatch(batch, true));
+    }
+};
+using TestAccessCoinsDB = CoinsDB::UnitTestAccess<validation_tests_uid>;
+
+static CMutableTransaction makeSpend(const CKey& key, const CTransaction& prevTx, size_t numOutputs)
+{
+    const CScript scriptPubKey = CScript() << ToByteVector(key.GetPubKey()) << OP_CHECKSIG;
+
+    CMutableTransaction spend;
+    spend.nVersion = 1;
+    spend.vin.resize(1);
+    spend.vin[0].prevout = COutPoint(prevTx.GetId(), 0);
+    spend.vout.resize(numOutputs);
+    for (auto& out : spend.vout) {
+        out.nValue = prevTx.vout[0].nValue / static_cast<int64_t>(numOutputs + 1);
+        out.scriptPubKey = scriptPubKey;
+    }
+
+    std::vector<uint8_t> vchSig;
+    uint256 hash = SignatureHash(prevTx.vout[0].scriptPubKey, CTransaction(spend), 0,
+                                 SigHashType().withForkId(), prevTx.vout[0].nValue);
+    BOOST_REQUIRE(key.Sign(hash, vchSig));
+    vchSig.push_back(uint8_t(SIGHASH_ALL | SIGHASH_FORKID));
+    spend.vin[0].scriptSig << vchSig;
+    return spend;
+}
+
 BOOST_FIXTURE_TEST_SUITE(validation_tests, TestingSetup)
 
 /** Test that LoadExternalBlockFile works with the buffer size set
@@ -76,4 +138,81 @@ BOOST_AUTO_TEST_CASE(validation_load_external_block_file) {
     BOOST_CHECK_NO_THROW({ LoadExternalBlockFile(config, std::move(fp), 0); });
 }
 
+BOOST_FIXTURE_TEST_CASE(process_new_block_headers, TestChain100Setup) {
+    const Config &config = GlobalConfig::GetConfig();
+
+    // Enough headers for the context-free checks to be split across threads.
+    std::vector<CBlockHeader> headers = makeHeaders(config, *chainActive.Tip(), 2000);
+
+    // Break proof of work of one header in the middle of the batch.
+    std::vector<CBlockHeader> badHeaders { headers.begin(), headers.begin() + 1500 };
+    while (CheckProofOfWork(badHeaders[1200].GetHash(), badHeaders[1200].nBits, config)) {
+        ++badHeaders[1200].nNonce;
+    }
+    {
+        CValidationState state;
+        const CBlockIndex* pindex = nullptr;
+        BOOST_CHECK(!ProcessNewBlockHeaders(config, badHeaders, state, &pindex));
+        BOOST_CHECK_EQUAL(state.GetRejectReason(), "high-hash");
+        // Headers before the invalid one are accepted.
+        BOOST_REQUIRE(pindex != nullptr);
+        BOOST_CHECK(pindex->GetBlockHash() == badHeaders[1199].GetHash());
+        BOOST_CHECK(mapBlockIndex.Get(badHeaders[1200].GetHash()) == nullptr);
+    }
+
+    CValidationState state;
+    const CBlockIndex* pindex = nullptr;
+    BOOST_CHECK(ProcessNewBlockHeaders(config, headers, state, &pindex));
+    BOOST_REQUIRE(pindex != nullptr);
+    BOOST_CHECK(pindex->GetBlockHash() == headers.back().GetHash());
+    BOOST_CHECK_EQUAL(pindex->GetHeight(), chainActive.Height() + 2000);
+    BOOST_CHECK(mapBlockIndex.GetBestHeader().GetBlockHash() == headers.back().GetHash());
+}
+
+BOOST_FIXTURE_TEST_CASE(replay_blocks, TestChain100Setup) {
+    const Config &config = GlobalConfig::GetConfig();
+    const CScript scriptPubKey = CScript() << ToByteVector(coinbaseKey.GetPubKey()) << OP_CHECKSIG;
+
+    // A block with independent transactions spending outputs of the previous block
+    CTransaction parent { makeSpend(coinbaseKey, coinbaseTxns[0], 1) };
+    CreateAndProcessBlock({ CMutableTransaction{ parent } }, scriptPubKey);
+    CTransaction child { makeSpend(coinbaseKey, parent, 3) };
+    CreateAndProcessBlock({ CMutableTransaction{ child } }, scriptPubKey);
+
+    LOCK(cs_main);
+    const CBlockIndex* tip = chainActive.Tip();
+    const CBlockIndex* fork = chainActive[tip->GetHeight() - 5];
+
+    auto haveCoin =
+        [](const TxId& txid, uint32_t n)
+        {
+            auto coin = CoinsDBView{ *pcoinsTip }.GetCoin(COutPoint{ txid, n });
+            return coin.has_value() && !coin->IsSpent();
+        };
+    BOOST_REQUIRE(!haveCoin(coinbaseTxns[0].GetId(), 0));
+    BOOST_REQUIRE(!haveCoin(parent.GetId(), 0));
+    BOOST_REQUIRE(haveCoin(child.GetId(), 2));
+
+    // Interrupted reorg to an older block rolls the coins back
+    BOOST_REQUIRE(pcoinsTip->Flush());
+    TestAccessCoinsDB::InterruptFlush(*pcoinsTip, fork->GetBlockHash(), tip->GetBlockHash());
+    BOOST_CHECK(ReplayBlocks(config, *pcoinsTip));
+    BOOST_CHECK(CoinsDBView{ *pcoinsTip }.GetBestBlock() == fork->GetBlockHash());
+    BOOST_CHECK(haveCoin(coinbaseTxns[0].GetId(), 0));
+    BOOST_CHECK(!haveCoin(parent.GetId(), 0));
+    BOOST_CHECK(!haveCoin(child.GetId(), 0));
+
+    // Interrupted connection of blocks rolls the coins forward
+    BOOST_REQUIRE(pcoinsTip->Flush());
+    TestAccessCoinsDB::InterruptFlush(*pcoinsTip, tip->GetBlockHash(), fork->GetBlockHash());
+    BOOST_CHECK(ReplayBlocks(config, *pcoinsTip));
+    BOOST_CHECK(CoinsDBView{ *pcoinsTip }.GetBestBlock() == tip->GetBlockHash());
+    BOOST_CHECK(!haveCoin(coinbaseTxns[0].GetId(), 0));
+    BOOST_CHECK(!haveCoin(parent.GetId(), 0));
+    for (uint32_t n = 0; n < child.vout.size(); ++n) {
+        BOOST_CHECK(haveCoin(child.GetId(), n));
+    }
+    BOOST_CHECK(pcoinsTip->Flush());
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -444,6 +444,59 @@ bool CBlockTreeDB::WriteTxIndex(
     return WriteBatch(batch);
 }
 
+bool CBlockTreeDB::ForEachTxIndexEntry(
+    const std::function<void(const uint256 &txid, const CDiskTxPos &pos)> &callback) {
+    std::unique_ptr<CDBIterator> pcursor(NewIterator());
+    for (pcursor->Seek(std::make_pair(DB_TXINDEX, uint256())); pcursor->Valid();
+         pcursor->Next()) {
+        std::pair<char, uint256> key;
+        if (!pcursor->GetKey(key) || key.first != DB_TXINDEX) {
+            break;
+        }
+        CDiskTxPos pos;
+        if (!pcursor->GetValue(pos)) {
+            return error("%s: failed to read transaction index entry", __func__);
+        }
+        callback(key.second, pos);
+    }
+    return true;
+}
+
+bool CBlockTreeDB::EraseTxIndex() {
+    // Erase in batches to limit memory usage
+    static constexpr size_t BATCH_SIZE = 100000;
+
+    bool erased = false;
+    std::unique_ptr<CDBIterator> pcursor(NewIterator());
+    CDBBatch batch(*this);
+    size_t count = 0;
+    for (pcursor->Seek(std::make_pair(DB_TXINDEX, uint256())); pcursor->Valid();
+         pcursor->Next()) {
+        std::pair<char, uint256> key;
+        if (!pcursor->GetKey(key) || key.first != DB_TXINDEX) {
+            break;
+        }
+        batch.Erase(key);
+        erased = true;
+        if (++count == BATCH_SIZE) {
+            if (!WriteBatch(batch)) {
+                return false;
+            }
+            batch.Clear();
+            count = 0;
+        }
+    }
+    if (count > 0 && !WriteBatch(batch)) {
+        return false;
+    }
+
+    if (erased) {
+        CompactRange(std::make_pair(DB_TXINDEX, uint256()),
+                     std::make_pair(DB_TXINDEX, uint256S(std::string(64, 'f'))));
+    }
+    return true;
+}
+
 bool CBlockTreeDB::WriteFlag(const std::string &name, bool fValue) {
     return Write(std::make_pair(DB_FLAG, name), fValue ? '1' : '0');
 }
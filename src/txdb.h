@@ -11,6 +11,7 @@
 #include "dbwrapper.h"
 #include "write_preferring_upgradable_mutex.h"
 
+#include <functional>
 #include <map>
 #include <shared_mutex>
 #include <string>
@@ -449,6 +450,11 @@ public:
     bool ReadReindexing(bool &fReindex);
     bool ReadTxIndex(const uint256 &txid, CDiskTxPos &pos);
     bool WriteTxIndex(const std::vector<std::pair<uint256, CDiskTxPos>> &list);
+    // Call callback for every entry of the transaction index.
+    bool ForEachTxIndexEntry(
+        const std::function<void(const uint256 &txid, const CDiskTxPos &pos)> &callback);
+    // Remove all entries of the transaction index.
+    bool EraseTxIndex();
     bool WriteFlag(const std::string &name, bool fValue);
     bool ReadFlag(const std::string &name, bool &fValue);
 
@@ -25,7 +25,9 @@
 #include "txn_validator.h"
 #include <boost/range/adaptor/reversed.hpp>
 #include <boost/uuid/random_generator.hpp>
+#include <algorithm>
 #include <exception>
+#include <future>
 #include <mutex>
 
 using namespace mining;
@@ -318,7 +320,7 @@ void CTxMemPool::AddUnchecked(
     size_t* pnSecondaryMempoolSize,
     size_t* pnDynamicMemoryUsage) {
 
-    {
+    if (changeSet) {
         std::unique_lock lock{smtx};
         
         AddUncheckedNL(
@@ -331,10 +333,84 @@ void CTxMemPool::AddUnchecked(
             pnSecondaryMempoolSize,
             pnDynamicMemoryUsage);
     }
+    else {
+        PendingCommit commit {
+            hash,
+            entry,
+            txStorage,
+            pnPrimaryMempoolSize,
+            pnSecondaryMempoolSize,
+            pnDynamicMemoryUsage};
+
+        std::unique_lock pendingLock{mPendingCommitsMtx};
+        mPendingCommits.push_back(&commit);
+        mPendingCommitsCV.wait(
+            pendingLock,
+            [this, &commit]{ return commit.done || !mCommitLeaderActive; });
+        if (!commit.done) {
+            // Nobody else is committing so take the lead and add everything
+            // that is pending (including our own entry).
+            mCommitLeaderActive = true;
+            std::vector<PendingCommit*> batch {};
+            batch.swap(mPendingCommits);
+            pendingLock.unlock();
+
+            try {
+                CommitPendingBatch(batch);
+            }
+            catch (...) {
+                // Don't leave the other waiting threads hanging.
+                for (auto* pending : batch) {
+                    if (!pending->error) {
+                        pending->error = std::current_exception();
+                    }
+                }
+            }
+
+            pendingLock.lock();
+            for (auto* pending : batch) {
+                pending->done = true;
+            }
+            mCommitLeaderActive = false;
+            mPendingCommitsCV.notify_all();
+        }
+        pendingLock.unlock();
+
+        if (commit.error) {
+            std::rethrow_exception(commit.error);
+        }
+    }
     // Notify entry added without holding the mempool's lock
     NotifyEntryAdded(*entry.tx);
 }
 
+void CTxMemPool::CommitPendingBatch(const std::vector<PendingCommit*>& batch)
+{
+    std::unique_lock lock{smtx};
+
+    // A single change set for the whole batch; it is applied when it goes out
+    // of scope (while still holding the lock, as for a single entry).
+    const CJournalChangeSetPtr changeSet {
+        mJournalBuilder.getNewChangeSet(JournalUpdateReason::UNKNOWN)
+    };
+    for (auto* pending : batch) {
+        try {
+            AddUncheckedNL(
+                pending->hash,
+                pending->entry,
+                pending->txStorage,
+                changeSet,
+                std::nullopt,
+                pending->pnPrimaryMempoolSize,
+                pending->pnSecondaryMempoolSize,
+                pending->pnDynamicMemoryUsage);
+        }
+        catch (...) {
+            pending->error = std::current_exception();
+        }
+    }
+}
+
 CTxMemPool::setEntriesTopoSorted CTxMemPool::GetSecondaryMempoolAncestorsNL(CTxMemPool::txiter payingTx) const
 {
     setEntriesTopoSorted ancestors;
@@ -790,6 +866,15 @@ void CTxMemPool::AddUncheckedNL(
     nTransactionsUpdated++;
     totalTxSize += newit->GetTxSize();
 
+    GetMainSignals().MempoolDelta(
+        CMempoolDelta{
+            ++mDeltaSequence,
+            CMempoolDelta::Type::ADDED,
+            newit->GetTxId(),
+            newit->GetFee(),
+            newit->GetTxSize(),
+            MemPoolRemovalReason::UNKNOWN});
+
     // If it is required calculate mempool size & dynamic memory usage.
     if (pnPrimaryMempoolSize) {
         *pnPrimaryMempoolSize = PrimaryMempoolSizeNL();
@@ -836,6 +921,7 @@ void CTxMemPool::removeUncheckedNL(
 
         const auto txid = entry->GetTxId();
         const auto size = entry->GetTxSize();
+        const auto fee = entry->GetFee();
         const auto removeFromDisk = !entry->IsInMemory();
 
         setEntries parents;
@@ -855,6 +941,14 @@ void CTxMemPool::removeUncheckedNL(
         {
             GetMainSignals().TransactionRemovedFromMempool(txid, reason, conflictedWith);
         }
+        GetMainSignals().MempoolDelta(
+            CMempoolDelta{
+                ++mDeltaSequence,
+                CMempoolDelta::Type::REMOVED,
+                txid,
+                fee,
+                size,
+                reason});
 
         if (removeFromDisk)
         {
@@ -1328,6 +1422,11 @@ void CTxMemPool::RemoveInvalidCTXsNL(const mining::CJournalChangeSetPtr& changeS
 }
 
 void CTxMemPool::clearNL(bool skipTransactionDatabase/* = false*/) {
+    if (!mapTx.empty()) {
+        // Removed entries are not reported one by one, leave a gap in the
+        // delta sequence instead.
+        ++mDeltaSequence;
+    }
     evictionTracker.reset();
     mapLinks.clear();
     mapTx.clear();
@@ -1926,6 +2025,7 @@ void CTxMemPool::prioritiseTransactionNL(
     {
         mapTx.modify(it, update_fee_delta(delta));
         TrackEntryModified(it);
+        ++nTransactionsUpdated;
 
         // Ensure CPFP groups maintain correct average fee calculations across the group
         auto changeSet = mJournalBuilder.getNewChangeSet(JournalUpdateReason::PRIORITISATION);
@@ -2341,7 +2441,12 @@ void CTxMemPool::AddToMempoolForReorg(const Config &config,
     }
 
     // Validate the set of transactions from the disconnectpool and add them to the mempool
+    // (they are validated in parallel)
+    int64_t nTimeStart = GetTimeMicros();
     g_connman->getTxnValidator()->processValidation(vTxInputData, changeSet, true);
+    int64_t nTimeValidated = GetTimeMicros();
+    size_t nResubmitted = resubmitContext.oldMapTx.size();
+    int64_t nTimeResubmitted = 0;
 
     // Add original mempool contents on top to preserve toposort
     {
@@ -2349,6 +2454,7 @@ void CTxMemPool::AddToMempoolForReorg(const Config &config,
 
         // now put all transactions that were in the mempool before
         ResubmitEntriesToMempoolNL(resubmitContext, changeSet);
+        nTimeResubmitted = GetTimeMicros();
 
         // Disconnectpool related updates
         for (const auto& txInputData : vTxInputData) {
@@ -2395,6 +2501,12 @@ void CTxMemPool::AddToMempoolForReorg(const Config &config,
         }
     }
 
+    LogPrint(BCLog::BENCH, "- Reorg mempool update: validate %zu disconnected txns: %.2fms, "
+             "resubmit %zu mempool txns: %.2fms, remove invalidated txns: %.2fms\n",
+             vTxInputData.size(), (nTimeValidated - nTimeStart) * 0.001,
+             nResubmitted, (nTimeResubmitted - nTimeValidated) * 0.001,
+             (GetTimeMicros() - nTimeResubmitted) * 0.001);
+
     // Check mempool & journal
     CheckMempool(*pcoinsTip, changeSet);
 
@@ -2676,10 +2788,30 @@ std::vector<TxId> CTxMemPool::TrimToSize(
         return CFeeRate(entry->GetModifiedFee(), entry->GetTxSize());
     };
 
+    // Estimate of memory freed by the removal of a transaction, it must not be
+    // lower than the real value (see DynamicMemoryIndexUsageNL) otherwise more
+    // transactions than needed would be evicted.
+    auto estimateUsage = [this](txiter entry)
+    {
+        const auto& links = mapLinks.at(entry);
+        return
+            entry->DynamicMemoryUsage() +
+            memusage::MallocUsage(sizeof(CTxMemPoolEntry) +
+                                  sizeof(CTransactionWrapper) +
+                                  12 * sizeof(void *)) +
+            mapNextTx.get<by_txiter>().count(entry) *
+                memusage::MallocUsage(sizeof(OutpointTxPair) + 12 * sizeof(void *)) +
+            memusage::MallocUsage(sizeof(memusage::unordered_node<txlinksMap::value_type>)) +
+            memusage::DynamicUsage(links.parents) +
+            memusage::DynamicUsage(links.children);
+    };
+
     CEnsureNonNullChangeSet nonNullChangeSet(*this, changeSet);
     bool weHaveEvictedSomething = false;
-    while (!mapTx.empty() && DynamicMemoryUsageNL() > sizelimit) {
-        const auto it = evictionTracker->GetMostWorthless();
+    for (size_t usage = DynamicMemoryUsageNL(); !mapTx.empty() && usage > sizelimit; usage = DynamicMemoryUsageNL()) {
+        // Evict the most worthless candidates in batches, estimated to free
+        // the excess memory, instead of one by one.
+        const auto batch = evictionTracker->GetEvictionBatch(usage - sizelimit, estimateUsage);
 
         // We set the new mempool min fee to the feerate of the removed set,
         // plus the "minimum reasonable fee rate" (ie some value under which we
@@ -2687,11 +2819,12 @@ std::vector<TxId> CTxMemPool::TrimToSize(
         // mempool with feerate equal to txn which were removed with no block in
         // between.
 
-        CFeeRate removed = getFeeRate(it);
-        maxFeeRateRemoved = std::max(maxFeeRateRemoved, removed);
-
         setEntries stage;
-        GetDescendantsNL(it, stage);
+        for (txiter it : batch) {
+            CFeeRate removed = getFeeRate(it);
+            maxFeeRateRemoved = std::max(maxFeeRateRemoved, removed);
+            GetDescendantsNL(it, stage);
+        }
         nTxnRemoved += stage.size();
 
 
@@ -2858,6 +2991,96 @@ CTxMemPool::Snapshot CTxMemPool::GetSnapshot() const
     return Snapshot(std::move(contents), nullptr);
 }
 
+CTxMemPool::View::View(Contents&& contents,
+                       uint64_t totalTxSize,
+                       unsigned int epoch,
+                       uint64_t deltaSequence)
+    : mContents(std::move(contents)),
+      mTotalTxSize(totalTxSize),
+      mEpoch(epoch),
+      mDeltaSequence(deltaSequence),
+      mCreationTime(std::chrono::steady_clock::now())
+{}
+
+const CTxMemPool::View::Entry* CTxMemPool::View::Find(const uint256& txid) const
+{
+    CreateIndex();
+    const auto iter = mIndex.find(txid);
+    if (iter != mIndex.end()) {
+        return &mContents[iter->second];
+    }
+    return nullptr;
+}
+
+std::chrono::milliseconds CTxMemPool::View::GetAge() const
+{
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - mCreationTime);
+}
+
+void CTxMemPool::View::CreateIndex() const
+{
+    std::call_once(
+        mCreateIndexOnce,
+        [this]() {
+            mIndex.reserve(mContents.size());
+            for (size_t i = 0; i < mContents.size(); ++i) {
+                mIndex.emplace(mContents[i].txid, i);
+            }
+        });
+}
+
+std::shared_ptr<const CTxMemPool::View> CTxMemPool::GetView(std::chrono::milliseconds maxAge) const
+{
+    const auto isUsable =
+        [this, maxAge](const std::shared_ptr<const View>& view) {
+            return view &&
+                   (view->mEpoch == nTransactionsUpdated.load() ||
+                    view->GetAge() < maxAge);
+        };
+
+    if (auto view = std::atomic_load(&mView); isUsable(view)) {
+        return view;
+    }
+
+    std::lock_guard viewLock{mViewMtx};
+    // Another thread may have published a new view while we were waiting.
+    if (auto view = std::atomic_load(&mView); isUsable(view)) {
+        return view;
+    }
+
+    std::shared_ptr<const View> view;
+    {
+        std::shared_lock lock{smtx};
+
+        View::Contents contents;
+        contents.reserve(mapTx.size());
+        for (auto it = mapTx.begin(); it != mapTx.end(); ++it) {
+            std::vector<TxId> depends;
+            for (const auto& parent : GetMemPoolParentsNL(it)) {
+                depends.push_back(parent->GetTxId());
+            }
+            contents.push_back(
+                View::Entry{
+                    it->GetTxId(),
+                    it->GetTxSize(),
+                    it->GetFee(),
+                    it->GetModifiedFee(),
+                    it->GetTime(),
+                    it->GetHeight(),
+                    std::move(depends)});
+        }
+        view.reset(
+            new View(
+                std::move(contents),
+                totalTxSize,
+                nTransactionsUpdated.load(),
+                mDeltaSequence.load()));
+    }
+    std::atomic_store(&mView, view);
+    return view;
+}
+
 CTxMemPool::Snapshot CTxMemPool::GetTxSnapshot(const uint256& hash, TxSnapshotKind kind) const
 {
     std::shared_lock lock{smtx};
@@ -2936,6 +3159,67 @@ std::vector<CTransactionRef> CTxMemPool::GetTransactions() const
     return result;
 }
 
+std::vector<CTransactionRef> CTxMemPool::GetTransactions(
+    const std::function<bool(const TxId&)>& filter,
+    size_t maxThreads) const
+{
+    // Checking an id is cheap so there is no point in spawning a thread for
+    // fewer entries than this.
+    constexpr size_t MIN_ENTRIES_PER_THREAD {10000};
+
+    std::shared_lock lock{smtx};
+
+    // Index iterators can't be split into ranges so collect the entries first.
+    std::vector<const CTxMemPoolEntry*> entries;
+    entries.reserve(mapTx.size());
+    for (const auto& entry : mapTx) {
+        entries.push_back(&entry);
+    }
+
+    const size_t numThreads {
+        std::clamp<size_t>(
+            entries.size() / MIN_ENTRIES_PER_THREAD,
+            1,
+            std::max<size_t>(1, maxThreads))
+    };
+    const size_t batchSize { (entries.size() + numThreads - 1) / numThreads };
+
+    auto filterRange =
+        [&filter, &entries](size_t begin, size_t end)
+        {
+            std::vector<const CTxMemPoolEntry*> accepted;
+            for (size_t i = begin; i < end; ++i) {
+                if (filter(entries[i]->GetTxId())) {
+                    accepted.push_back(entries[i]);
+                }
+            }
+            return accepted;
+        };
+
+    std::vector<std::future<std::vector<const CTxMemPoolEntry*>>> tasks {};
+    for (size_t begin = batchSize; begin < entries.size(); begin += batchSize) {
+        tasks.push_back(
+            std::async(
+                std::launch::async,
+                filterRange,
+                begin,
+                std::min(begin + batchSize, entries.size())));
+    }
+    // First batch is done by the calling thread.
+    auto accepted = filterRange(0, std::min(batchSize, entries.size()));
+    for (auto& task : tasks) {
+        auto batch = task.get();
+        accepted.insert(accepted.end(), batch.begin(), batch.end());
+    }
+
+    std::vector<CTransactionRef> result;
+    result.reserve(accepted.size());
+    for (const auto* entry : accepted) {
+        result.emplace_back(entry->GetSharedTx());
+    }
+    return result;
+}
+
 /*
  * Format of the serialized mempool.dat file
  * =========================================
@@ -28,7 +28,10 @@
 #include <boost/signals2/signal.hpp>
 #include <boost/uuid/uuid.hpp>
 
+#include <chrono>
+#include <condition_variable>
 #include <cstdint>
+#include <exception>
 #include <functional>
 #include <map>
 #include <memory>
@@ -310,6 +313,29 @@ enum class MemPoolRemovalReason {
     NOT_WHITELISTED
 };
 
+/**
+ * A single change of the mempool contents. Deltas are numbered by a sequence
+ * that is incremented under the mempool lock together with the change itself,
+ * so subscribers can detect missed deltas and line them up with a
+ * CTxMemPool::View taken at a known sequence.
+ */
+struct CMempoolDelta
+{
+    enum class Type : uint8_t
+    {
+        ADDED = 0,
+        REMOVED = 1
+    };
+
+    uint64_t sequence;
+    Type type;
+    TxId txid;
+    Amount fee;
+    size_t size;
+    // Only set for removals, UNKNOWN otherwise.
+    MemPoolRemovalReason reason;
+};
+
 inline const enumTableT<MemPoolRemovalReason>& enumTable(MemPoolRemovalReason)
 {
     static enumTableT<MemPoolRemovalReason> table
@@ -440,6 +466,10 @@ private:
     std::atomic_bool suspendSanityCheck {false};
 
     std::atomic_uint nTransactionsUpdated {0};
+    // Sequence number of the last CMempoolDelta. Incremented under the
+    // exclusive lock for every addition and removal (and for clear(), which
+    // does not emit deltas so subscribers see a gap and resynchronise).
+    std::atomic_uint64_t mDeltaSequence {0};
     std::atomic_uint mFrozenTxnUpdatedAt {0};
 
     // fee that a transaction or a group needs to pay to enter the primary mempool
@@ -467,6 +497,27 @@ private:
     // The group definition needs access to the mempool index iterator type.
     friend class CPFPGroup;
 
+    // An entry that was passed to AddUnchecked() and is waiting to be added
+    // together with entries from other threads.
+    struct PendingCommit
+    {
+        const uint256& hash;
+        const CTxMemPoolEntry& entry;
+        const TxStorage txStorage;
+        size_t* pnPrimaryMempoolSize;
+        size_t* pnSecondaryMempoolSize;
+        size_t* pnDynamicMemoryUsage;
+        bool done {false};
+        std::exception_ptr error {};
+    };
+
+    // Entries waiting to be committed by the thread that currently holds the
+    // commit leadership (see AddUnchecked()).
+    std::mutex mPendingCommitsMtx {};
+    std::condition_variable mPendingCommitsCV {};
+    std::vector<PendingCommit*> mPendingCommits {};
+    bool mCommitLeaderActive {false};
+
 private:
     // FIXME: DEPRECATED - ultimately this will be changed or removed
     typedef boost::multi_index_container<
@@ -666,6 +717,11 @@ public:
 
     // AddUnchecked must update the state for all ancestors of a given
     // transaction, to track size/count of descendant transactions.
+    //
+    // If changeSet is null, entries added concurrently from several threads
+    // are committed in batches: one of the waiting threads takes the mempool
+    // lock once, adds all pending entries and applies a single journal change
+    // set for all of them. The call returns once the entry has been added.
     void AddUnchecked(
             const uint256 &hash,
             const CTxMemPoolEntry &entry,
@@ -1115,7 +1171,98 @@ public:
      * the mempool entries.
      */
     Snapshot GetSnapshot() const;
-    
+
+    /** \class CTxMemPool::View
+     *
+     * CTxMemPool::View is an immutable summary of all mempool entries (no
+     * transactions) taken at one point in time. Views are shared between
+     * readers so that RPC and REST requests don't each have to walk the
+     * mempool while holding its lock.
+     *
+     * @note This class is non-moveable and non-copyable.
+     */
+    // NOLINTNEXTLINE(cppcoreguidelines-special-member-functions)
+    class View final
+    {
+        // Only CTxMemPool is allowed to call the constructor.
+        friend class CTxMemPool;
+
+    public:
+        struct Entry
+        {
+            TxId txid;
+            size_t size;
+            Amount fee;
+            Amount modifiedFee;
+            int64_t time;
+            int32_t height;
+            // In-mempool parents
+            std::vector<TxId> depends;
+        };
+
+    private:
+        using Contents = std::vector<Entry>;
+
+        explicit View(Contents&& contents,
+                      uint64_t totalTxSize,
+                      unsigned int epoch,
+                      uint64_t deltaSequence);
+
+        View(View&&) = delete;
+        View(const View&) = delete;
+
+    public:
+        using size_type = Contents::size_type;
+        using const_iterator = Contents::const_iterator;
+
+        bool empty() const noexcept { return mContents.empty(); }
+        size_type size() const noexcept { return mContents.size(); }
+
+        const_iterator begin() const noexcept { return mContents.begin(); }
+        const_iterator end() const noexcept { return mContents.end(); }
+
+        /// Returns the entry for @a txid or nullptr if it is not in the view.
+        const Entry* Find(const uint256& txid) const;
+
+        /// Sum of sizes of all transactions in the view.
+        uint64_t GetTotalTxSize() const noexcept { return mTotalTxSize; }
+
+        /// How long ago the view was taken.
+        std::chrono::milliseconds GetAge() const;
+
+        /// Sequence of the last CMempoolDelta included in the view.
+        uint64_t GetDeltaSequence() const noexcept { return mDeltaSequence; }
+
+    private:
+        const Contents mContents;
+        const uint64_t mTotalTxSize;
+        // Value of CTxMemPool::GetTransactionsUpdated() when the view was taken.
+        const unsigned int mEpoch;
+        const uint64_t mDeltaSequence;
+        const std::chrono::steady_clock::time_point mCreationTime;
+
+        // The transaction lookup index.
+        using TxIdIndex = std::unordered_map<uint256, size_t>;
+        mutable TxIdIndex mIndex{};
+        mutable std::once_flag mCreateIndexOnce{};
+        void CreateIndex() const;
+    };
+
+    /**
+     * Returns a view of the whole mempool. The last published view is reused
+     * if the mempool hasn't changed since it was taken or if it is younger
+     * than @a maxAge, otherwise a new view is taken and published. Only one
+     * thread at a time takes a new view.
+     */
+    std::shared_ptr<const View> GetView(std::chrono::milliseconds maxAge) const;
+
+private:
+    // The last published view of the mempool (see GetView()) and a mutex that
+    // serialises taking new views.
+    mutable std::shared_ptr<const View> mView {};
+    mutable std::mutex mViewMtx {};
+
+public:
     /**
      * Retreival modes for GetTxSnapshot().
      */
@@ -1154,6 +1301,19 @@ public:
      */
     std::vector<CTransactionRef> GetTransactions() const;
 
+    /**
+     * Returns shared references to the mempool transactions whose ids are
+     * accepted by @a filter, in an unpredictable order.
+     *
+     * Ids are checked in parallel on up to @a maxThreads threads so
+     * @a filter must be safe to call concurrently. Only the accepted
+     * transactions are copied (and, if they were moved to the mempool
+     * transaction database, read from disk).
+     */
+    std::vector<CTransactionRef> GetTransactions(
+        const std::function<bool(const TxId&)>& filter,
+        size_t maxThreads) const;
+
 
     /**
      * Make mempool consistent after a reorg, by re-adding
@@ -1223,6 +1383,10 @@ private:
         int flags);
 
 
+    // Add entries collected by AddUnchecked() under a single lock acquisition.
+    // Errors are reported through PendingCommit::error of each entry.
+    void CommitPendingBatch(const std::vector<PendingCommit*>& batch);
+
     // A non-locking version of AddUnchecked
     // A signal NotifyEntryAdded is decoupled from AddUncheckedNL.
     // It needs to be called explicitly by a user if AddUncheckedNL is used.
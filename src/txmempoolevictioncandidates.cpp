@@ -3,19 +3,46 @@
 // LICENSE.
 
 #include "txmempoolevictioncandidates.h"
+#include "crypto/common.h"
 
-bool CEvictionCandidateTracker::CompareResult(const EvalResult& first, const EvalResult& second)
+#include <algorithm>
+
+size_t CEvictionCandidateTracker::BucketOf(int64_t score)
 {
-    return first.Score() > second.Score();
+    // bucket of the non-negative value, small values have a bucket each, larger ones are
+    // binned by the position of the highest set bit and the BUCKET_MANTISSA_BITS bits following it
+    auto magnitudeBucket = [](uint64_t value) -> size_t
+    {
+        if (value < (uint64_t{1} << BUCKET_MANTISSA_BITS))
+        {
+            return value;
+        }
+        const unsigned exponent = CountBits(value) - 1;
+        const unsigned shift = exponent - BUCKET_MANTISSA_BITS;
+        const uint64_t mantissa = (value >> shift) & ((uint64_t{1} << BUCKET_MANTISSA_BITS) - 1);
+        return ((shift + 1) << BUCKET_MANTISSA_BITS) + mantissa;
+    };
+
+    if (score >= 0)
+    {
+        return BUCKETS_PER_SIGN + magnitudeBucket(static_cast<uint64_t>(score));
+    }
+    // ~score == -(score + 1) without overflow for INT64_MIN, larger magnitude goes to a lower bucket
+    return BUCKETS_PER_SIGN - 1 - magnitudeBucket(~static_cast<uint64_t>(score));
 }
 
 void CEvictionCandidateTracker::InsertEntry(CTxMemPool::txiter entry)
 {
-    auto [iter, success] = entries.insert({entry->GetTxId(), nullptr});
+    auto [iter, success] = entries.insert({entry->GetTxId(), Position{}});
     assert(success); // successful insertion
-    heap.emplace_back(entry, evaluator, iter->second);
 
-    std::push_heap(heap.begin(), heap.end(), CompareResult);
+    const int64_t score = evaluator(entry);
+    const size_t bucketIndex = BucketOf(score);
+    auto& bucket = buckets[bucketIndex];
+    iter->second = Position{bucketIndex, bucket.size()};
+    bucket.push_back(Candidate{entry, score, &iter->second});
+
+    lowestBucket = std::min(lowestBucket, bucketIndex);
 }
 
 void CEvictionCandidateTracker::ExpireEntry(const TxId& txId)
@@ -25,29 +52,27 @@ void CEvictionCandidateTracker::ExpireEntry(const TxId& txId)
     {
         return;
     }
-    iter->second->MarkExpired();
-    entries.erase(iter);
-}
 
-void CEvictionCandidateTracker::PopExpired()
-{
-    if((entries.size() == 0) || 
-        ((double(heap.size() - entries.size()) / entries.size()) >  MAX_INVALID_TO_VALID_RATIO))
+    // move the last candidate of the bucket in place of the removed one
+    const auto [bucketIndex, index] = iter->second;
+    auto& bucket = buckets[bucketIndex];
+    if (index + 1 != bucket.size())
     {
-        heap.erase(
-            std::remove_if(heap.begin(), 
-                           heap.end(),
-                           [](const EvalResult& x){return x.IsExpired();}),
-            heap.end());
+        bucket[index] = bucket.back();
+        bucket[index].position->index = index;
+    }
+    bucket.pop_back();
+    entries.erase(iter);
 
-        std::make_heap(heap.begin(), heap.end(), CompareResult);
+    if (entries.empty())
+    {
+        lowestBucket = NUM_OF_BUCKETS;
     }
-    else
+    else if (bucketIndex == lowestBucket)
     {
-        while (!heap.empty() && heap.front().IsExpired())
+        while (buckets[lowestBucket].empty())
         {
-            std::pop_heap(heap.begin(), heap.end(), CompareResult);
-            heap.pop_back();
+            ++lowestBucket;
         }
     }
 }
@@ -92,8 +117,8 @@ bool CEvictionCandidateTracker::HasChildren(CTxMemPool::txiter entry) const
 CEvictionCandidateTracker::CEvictionCandidateTracker(CTxMemPool::txlinksMap& _links, Evaluator _evaluator)
     : links{_links}
     , evaluator{_evaluator}
+    , buckets(NUM_OF_BUCKETS)
 {
-    heap.reserve(links.get().size());
     entries.reserve(links.get().size());
     for (const auto& [entry, connections] : links.get())
     {
@@ -107,11 +132,8 @@ CEvictionCandidateTracker::CEvictionCandidateTracker(CTxMemPool::txlinksMap& _li
             continue;
         }
 
-        auto[iter, success] = entries.insert({entry->GetTxId(), nullptr});
-        assert(success);
-        heap.emplace_back(entry, evaluator, iter->second);
+        InsertEntry(entry);
     }
-    std::make_heap(heap.begin(), heap.end(), CompareResult);
 }
 
 
@@ -128,15 +150,13 @@ void CEvictionCandidateTracker::EntryAdded(CTxMemPool::txiter entry)
             ExpireEntry(parent->GetTxId());
         }    
     }
-    
-    PopExpired();
+
     InsertEntry(entry);
 }
 
 void CEvictionCandidateTracker::EntryRemoved(const TxId& txId, const CTxMemPool::setEntries& immediateParents)
 {
     ExpireEntry(txId);
-    PopExpired();
 
     for (const auto& parent : immediateParents)
     {
@@ -164,29 +184,91 @@ void CEvictionCandidateTracker::EntryModified(CTxMemPool::txiter entry)
         return;
     }
     ExpireEntry(entry->GetTxId());
-    PopExpired();
     InsertEntry(entry);
 }
 
 CTxMemPool::txiter CEvictionCandidateTracker::GetMostWorthless() const
 {
     assert(entries.size() != 0);
-    return heap.front().Entry();
+    const auto& bucket = buckets[lowestBucket];
+    return std::min_element(bucket.begin(), bucket.end(),
+                            [](const Candidate& first, const Candidate& second)
+                            {
+                                return first.score < second.score;
+                            })->entry;
+}
+
+std::vector<CTxMemPool::txiter> CEvictionCandidateTracker::GetEvictionBatch(
+    size_t bytesToFree,
+    const UsageEstimator& estimateUsage) const
+{
+    std::vector<CTxMemPool::txiter> batch;
+    size_t batchBytes = 0;
+    for (size_t bucketIndex = lowestBucket; bucketIndex < NUM_OF_BUCKETS; ++bucketIndex)
+    {
+        const auto& bucket = buckets[bucketIndex];
+        size_t bucketBytes = 0;
+        bool wholeBucket = true;
+        for (const auto& candidate : bucket)
+        {
+            bucketBytes += estimateUsage(candidate.entry);
+            if (batchBytes + bucketBytes >= bytesToFree)
+            {
+                wholeBucket = false;
+                break;
+            }
+        }
+
+        if (wholeBucket)
+        {
+            for (const auto& candidate : bucket)
+            {
+                batch.push_back(candidate.entry);
+            }
+            batchBytes += bucketBytes;
+            continue;
+        }
+
+        // the whole bucket is not needed, take its most worthless candidates only
+        std::vector<Candidate> sorted {bucket};
+        std::sort(sorted.begin(), sorted.end(),
+                  [](const Candidate& first, const Candidate& second)
+                  {
+                      return first.score < second.score;
+                  });
+        for (const auto& candidate : sorted)
+        {
+            batch.push_back(candidate.entry);
+            batchBytes += estimateUsage(candidate.entry);
+            if (batchBytes >= bytesToFree)
+            {
+                break;
+            }
+        }
+        break;
+    }
+    return batch;
 }
 
 CTxMemPool::setEntries CEvictionCandidateTracker::GetAllCandidates() const
 {
     CTxMemPool::setEntries candidates;
-    for(const auto& entry: entries)
+    for (size_t bucketIndex = lowestBucket; bucketIndex < NUM_OF_BUCKETS; ++bucketIndex)
     {
-        candidates.insert(entry.second->Entry());
+        for (const auto& candidate : buckets[bucketIndex])
+        {
+            candidates.insert(candidate.entry);
+        }
     }
     return candidates;
 }
 
 size_t CEvictionCandidateTracker::DynamicMemoryUsage() const
 {
-    return 
-        memusage::DynamicUsage(heap) + 
-        memusage::DynamicUsage(entries);
+    size_t usage = memusage::DynamicUsage(buckets) + memusage::DynamicUsage(entries);
+    for (const auto& bucket : buckets)
+    {
+        usage += memusage::DynamicUsage(bucket);
+    }
+    return usage;
 }
@@ -7,7 +7,9 @@
 #include "txmempool.h"
 
 // CEvictionCandidateTracker is class that tracks which transaction should be removed. candidates for the removal
-// are childless transactions. they are internally arranged in the heap structure with tx with lowest score on the top.
+// are childless transactions. they are internally arranged in buckets by their score (fee rate bins of roughly
+// 12.5% width), so adding and removing a candidate takes constant time regardless of the number of candidates and
+// whole buckets of the most worthless candidates can be evicted at once.
 // for all calls to this class mempool should be locked
 class CEvictionCandidateTracker
 {
@@ -15,89 +17,54 @@ public:
     // the function object that assigns the score for the given transaction
     // transactions with lower score will be evicted first
     using Evaluator = std::function<int64_t(CTxMemPool::txiter)>;
+    // the function object that estimates how much memory is freed when the given transaction is evicted
+    using UsageEstimator = std::function<size_t(CTxMemPool::txiter)>;
 
 private:
-    // maximal ratio between expired and non-expired transactions
-    static constexpr double MAX_INVALID_TO_VALID_RATIO = 1.0;
+    // scores are binned by their magnitude, every power of two is split into 2^BUCKET_MANTISSA_BITS buckets
+    static constexpr unsigned BUCKET_MANTISSA_BITS = 3;
+    // number of buckets needed for scores of one sign
+    static constexpr size_t BUCKETS_PER_SIGN = (65 - BUCKET_MANTISSA_BITS) << BUCKET_MANTISSA_BITS;
+    static constexpr size_t NUM_OF_BUCKETS = 2 * BUCKETS_PER_SIGN;
 
     // mempool's "mapLinks"
     std::reference_wrapper<const CTxMemPool::txlinksMap> links;
     // function calculates transaction worth, tx with lower worth will be evicted first
     Evaluator evaluator;
-    
-    // class that represents estimated worth of the transaction
-    class EvalResult
+
+    struct Position;
+
+    // tracked transaction together with its score. the score should not be modified after it is
+    // initialized, if the score needs to be changed the candidate is removed and inserted again
+    struct Candidate
     {
-        // the score of the entry, transactions with lower score will be evicted first.
-        // score should not be modified after it is initialized, if the score needs to be changed, a new EvalResult should be added and this one marked as invalid
-        int64_t score = 0;
-        // the entry for which the score is calculated, should not be modified. this iterator might be invalid if the entry is removed from the mempool
         CTxMemPool::txiter entry;
-        // pointer to pointer to this object in the "entries" map. it tracks our position in the vector (heap). 
-        // if the value is nullptr the object is expired (not tracked any more) and not referenced in the map any more
-        EvalResult** ptrToMe; 
-    public:
-        
-        EvalResult(CTxMemPool::txiter _entry, Evaluator& evaluator, EvalResult*& _ptrToMe )
-            :score{evaluator(_entry)}
-            ,entry{_entry}
-            ,ptrToMe{&_ptrToMe}
-        {
-            *ptrToMe = this;
-        }
-
-        EvalResult(EvalResult&& other)
-            :score{other.score}
-            ,entry{other.entry}
-            ,ptrToMe{other.ptrToMe}
-        {
-            if(ptrToMe != nullptr)
-            {
-                *ptrToMe = this;
-                other.ptrToMe = nullptr;
-            }
-        }
-
-        EvalResult& operator=(EvalResult&& other)
-        {
-            score = other.score;
-            entry = other.entry;
-            ptrToMe = other.ptrToMe;
-            if(ptrToMe != nullptr)
-            {
-                *ptrToMe = this;
-                other.ptrToMe = nullptr;
-            }
-            return *this;
-        }
-
-        EvalResult(const EvalResult&) = delete;
-        EvalResult& operator=(const EvalResult&) = delete;
-
-        CTxMemPool::txiter Entry() const { return entry; }
-        void MarkExpired()               { ptrToMe = nullptr;}
-        bool IsExpired() const           { return ptrToMe == nullptr; }
-        int64_t Score() const            { return score; }
+        int64_t score;
+        // position of this candidate in the "entries" map, updated when the candidate moves inside its bucket
+        Position* position;
+    };
+
+    // where in "buckets" the candidate is stored
+    struct Position
+    {
+        size_t bucket;
+        size_t index;
     };
 
-    // the comparison function used for the creation of the heap, if the "first" is larger than
-    // the second it returns true. used for the heap creation to make result with lowest score on the top of the heap
-    static bool CompareResult(const EvalResult& first, const EvalResult& second);
-
-    // vector that represents the heap of the evaluation results, the most worthless entry is on the top
-    std::vector<EvalResult> heap;
-    // map txid to the representing evaluation result. as the evaluation result moves inside heap this ptr will be changed. 
-    // when removing a result from this map it should be marked as expired first
-    std::unordered_map<TxId, EvalResult*, SaltedTxidHasher> entries;
-    
-    // adds entry to the "heap" and "entries"
+    // candidates binned by the score, lower index holds lower scores. order inside a bucket is arbitrary
+    std::vector<std::vector<Candidate>> buckets;
+    // index of the lowest non-empty bucket, NUM_OF_BUCKETS if there are no candidates
+    size_t lowestBucket = NUM_OF_BUCKETS;
+    // map txid to the position of its candidate
+    std::unordered_map<TxId, Position, SaltedTxidHasher> entries;
+
+    // maps score to the bucket index, preserving the order of scores
+    static size_t BucketOf(int64_t score);
+
+    // adds entry to the "buckets" and "entries"
     void InsertEntry(CTxMemPool::txiter entry);
-    // marks the entry as expired
+    // removes the entry from the "buckets" and "entries" if it is tracked
     void ExpireEntry(const TxId& tx);
-    // pops expired transactions from the top of the heap, if the ratio between the size 
-    // of the expired and non-expired entries is larger than MAX_INVALID_TO_VALID_RATIO the "heap" will
-    // be filtered for the expired transaction and heap structure will be recreated
-    void PopExpired(); 
 
     // direct parents of the tx
     const CTxMemPool::setEntries& GetParentsNoGroup(CTxMemPool::txiter entry) const; 
@@ -141,6 +108,11 @@ public:
     // will not be considered
     CTxMemPool::txiter GetMostWorthless() const;
 
+    // returns the most worthless candidates whose combined estimated memory usage reaches "bytesToFree". whole
+    // buckets are returned starting with the lowest one, only the last bucket is split and from it candidates
+    // with the lowest score are taken. returns at least one candidate if there are any
+    std::vector<CTxMemPool::txiter> GetEvictionBatch(size_t bytesToFree, const UsageEstimator& estimateUsage) const;
+
     // returns all transactions that could be evicted
     CTxMemPool::setEntries GetAllCandidates() const;
 
@@ -6,7 +6,9 @@
 
 #include "consensus/validation.h"
 #include "txmempool.h"
+#include <algorithm>
 #include <memory>
+#include <set>
 
 bool CTxnDoubleSpendDetector::insertTxnInputs(
     const std::shared_ptr<const CTransaction>& ptx,
@@ -23,12 +25,13 @@ bool CTxnDoubleSpendDetector::insertTxnInputs(
         return false;
     }
 
-    // To avoid race conditions in double spends we need to take this mutex first.
-    // This approach guarantees that:
+    // To avoid race conditions in double spends we need to lock the shards of
+    // all inputs first. Any two txns spending a common input share that
+    // input's shard. This approach guarantees that:
     // a) if dstxn1 is accepted to the mempool then dstxn2 will be rejected as a mempool conflict
     // b) if dstxn1 and dstxn2 are valid txns (at this stage) then the first of them is allowed to
     //    continue processing but the other one is rejected as a double spend
-    std::lock_guard lock(mMainMtx);
+    const auto locks = lockShards(tx);
     // Check for conflicts with in-memory transactions.
     //
     // Double spend txns are allowed to be processed simultaneously.
@@ -50,9 +53,8 @@ bool CTxnDoubleSpendDetector::insertTxnInputs(
         return false;
     }
     // Store the inputs
-    mKnownSpendsTx.insert(&tx);
     for (const auto& input: tx.vin) {
-         mKnownSpends.emplace_back(input.prevout, ptx);
+        getShard(input.prevout).mKnownSpends.emplace(input.prevout, ptx);
     }
     return true;
 }
@@ -77,50 +79,81 @@ void CTxnDoubleSpendDetector::removeTxnInputs(const CTransaction &tx)
         return;
     }
 
-    std::lock_guard lock(mMainMtx);
-    if(mKnownSpendsTx.find(&tx) == mKnownSpendsTx.end())
+    const auto locks = lockShards(tx);
+
+    // Inputs of a txn are either all stored or none of them is so it is
+    // enough to check that the first one was stored for this very txn.
+    auto& firstShard = getShard(tx.vin[0].prevout);
+    const auto it = firstShard.mKnownSpends.find(tx.vin[0].prevout);
+    if(it == firstShard.mKnownSpends.end() || it->second.get() != &tx)
     {
         return;
     }
 
-    // At this point we know that transaction inputs were added to the vector
-    // and that the entries are both not duplicated and are laid out in
-    // consecutive order (guaranteed by the way they were inserted).
-    mKnownSpendsTx.erase(&tx);
-    const auto it = std::find_if(
-        mKnownSpends.begin(), mKnownSpends.end(), [&tx](const auto& op_tx) {
-            return op_tx.mOut == tx.vin[0].prevout;
-        });
-
-    mKnownSpends.erase(it, it + tx.vin.size());
+    for(const auto& input : tx.vin)
+    {
+        getShard(input.prevout).mKnownSpends.erase(input.prevout);
+    }
 }
 
 size_t CTxnDoubleSpendDetector::getKnownSpendsSize() const {
-    std::lock_guard lock(mMainMtx);
-    return mKnownSpends.size();
+    size_t size = 0;
+    for(const auto& shard : mShards)
+    {
+        std::lock_guard lock(shard.mMtx);
+        size += shard.mKnownSpends.size();
+    }
+    return size;
 }
 
 void CTxnDoubleSpendDetector::clear() {
-    std::lock_guard lock(mMainMtx);
-    mKnownSpends.clear();
+    for(auto& shard : mShards)
+    {
+        std::lock_guard lock(shard.mMtx);
+        shard.mKnownSpends.clear();
+    }
+}
+
+CTxnDoubleSpendDetector::Shard& CTxnDoubleSpendDetector::getShard(const COutPoint& out)
+{
+    // Use the high bits as the low ones also select the bucket inside the shard.
+    return mShards[(mShardHasher(out) >> 32) % NUM_SHARDS];
+}
+
+CTxnDoubleSpendDetector::ShardLocks CTxnDoubleSpendDetector::lockShards(const CTransaction& tx)
+{
+    // Always lock in the same (ascending) order to prevent deadlocks.
+    std::vector<Shard*> shards;
+    shards.reserve(tx.vin.size());
+    for(const auto& input : tx.vin)
+    {
+        shards.push_back(&getShard(input.prevout));
+    }
+    std::sort(shards.begin(), shards.end());
+    shards.erase(std::unique(shards.begin(), shards.end()), shards.end());
+
+    ShardLocks locks;
+    locks.reserve(shards.size());
+    for(auto* shard : shards)
+    {
+        locks.emplace_back(shard->mMtx);
+    }
+    return locks;
 }
 
 bool CTxnDoubleSpendDetector::isAnyOfInputsKnownNL(
     const CTransaction& tx,
-    CValidationState& state) const
+    CValidationState& state)
 {
     std::set<CTransactionRef> isKnown;
 
     for(const auto& input : tx.vin)
     {
-        const auto it = std::find_if(mKnownSpends.begin(),
-                                     mKnownSpends.end(),
-                                     [&input](const auto& op_tx) {
-                                         return op_tx.mOut == input.prevout;
-                                     });
-        if(it != mKnownSpends.end())
+        const auto& knownSpends = getShard(input.prevout).mKnownSpends;
+        const auto it = knownSpends.find(input.prevout);
+        if(it != knownSpends.end())
         {
-            isKnown.insert(it->mspTx);
+            isKnown.insert(it->second);
         }
     }
 
@@ -5,11 +5,13 @@
 #pragma once
 
 #include "primitives/transaction.h"
+#include "txhasher.h"
 #include "txn_validation_data.h"
 #include "uint256.h"
+#include <array>
 #include <mutex>
+#include <unordered_map>
 #include <vector>
-#include <set>
 
 class CTxMemPool;
 class CValidationState;
@@ -19,6 +21,12 @@ using TxnDoubleSpendDetectorSPtr = std::shared_ptr<CTxnDoubleSpendDetector>;
 
 /**
  * A basic class used to detect a double spend issue in an early stage of txn validation.
+ *
+ * Known spends are split into shards by outpoint hash, each guarded by its own
+ * mutex, so that validator threads only contend when their transactions spend
+ * outpoints from the same shard. All shards that a transaction touches are
+ * locked (in ascending order) for the duration of an insert or remove so that
+ * the inputs of a transaction are always claimed or released all at once.
  */
 class CTxnDoubleSpendDetector
 {
@@ -70,21 +78,24 @@ public:
         bool isFinal);
 
   private:
-    /** Check if any of txn's inputs is already known */
-    bool isAnyOfInputsKnownNL(const CTransaction &tx, CValidationState& state) const;
+    static constexpr size_t NUM_SHARDS = 64;
 
-    struct OutPointWithTx
+    struct Shard
     {
-        COutPoint mOut;
-        std::shared_ptr<const CTransaction> mspTx;
-
-        OutPointWithTx(const COutPoint& out, const std::shared_ptr<const CTransaction>& spTx)
-            : mOut{ out }
-            , mspTx{ spTx }
-        {}
+        std::unordered_map<COutPoint, std::shared_ptr<const CTransaction>, SaltedOutpointHasher> mKnownSpends {};
+        mutable std::mutex mMtx {};
     };
-    std::vector<OutPointWithTx> mKnownSpends = {};
-    std::set<const CTransaction*> mKnownSpendsTx;
-    mutable std::mutex mMainMtx {};
+
+    using ShardLocks = std::vector<std::unique_lock<std::mutex>>;
+
+    /** Get the shard that holds the given outpoint */
+    Shard& getShard(const COutPoint& out);
+    /** Lock all shards that hold any of the txn's inputs */
+    ShardLocks lockShards(const CTransaction& tx);
+    /** Check if any of txn's inputs is already known */
+    bool isAnyOfInputsKnownNL(const CTransaction &tx, CValidationState& state);
+
+    std::array<Shard, NUM_SHARDS> mShards {};
+    const SaltedOutpointHasher mShardHasher {};
 };
 
@@ -7,20 +7,24 @@
 #include "validation.h"
 #include "abort_node.h"
 #include "arith_uint256.h"
+#include "async_block_data_writer.h"
 #include "async_file_reader.h"
 #include "block_file_access.h"
 #include "block_index_store.h"
 #include "block_index_store_loader.h"
+#include "block_tx_offsets.h"
 #include "blockfileinfostore.h"
 #include "blockindex_with_descendants.h"
 #include "blockstreams.h"
 #include "chainparams.h"
 #include "checkpoints.h"
 #include "checkqueuepool.h"
+#include "compact_txindex.h"
 #include "config.h"
 #include "consensus/consensus.h"
 #include "consensus/merkle.h"
 #include "consensus/validation.h"
+#include "disconnect_data_prefetcher.h"
 #include "disk_tx_pos.h"
 #include "frozentxo.h"
 #include "frozentxo_db.h"
@@ -67,7 +71,10 @@
 #include "metrics.h"
 #include "safe_mode.h"
 
+#include <algorithm>
 #include <atomic>
+#include <future>
+#include <thread>
 
 #include <boost/algorithm/string/join.hpp>
 #include <boost/algorithm/string/replace.hpp>
@@ -2170,7 +2177,19 @@ bool GetTransaction(const Config &config, const TxId &txid,
         return true;
     }
 
-    if (fTxIndex) {
+    if (fTxIndex && pCompactTxIndex) {
+        const CBlockIndex* foundBlockIndex = nullptr;
+        if (FindTransactionInCompactTxIndex(*pCompactTxIndex, chainActive, txid, txOut, foundBlockIndex)) {
+            hashBlock = foundBlockIndex->GetBlockHash();
+            isGenesisEnabled = IsGenesisEnabled(config, foundBlockIndex->GetHeight());
+            return true;
+        }
+    }
+    else if (fTxIndex) {
+        // Entries of recently connected blocks may still be being written
+        if (pBlockDataWriter && pBlockDataWriter->HasPendingTxIndex()) {
+            pBlockDataWriter->Sync();
+        }
         CDiskTxPos postx;
         if (pblocktree->ReadTxIndex(txid, postx)) {
             if (!BlockFileAccess::LoadBlockHashAndTx( postx, hashBlock, txOut ))
@@ -3145,10 +3164,11 @@ public:
             bool res =
                  pindex->writeUndoToDisk(
                     state,
-                    blockundo,
+                    std::move(blockundo),
                     fCheckForPruning,
                     config,
-                    mapBlockIndex);
+                    mapBlockIndex,
+                    pBlockDataWriter.get());
 
             setBlockIndexCandidates.insert(pindex);
 
@@ -3159,7 +3179,14 @@ public:
             }
         }
 
-        if (fTxIndex)
+        if (fTxIndex && pCompactTxIndex)
+        {
+            if (!pCompactTxIndex->AddBlock(block, pindex->GetHeight()))
+            {
+                return AbortNode(state, "Failed to write transaction index");
+            }
+        }
+        else if (fTxIndex)
         {
             // Calculate transaction indexing information
             std::vector<std::pair<uint256, CDiskTxPos>> vPos {};
@@ -3173,7 +3200,11 @@ public:
             }
 
             // Write it out
-            if(!pblocktree->WriteTxIndex(vPos))
+            if (pBlockDataWriter)
+            {
+                pBlockDataWriter->WriteTxIndex(std::move(vPos));
+            }
+            else if(!pblocktree->WriteTxIndex(vPos))
             {
                 return AbortNode(state, "Failed to write transaction index");
             }
@@ -3809,6 +3840,12 @@ bool FlushStateToDisk(
                 if (!CheckDiskSpace(0)) {
                     return state.Error("out of disk space");
                 }
+                // Undo data and transaction index entries that the block
+                // index and chain state refer to must be written first.
+                if (pBlockDataWriter && !pBlockDataWriter->Sync()) {
+                    return AbortNode(
+                        state, "Failed to write undo data or transaction index");
+                }
                 // First make sure all block and undo data is flushed to disk.
                 pBlockFileInfoStore->FlushBlockFile();
 
@@ -3830,6 +3867,13 @@ bool FlushStateToDisk(
                             state, "Failed to write to block index database");
                     }
                 }
+                // Persist entries of the compact transaction index of blocks
+                // up to the tip; entries of later blocks are added on startup.
+                if (pCompactTxIndex && chainActive.Tip() &&
+                    !pCompactTxIndex->Flush(chainActive.Tip()->GetBlockHash())) {
+                    return AbortNode(
+                        state, "Failed to write to transaction index");
+                }
                 nLastWrite = nNow;
             }
             // Flush best chain related state. This can only be done if the
@@ -3927,6 +3971,14 @@ static void FinalizeGenesisCrossing(const Config &config, int32_t height, const
     }
 }
 
+/** Number of blocks that are read ahead while disconnecting consecutive tips. */
+static size_t GetDisconnectPrefetchBlocks()
+{
+    return static_cast<size_t>(
+        std::max<int64_t>(
+            0, gArgs.GetArg("-disconnectprefetchblocks", DEFAULT_DISCONNECT_PREFETCH_BLOCKS)));
+}
+
 /**
  * Disconnect chainActive's tip.
  * After calling, the mempool will be in an inconsistent state, with
@@ -3937,10 +3989,13 @@ static void FinalizeGenesisCrossing(const Config &config, int32_t height, const
  * If disconnectpool is nullptr, then no disconnected transactions are added to
  * disconnectpool (note that the caller is responsible for mempool consistency
  * in any case).
+ *
+ * If prefetcher is not nullptr block and undo data are taken from it.
  */
 static bool DisconnectTip(const Config &config, CValidationState &state,
                           DisconnectedBlockTransactions *disconnectpool,
-                          const CJournalChangeSetPtr& changeSet)
+                          const CJournalChangeSetPtr& changeSet,
+                          CDisconnectDataPrefetcher* prefetcher = nullptr)
 {
     CBlockIndex *pindexDelete = chainActive.Tip();
     assert(pindexDelete);
@@ -3948,19 +4003,25 @@ static bool DisconnectTip(const Config &config, CValidationState &state,
 
     FinalizeGenesisCrossing(config, blockHeight, changeSet);
 
-    // Read block from disk.
-    std::shared_ptr<CBlock> pblock = std::make_shared<CBlock>();
-    CBlock &block = *pblock;
-    if (!pindexDelete->ReadBlockFromDisk(block, config)) {
+    // Read block and undo data from disk (or wait for them to be read).
+    int64_t nReadStart = GetTimeMicros();
+    BlockDisconnectData data =
+        prefetcher ? prefetcher->Get(*pindexDelete) : ReadBlockDisconnectData(config, *pindexDelete);
+    if (!data.block) {
         return AbortNode(state, "Failed to read block");
     }
+    std::shared_ptr<CBlock> pblock = data.block;
+    CBlock &block = *pblock;
+    LogPrint(BCLog::BENCH, "- Load block and undo data: %.2fms\n",
+             (GetTimeMicros() - nReadStart) * 0.001);
 
     // Apply the block atomically to the chain state.
     int64_t nStart = GetTimeMicros();
     {
         CoinsDBSpan pCoinsTipSpan{ *pcoinsTip };
         assert(pCoinsTipSpan.GetBestBlock() == pindexDelete->GetBlockHash());
-        if (ProcessingBlockIndex(*pindexDelete).DisconnectBlock(block, pCoinsTipSpan, task::CCancellationSource::Make()->GetToken()) != DISCONNECT_OK) {
+        if (!data.undo.has_value() ||
+            ProcessingBlockIndex(*pindexDelete).DisconnectBlock(data.undo.value(), block, pCoinsTipSpan, task::CCancellationSource::Make()->GetToken()) != DISCONNECT_OK) {
             return error("DisconnectTip(): DisconnectBlock %s failed",
                          pindexDelete->GetBlockHash().ToString());
         }
@@ -4468,15 +4529,22 @@ static bool ActivateBestChainStep(
                     try
                     {
                         // we are diconnecting until we reach the fork point
+                        CDisconnectDataPrefetcher prefetcher{ config, pindexFork, GetDisconnectPrefetchBlocks() };
+                        int64_t nStart = GetTimeMicros();
+                        int32_t nDisconnected = 0;
                         do
                         {
-                            if (!DisconnectTip(config, state, &disconnectpool, changeSet)) {
+                            if (!DisconnectTip(config, state, &disconnectpool, changeSet, &prefetcher)) {
                                 // This is likely a fatal error.
                                 fDisconnectFailed = true;
                                 return;
                             }
                             fBlocksDisconnected = true;
+                            ++nDisconnected;
                         } while (needTipDisconnect());
+
+                        LogPrint(BCLog::BENCH, "- Disconnect %d blocks: %.2fms\n",
+                                 nDisconnected, (GetTimeMicros() - nStart) * 0.001);
                     }
                     catch( ... )
                     {
@@ -5090,6 +5158,7 @@ bool InvalidateBlock(const Config &config, CValidationState &state,
     bool tip_disconnected = false;
     if (chainActive.Contains(pindex))
     {
+        CDisconnectDataPrefetcher prefetcher{ config, pindex->GetPrev(), GetDisconnectPrefetchBlocks() };
         while (chainActive.Contains(pindex))
         {
             CBlockIndex* pindexWalk = chainActive.Tip();
@@ -5097,7 +5166,7 @@ bool InvalidateBlock(const Config &config, CValidationState &state,
             setBlockIndexCandidates.erase(pindexWalk);
             // ActivateBestChain considers blocks already in chainActive
             // unconditionally valid already, so force disconnect away from it.
-            if (!DisconnectTip(config, state, &disconnectpool, changeSet))
+            if (!DisconnectTip(config, state, &disconnectpool, changeSet, &prefetcher))
             {
                 // It's probably hopeless to try to make the mempool consistent
                 // here if DisconnectTip failed, but we can try.
@@ -5411,13 +5480,13 @@ bool ResetBlockFailureFlags(CBlockIndex *pindex) {
     return true;
 }
 
-static CBlockIndex *AddToBlockIndex(const Config& config, const CBlockHeader &block) {
-    if (auto index = mapBlockIndex.Get( block.GetHash() ); index) {
+static CBlockIndex *AddToBlockIndex(const Config& config, const CBlockHeader &block, const uint256& blockHash) {
+    if (auto index = mapBlockIndex.Get( blockHash ); index) {
         return index;
     }
 
     // Construct new block index object
-    auto pindexNew = mapBlockIndex.Insert( block );
+    auto pindexNew = mapBlockIndex.Insert( block, blockHash );
 
     // Check if adding new block index triggers safe mode
     CheckSafeModeParameters(config, pindexNew);
@@ -5425,6 +5494,10 @@ static CBlockIndex *AddToBlockIndex(const Config& config, const CBlockHeader &bl
     return pindexNew;
 }
 
+static CBlockIndex *AddToBlockIndex(const Config& config, const CBlockHeader &block) {
+    return AddToBlockIndex(config, block, block.GetHash());
+}
+
 void InvalidateChain(const Config& config, const CBlockIndex* pindexNew)
 {
     std::set<CBlockIndex*> setTipCandidates;
@@ -5584,11 +5657,12 @@ static bool ReceivedBlockTransactions(
  * For context-dependant calls, see ContextualCheckBlockHeader.
  */
 static bool CheckBlockHeader(
-    const Config &config, const CBlockHeader &block, CValidationState &state,
+    const Config &config, const CBlockHeader &block, const uint256& blockHash,
+    CValidationState &state,
     BlockValidationOptions validationOptions = BlockValidationOptions()) {
     // Check proof of work matches claimed amount
     if (validationOptions.shouldValidatePoW() &&
-        !CheckProofOfWork(block.GetHash(), block.nBits, config)) {
+        !CheckProofOfWork(blockHash, block.nBits, config)) {
         return state.DoS(50, false, REJECT_INVALID, "high-hash",
                          "proof of work failed");
     }
@@ -5596,6 +5670,12 @@ static bool CheckBlockHeader(
     return true;
 }
 
+static bool CheckBlockHeader(
+    const Config &config, const CBlockHeader &block, CValidationState &state,
+    BlockValidationOptions validationOptions = BlockValidationOptions()) {
+    return CheckBlockHeader(config, block, block.GetHash(), state, validationOptions);
+}
+
 bool CheckBlock(const Config &config, const CBlock &block,
                 CValidationState &state,
                 int32_t blockHeight,
@@ -5971,20 +6051,97 @@ static const CBlockIndex* FindPreviousBlockIndex(const CBlockHeader &block, CVal
     return ppindex;
 }
 
+namespace {
+/**
+ * Result of the context-free checks of a block header (hashing and proof of
+ * work). These don't depend on any shared state, so they can be done without
+ * holding cs_main and in parallel for many headers.
+ */
+struct PreCheckedBlockHeader
+{
+    uint256 hash {};
+    CValidationState state {};
+    bool valid {false};
+};
+
+PreCheckedBlockHeader PreCheckBlockHeader(const Config& config, const CBlockHeader& block)
+{
+    PreCheckedBlockHeader checked {};
+    checked.hash = block.GetHash();
+    checked.valid = CheckBlockHeader(config, block, checked.hash, checked.state);
+    return checked;
+}
+
+/**
+ * Pre-check all headers, splitting the work across threads when there are
+ * enough headers for that to pay off.
+ */
+std::vector<PreCheckedBlockHeader> PreCheckBlockHeaders(
+    const Config& config,
+    const std::vector<CBlockHeader>& headers)
+{
+    // Hashing a header is cheap so there is no point in spawning a thread
+    // for fewer headers than this.
+    constexpr size_t MIN_HEADERS_PER_THREAD {250};
+
+    std::vector<PreCheckedBlockHeader> checked(headers.size());
+    auto checkRange =
+        [&config, &headers, &checked](size_t begin, size_t end)
+        {
+            for(size_t i = begin; i < end; ++i)
+            {
+                checked[i] = PreCheckBlockHeader(config, headers[i]);
+            }
+        };
+
+    const size_t numThreads {
+        std::clamp<size_t>(
+            headers.size() / MIN_HEADERS_PER_THREAD,
+            1,
+            std::max(1u, std::thread::hardware_concurrency()))
+    };
+    const size_t batchSize { (headers.size() + numThreads - 1) / numThreads };
+
+    std::vector<std::future<void>> tasks {};
+    for(size_t begin = batchSize; begin < headers.size(); begin += batchSize)
+    {
+        tasks.push_back(
+            std::async(
+                std::launch::async,
+                checkRange,
+                begin,
+                std::min(begin + batchSize, headers.size())));
+    }
+    // First batch is done by the calling thread.
+    checkRange(0, std::min(batchSize, headers.size()));
+
+    for(auto& task : tasks)
+    {
+        task.get();
+    }
+
+    return checked;
+}
+}
+
 /**
  * If the provided block header is valid, add it to the block index.
  *
+ * The context-free checks of the header must already have been done by
+ * PreCheckBlockHeader() and their result is passed in preChecked.
+ *
  * Returns true if the block is succesfully added to the block index.
  */
-bool AcceptBlockHeader(const Config& config,
-                       const CBlockHeader& block,
-                       CValidationState& state,
-                       CBlockIndex** ppindex)
+static bool AcceptBlockHeader(const Config& config,
+                              const CBlockHeader& block,
+                              const PreCheckedBlockHeader& preChecked,
+                              CValidationState& state,
+                              CBlockIndex** ppindex)
 {
     AssertLockHeld(cs_main);
     const CChainParams &chainparams = config.GetChainParams();
 
-    uint256 hash = block.GetHash();
+    const uint256& hash = preChecked.hash;
     
     if (config.IsBlockInvalidated(hash))
     {
@@ -6009,7 +6166,8 @@ bool AcceptBlockHeader(const Config& config,
             return true;
         }
 
-        if (!CheckBlockHeader(config, block, state)) {
+        if (!preChecked.valid) {
+            state = preChecked.state;
             return error("%s: Consensus::CheckBlockHeader: %s, %s", __func__,
                          hash.ToString(), FormatStateMessage(state));
         }
@@ -6035,7 +6193,7 @@ bool AcceptBlockHeader(const Config& config,
         }
     }
 
-    if (CBlockIndex* newIdx = AddToBlockIndex(config, block); ppindex)
+    if (CBlockIndex* newIdx = AddToBlockIndex(config, block, hash); ppindex)
     {
         *ppindex = newIdx;
     }
@@ -6045,17 +6203,31 @@ bool AcceptBlockHeader(const Config& config,
     return true;
 }
 
+bool AcceptBlockHeader(const Config& config,
+                       const CBlockHeader& block,
+                       CValidationState& state,
+                       CBlockIndex** ppindex)
+{
+    return AcceptBlockHeader(config, block, PreCheckBlockHeader(config, block), state, ppindex);
+}
+
 // Exposed wrapper for AcceptBlockHeader
 bool ProcessNewBlockHeaders(const Config &config,
                             const std::vector<CBlockHeader> &headers,
                             CValidationState &state,
                             const CBlockIndex **ppindex) {
+    // Hash and check PoW of all headers before taking cs_main so that only
+    // the checks which need the block index are done under the lock.
+    const std::vector<PreCheckedBlockHeader> preChecked {
+        PreCheckBlockHeaders(config, headers)
+    };
+
     {
         LOCK(cs_main);
-        for (const CBlockHeader &header : headers) {
+        for (size_t i = 0; i < headers.size(); ++i) {
             // Use a temp pindex instead of ppindex to avoid a const_cast
             CBlockIndex *pindex = nullptr;
-            if (!AcceptBlockHeader(config, header, state, &pindex)) {
+            if (!AcceptBlockHeader(config, headers[i], preChecked[i], state, &pindex)) {
                 return false;
             }
             if (ppindex) {
@@ -6213,6 +6385,8 @@ static bool AcceptBlock(const Config& config,
                 AbortNode(state, "Failed to write block");
             }
         }
+        // Not fatal, without the file transactions are found by scanning the block
+        WriteBlockTxOffsetsFile(block, blockPos.File());
         if (!ReceivedBlockTransactions(config, block, state, pindex, blockPos, metaData, source)) {
             return error("AcceptBlock(): ReceivedBlockTransactions failed");
         }
@@ -6492,12 +6666,16 @@ bool CheckDiskSpace(uint64_t nAdditionalBytes) {
 }
 
 static bool LoadBlockIndexDB(const CChainParams &chainparams) {
+    const int64_t nLoadStart = GetTimeMillis();
     if (!BlockIndexStoreLoader(mapBlockIndex).ForceLoad(
             GlobalConfig::GetConfig(),
-            pblocktree->GetIterator()))
+            [] { return pblocktree->GetIterator(); },
+            static_cast<size_t>(std::max(GetNumCores(), 1))))
     {
         return false;
     }
+    LogPrintf("Loaded %d block index entries in %dms\n",
+              mapBlockIndex.Count(), GetTimeMillis() - nLoadStart);
 
     boost::this_thread::interruption_point();
 
@@ -6788,41 +6966,127 @@ bool CVerifyDB::VerifyDB(const Config &config, CoinsDB& coinsview,
  * Apply the effects of a block on the utxo cache, ignoring that it may already
  * have been applied.
  */
-static bool RollforwardBlock(const CBlockIndex *pindex, CoinsDBSpan &inputs,
-                             const Config &config) {
+/**
+ * Re-apply a block to the coins database.
+ *
+ * Transactions are split into groups that do not spend outputs of each other
+ * and the groups are applied in parallel on separate shards of the cache, in
+ * the same way as they are validated in ConnectBlock().
+ */
+static bool RollforwardBlock(const CBlockIndex *pindex, const CBlock& block,
+                             CoinsDB& view, const Config &config) {
     // TODO: merge with ConnectBlock
-    auto blockStreamReader = pindex->GetDiskBlockStreamReader(config);
-    if (!blockStreamReader) {
-        return error("ReplayBlock(): GetDiskBlockStreamReader(CBlockIndex) failed at %d, hash=%s",
-                     pindex->GetHeight(), pindex->GetBlockHash().ToString());
-    }
+    int64_t nStart = GetTimeMicros();
+    CoinsDBSpan inputs{ view };
+
+    size_t maxThreads { static_cast<size_t>(config.GetPerBlockTxnValidatorThreadsCount()) };
+    uint64_t batchSize { config.GetBlockValidationTxBatchSize() };
+    size_t numThreads { std::clamp(block.vtx.size() / batchSize, size_t(1), maxThreads) };
 
-    while (!blockStreamReader->EndOfStream()) {
-        const CTransaction* tx = blockStreamReader->ReadTransaction_NoThrow();
-        if(!tx)
+    TxnGrouper grouper {};
+    const std::vector<TxnGrouper::UPtrTxnGroup> txnGroups { grouper.GetNumGroups(block.vtx, numThreads, batchSize) };
+
+    inputs.CacheInputs(block.vtx);
+
+    const int32_t height { pindex->GetHeight() };
+    const int32_t genesisActivationHeight { config.GetGenesisActivationHeight() };
+    inputs.RunSharded(
+        static_cast<uint16_t>(txnGroups.size()),
+        [&txnGroups, height, genesisActivationHeight](uint16_t groupNum, CCoinsViewCache::Shard& shard)
         {
-            return error("ReplayBlock(): ReadTransaction failed at %d, hash=%s",
-                pindex->GetHeight(), pindex->GetBlockHash().ToString());
-        }
-        if (!tx->IsCoinBase()) {
-            for (const CTxIn &txin : tx->vin) {
-                inputs.SpendCoin(txin.prevout);
+            for (const auto& txnAndIndex : *txnGroups[groupNum]) {
+                const CTransaction& tx { *txnAndIndex.mTxn };
+                if (!tx.IsCoinBase()) {
+                    for (const CTxIn &txin : tx.vin) {
+                        shard.SpendCoin(txin.prevout);
+                    }
+                }
+
+                // Pass check = true as every addition may be an overwrite.
+                AddCoins(shard, tx, CFrozenTXOCheck::IsConfiscationTx(tx), height, genesisActivationHeight, true);
             }
-        }
+            return true;
+        });
+
+    inputs.SetBestBlock(pindex->GetBlockHash());
+
+    // NOTE:
+    // TryFlush() will never fail as cs_main is used to synchronize
+    // the different threads that Flush() or TryFlush() data. If cs_main
+    // guarantee is removed we must decide what to do in this case.
+    auto flushed = inputs.TryFlush();
+    assert(flushed == CoinsDBSpan::WriteState::ok);
+
+    LogPrint(BCLog::BENCH, "- Roll forward block: %.2fms, %zu transactions in %zu groups\n",
+             (GetTimeMicros() - nStart) * 0.001, block.vtx.size(), txnGroups.size());
+    return true;
+}
 
-        // Pass check = true as every addition may be an overwrite.
-        AddCoins(inputs, *tx, CFrozenTXOCheck::IsConfiscationTx(*tx), pindex->GetHeight(), config.GetGenesisActivationHeight(), true);
+/**
+ * Roll back the coins database along the old branch, from pindexOld to
+ * pindexFork.
+ */
+static bool RollbackBlocks(const Config &config, CoinsDB& view,
+                           const CBlockIndex *pindexOld,
+                           const CBlockIndex *pindexFork) {
+    CoinsDBSpan cache{ view };
+
+    // Block and undo data of the following blocks are read while the current
+    // one is being rolled back.
+    CDisconnectDataPrefetcher prefetcher{ config, pindexFork, GetDisconnectPrefetchBlocks() };
+    while (pindexOld != pindexFork) {
+        if (pindexOld->GetHeight() > 0) {
+            // Never disconnect the genesis block.
+            BlockDisconnectData data = prefetcher.Get(*pindexOld);
+            if (!data.block) {
+                return error("RollbackBlock(): ReadBlockFromDisk() failed at "
+                             "%d, hash=%s",
+                             pindexOld->GetHeight(),
+                             pindexOld->GetBlockHash().ToString());
+            }
+            if (!data.undo.has_value()) {
+                return error("RollbackBlock(): no undo data available at "
+                             "%d, hash=%s",
+                             pindexOld->GetHeight(),
+                             pindexOld->GetBlockHash().ToString());
+            }
+            LogPrintf("Rolling back %s (%i)\n",
+                      pindexOld->GetBlockHash().ToString(), pindexOld->GetHeight());
+            // Use new private CancellationSource that can not be cancelled
+            DisconnectResult res = ProcessingBlockIndex(const_cast<CBlockIndex&>(*pindexOld)).DisconnectBlock(data.undo.value(), *data.block, cache, task::CCancellationSource::Make()->GetToken());
+            if (res == DISCONNECT_FAILED) {
+                return error(
+                    "RollbackBlock(): DisconnectBlock failed at %d, hash=%s",
+                    pindexOld->GetHeight(), pindexOld->GetBlockHash().ToString());
+            }
+            // If DISCONNECT_UNCLEAN is returned, it means a non-existing UTXO
+            // was deleted, or an existing UTXO was overwritten. It corresponds
+            // to cases where the block-to-be-disconnect never had all its
+            // operations applied to the UTXO set. However, as both writing a
+            // UTXO and deleting a UTXO are idempotent operations, the result is
+            // still a version of the UTXO set with the effects of that block
+            // undone.
+        }
+        pindexOld = pindexOld->GetPrev();
     }
 
+    if (pindexFork) {
+        cache.SetBestBlock(pindexFork->GetBlockHash());
+
+        // NOTE:
+        // TryFlush() will never fail as cs_main is used to synchronize
+        // the different threads that Flush() or TryFlush() data. If cs_main
+        // guarantee is removed we must decide what to do in this case.
+        auto flushed = cache.TryFlush();
+        assert(flushed == CoinsDBSpan::WriteState::ok);
+    }
     return true;
 }
 
 bool ReplayBlocks(const Config &config, CoinsDB& view) {
     LOCK(cs_main);
 
-    CoinsDBSpan cache( view );
-
-    std::vector<uint256> hashHeads = cache.GetHeadBlocks();
+    std::vector<uint256> hashHeads = CoinsDBSpan{ view }.GetHeadBlocks();
     if (hashHeads.empty()) {
         // We're already in a consistent state.
         return true;
@@ -6859,48 +7123,46 @@ bool ReplayBlocks(const Config &config, CoinsDB& view) {
     }
 
     // Rollback along the old branch.
-    while (pindexOld != pindexFork) {
-        if (pindexOld->GetHeight() > 0) {
-            // Never disconnect the genesis block.
-            CBlock block;
-            if (!pindexOld->ReadBlockFromDisk(block, config)) {
-                return error("RollbackBlock(): ReadBlockFromDisk() failed at "
-                             "%d, hash=%s",
-                             pindexOld->GetHeight(),
-                             pindexOld->GetBlockHash().ToString());
-            }
-            LogPrintf("Rolling back %s (%i)\n",
-                      pindexOld->GetBlockHash().ToString(), pindexOld->GetHeight());
-            // Use new private CancellationSource that can not be cancelled
-            DisconnectResult res = ProcessingBlockIndex(const_cast<CBlockIndex&>(*pindexOld)).DisconnectBlock(block, cache, task::CCancellationSource::Make()->GetToken());
-            if (res == DISCONNECT_FAILED) {
-                return error(
-                    "RollbackBlock(): DisconnectBlock failed at %d, hash=%s",
-                    pindexOld->GetHeight(), pindexOld->GetBlockHash().ToString());
-            }
-            // If DISCONNECT_UNCLEAN is returned, it means a non-existing UTXO
-            // was deleted, or an existing UTXO was overwritten. It corresponds
-            // to cases where the block-to-be-disconnect never had all its
-            // operations applied to the UTXO set. However, as both writing a
-            // UTXO and deleting a UTXO are idempotent operations, the result is
-            // still a version of the UTXO set with the effects of that block
-            // undone.
-        }
-        pindexOld = pindexOld->GetPrev();
+    if (!RollbackBlocks(config, view, pindexOld, pindexFork)) {
+        return false;
     }
 
     // Roll forward from the forking point to the new tip.
+    // Every block is applied with a separate span of the coins database
+    // while the following block is being read from disk.
+    auto readBlock =
+        [&config](const CBlockIndex* pindex) -> std::shared_ptr<const CBlock>
+        {
+            auto block = std::make_shared<CBlock>();
+            if (!pindex->ReadBlockFromDisk(*block, config)) {
+                return nullptr;
+            }
+            return block;
+        };
     int32_t nForkHeight = pindexFork ? pindexFork->GetHeight() : 0;
+    std::future<std::shared_ptr<const CBlock>> nextBlock;
+    if (nForkHeight < pindexNew->GetHeight()) {
+        nextBlock = std::async(std::launch::async, readBlock, pindexNew->GetAncestor(nForkHeight + 1));
+    }
     for (int32_t nHeight = nForkHeight + 1; nHeight <= pindexNew->GetHeight();
          ++nHeight) {
         const CBlockIndex *pindex = pindexNew->GetAncestor(nHeight);
+        std::shared_ptr<const CBlock> block = nextBlock.get();
+        if (nHeight < pindexNew->GetHeight()) {
+            nextBlock = std::async(std::launch::async, readBlock, pindexNew->GetAncestor(nHeight + 1));
+        }
+        if (!block) {
+            return error("ReplayBlock(): ReadBlockFromDisk() failed at %d, hash=%s",
+                         nHeight, pindex->GetBlockHash().ToString());
+        }
         LogPrintf("Rolling forward %s (%i)\n",
                   pindex->GetBlockHash().ToString(), nHeight);
-        if (!RollforwardBlock(pindex, cache, config)) {
+        if (!RollforwardBlock(pindex, *block, view, config)) {
             return false;
         }
     }
 
+    CoinsDBSpan cache{ view };
     cache.SetBestBlock(pindexNew->GetBlockHash());
 
     // NOTE:
@@ -6924,6 +7186,7 @@ bool RewindBlockIndex(const Config &config) {
     CValidationState state;
     CBlockIndex *pindex = chainActive.Tip();
     CJournalChangeSetPtr changeSet { mempool.getJournalBuilder().getNewChangeSet(JournalUpdateReason::REORG) };
+    CDisconnectDataPrefetcher prefetcher{ config, chainActive[nHeight - 1], GetDisconnectPrefetchBlocks() };
     while (chainActive.Height() >= nHeight) {
         if (fPruneMode && !chainActive.Tip()->getStatus().hasData()) {
             // If pruning, don't try rewinding past the HAVE_DATA point; since
@@ -6932,7 +7195,7 @@ bool RewindBlockIndex(const Config &config) {
             // needless reindex/redownload of the blockchain).
             break;
         }
-        if (!DisconnectTip(config, state, nullptr, changeSet)) {
+        if (!DisconnectTip(config, state, nullptr, changeSet, &prefetcher)) {
             return error(
                 "RewindBlockIndex: unable to disconnect block at height %i",
                 pindex->GetHeight());
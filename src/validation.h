@@ -97,6 +97,9 @@ static const uint64_t DEFAULT_SECONDARY_MEMPOOL_ANCESTOR_LIMIT = 25;
 /** Default for -mempoolexpiry, expiration time for mempool transactions in
  * hours */
 static const unsigned int DEFAULT_MEMPOOL_EXPIRY = 336;
+/** Default for -mempoolviewmaxage, how long (in milliseconds) a mempool view
+ * may be reused by RPC and REST requests after the mempool has changed */
+static const unsigned int DEFAULT_MEMPOOL_VIEW_MAX_AGE = 0;
 /** Default for -nonfinalmempoolexpiry, expiration time for non-final mempool transactions in hours */
 static const unsigned int DEFAULT_NONFINAL_MEMPOOL_EXPIRY = 4 * 7 * 24;
 /** Default for -mempoolnonfinalmaxreplacementrate, max update rate for non-final transactions (by default in txns/hour) */
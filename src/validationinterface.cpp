@@ -19,6 +19,7 @@ void UnregisterAllValidationInterfaces() {
     g_signals.TransactionAddedToMempool.disconnect_all_slots();
     g_signals.TransactionRemovedFromMempool.disconnect_all_slots();
     g_signals.TransactionRemovedFromMempoolBlock.disconnect_all_slots();
+    g_signals.MempoolDelta.disconnect_all_slots();
     g_signals.BlockConnected.disconnect_all_slots();
     g_signals.BlockConnected2.disconnect_all_slots();
     g_signals.ScriptForMining.disconnect_all_slots();
@@ -45,6 +45,7 @@ protected:
                                                MemPoolRemovalReason reason,
                                                const CTransactionConflict& conflictedWith) {}
     virtual void TransactionRemovedFromMempoolBlock(const uint256& txid, MemPoolRemovalReason reason) {}
+    virtual void MempoolDelta(const CMempoolDelta& delta) {}
     virtual void TransactionAdded(const CTransactionRef& ptxn) {}
     virtual void BlockConnected(const std::shared_ptr<const CBlock> &block,
                    const CBlockIndex *pindex,
@@ -81,6 +82,13 @@ struct CMainSignals {
      */
     boost::signals2::signal<void(const uint256 &, MemPoolRemovalReason reason)>
         TransactionRemovedFromMempoolBlock;
+    /**
+     * Notifies listeners of every addition to and removal from mempool.
+     * Called while the mempool lock is held so deltas are delivered in the
+     * order of their sequence numbers; listeners must not call back into
+     * the mempool.
+     */
+    boost::signals2::signal<void(const CMempoolDelta &)> MempoolDelta;
     /**
      * Notifies listeners of a block being connected.
      * Provides a vector of transactions evicted from the mempool as a result.
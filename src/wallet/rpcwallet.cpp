@@ -15,6 +15,8 @@
 #include "net/net.h"
 #include "policy/fees.h"
 #include "policy/policy.h"
+#include "rpc/http_protocol.h"
+#include "rpc/jsonwriter.h"
 #include "rpc/mining.h"
 #include "rpc/misc.h"
 #include "rpc/server.h"
@@ -30,6 +32,8 @@
 
 #include <event2/http.h>
 
+#include <optional>
+
 static const std::string WALLET_ENDPOINT_BASE = "/wallet/";
 
 static std::string urlDecode(const std::string &urlEncoded) {
@@ -132,6 +136,54 @@ void WalletTxToJSON(const CWalletTx &wtx, UniValue &entry) {
     }
 }
 
+/**
+ * Maximum number of wallet entries that streaming RPCs process while holding
+ * cs_wallet. The lock is released between batches so that large results do not
+ * block other wallet users for the whole duration of the call.
+ */
+static constexpr size_t WALLET_RPC_ENTRIES_PER_LOCK = 1000;
+
+/**
+ * Write JSON-RPC reply to the HTTP response in chunks. The result itself is
+ * produced by writeResult which can write it incrementally.
+ */
+static void StreamWalletRPCReply(
+    const JSONRPCRequest &request,
+    HTTPRequest &httpReq,
+    bool processedInBatch,
+    const std::function<void(CJSONWriter &)> &writeResult) {
+
+    if (!processedInBatch) {
+        httpReq.WriteHeader("Content-Type", "application/json");
+        httpReq.StartWritingChunks(HTTP_OK);
+    }
+
+    {
+        CHttpTextWriter httpWriter(httpReq);
+        CJSONWriter jWriter(httpWriter, false);
+
+        jWriter.writeBeginObject();
+        jWriter.pushKNoComma("result");
+        writeResult(jWriter);
+        jWriter.pushKV("error", nullptr);
+        jWriter.pushKVJSONFormatted("id", request.id.write());
+        jWriter.writeEndObject();
+        jWriter.flush();
+    }
+
+    if (!processedInBatch) {
+        httpReq.StopWritingChunks();
+    }
+}
+
+/** Write values as elements of the currently open JSON array. */
+static void WriteArrayElements(CJSONWriter &jWriter,
+                               const std::vector<UniValue> &values) {
+    for (const UniValue &value : values) {
+        jWriter.pushVJSONFormatted(value.write());
+    }
+}
+
 std::string AccountFromValue(const UniValue &value) {
     std::string strAccount = value.get_str();
     if (strAccount == "*") {
@@ -1385,79 +1437,148 @@ struct tallyitem {
     }
 };
 
-static UniValue ListReceived(
-    const Config &config,
-    CWallet *const pwallet,
-    const UniValue &params,
-    bool fByAccounts,
-    int32_t nChainActiveHeight,
-    int nMedianTimePast) {
-
+struct ListReceivedParams {
     // Minimum confirmations
     int nMinDepth = 1;
-    if (params.size() > 0) {
-        nMinDepth = params[0].get_int();
-    }
-
     // Whether to include empty accounts
     bool fIncludeEmpty = false;
+    isminefilter filter = ISMINE_SPENDABLE;
+};
+
+static ListReceivedParams ParseListReceivedParams(const UniValue &params) {
+    ListReceivedParams parsed;
+    if (params.size() > 0) {
+        parsed.nMinDepth = params[0].get_int();
+    }
     if (params.size() > 1) {
-        fIncludeEmpty = params[1].get_bool();
+        parsed.fIncludeEmpty = params[1].get_bool();
     }
-
-    isminefilter filter = ISMINE_SPENDABLE;
     if (params.size() > 2 && params[2].get_bool()) {
-        filter = filter | ISMINE_WATCH_ONLY;
+        parsed.filter = parsed.filter | ISMINE_WATCH_ONLY;
     }
+    return parsed;
+}
 
-    // Tally
-    std::map<CTxDestination, tallyitem> mapTally;
-    for (const auto& pairWtx : pwallet->mapWallet) {
-        const CWalletTx &wtx = pairWtx.second;
-
-        CValidationState state;
-        if (wtx.IsCoinBase() ||
-            !ContextualCheckTransactionForCurrentBlock(
-                config,
-               *wtx.tx,
-                nChainActiveHeight,
-                nMedianTimePast,
-                state)) {
-            continue;
-        }
-
-        int nDepth = wtx.GetDepthInMainChain();
-        if (nDepth < nMinDepth) {
-            continue;
-        }
+/**
+ * Tally received amounts per address. Wallet transactions are visited in
+ * batches of WALLET_RPC_ENTRIES_PER_LOCK and cs_wallet is released between
+ * them (unless the caller already holds it).
+ */
+static std::map<CTxDestination, tallyitem> TallyReceived(
+    const Config &config,
+    CWallet *const pwallet,
+    const ListReceivedParams &params,
+    int32_t nChainActiveHeight,
+    int nMedianTimePast) {
 
-        for (const CTxOut &txout : wtx.tx->vout) {
-            CTxDestination address;
-            if (!CWallet::ExtractDestination(txout.scriptPubKey, address)) {
+    std::map<CTxDestination, tallyitem> mapTally;
+    std::optional<uint256> lastVisited;
+    bool more = true;
+    while (more) {
+        LOCK2(cs_main, pwallet->cs_wallet);
+        auto it = lastVisited ? pwallet->mapWallet.upper_bound(*lastVisited)
+                              : pwallet->mapWallet.begin();
+        for (size_t visited = 0;
+             it != pwallet->mapWallet.end() &&
+             visited < WALLET_RPC_ENTRIES_PER_LOCK;
+             ++it, ++visited) {
+            lastVisited = it->first;
+            const CWalletTx &wtx = it->second;
+
+            CValidationState state;
+            if (wtx.IsCoinBase() ||
+                !ContextualCheckTransactionForCurrentBlock(
+                    config,
+                   *wtx.tx,
+                    nChainActiveHeight,
+                    nMedianTimePast,
+                    state)) {
                 continue;
             }
 
-            isminefilter mine = IsMine(*pwallet, address);
-            if (!(mine & filter)) {
+            int nDepth = wtx.GetDepthInMainChain();
+            if (nDepth < params.nMinDepth) {
                 continue;
             }
 
-            tallyitem &item = mapTally[address];
-            item.nAmount += txout.nValue;
-            item.nConf = std::min(item.nConf, nDepth);
-            item.txids.push_back(wtx.GetId());
-            if (mine & ISMINE_WATCH_ONLY) {
-                item.fIsWatchonly = true;
+            for (const CTxOut &txout : wtx.tx->vout) {
+                CTxDestination address;
+                if (!CWallet::ExtractDestination(txout.scriptPubKey, address)) {
+                    continue;
+                }
+
+                isminefilter mine = IsMine(*pwallet, address);
+                if (!(mine & params.filter)) {
+                    continue;
+                }
+
+                tallyitem &item = mapTally[address];
+                item.nAmount += txout.nValue;
+                item.nConf = std::min(item.nConf, nDepth);
+                item.txids.push_back(wtx.GetId());
+                if (mine & ISMINE_WATCH_ONLY) {
+                    item.fIsWatchonly = true;
+                }
             }
         }
+        more = (it != pwallet->mapWallet.end());
     }
 
+    return mapTally;
+}
+
+static UniValue ReceivedByAddressToJSON(const CTxDestination &dest,
+                                        const std::string &accountName,
+                                        const tallyitem *item) {
+    Amount nAmount(0);
+    int nConf = std::numeric_limits<int>::max();
+    bool fIsWatchonly = false;
+    if (item) {
+        nAmount = item->nAmount;
+        nConf = item->nConf;
+        fIsWatchonly = item->fIsWatchonly;
+    }
+
+    UniValue obj(UniValue::VOBJ);
+    if (fIsWatchonly) {
+        obj.push_back(Pair("involvesWatchonly", true));
+    }
+    obj.push_back(Pair("address", EncodeDestination(dest)));
+    obj.push_back(Pair("account", accountName));
+    obj.push_back(Pair("amount", ValueFromAmount(nAmount)));
+    obj.push_back(
+        Pair("confirmations",
+             (nConf == std::numeric_limits<int>::max() ? 0 : nConf)));
+    obj.push_back(Pair("label", accountName));
+    UniValue transactions(UniValue::VARR);
+    if (item) {
+        for (const uint256 &txid : item->txids) {
+            transactions.push_back(txid.GetHex());
+        }
+    }
+    obj.push_back(Pair("txids", transactions));
+    return obj;
+}
+
+static UniValue ListReceivedByAccount(
+    const Config &config,
+    CWallet *const pwallet,
+    const UniValue &params,
+    int32_t nChainActiveHeight,
+    int nMedianTimePast) {
+
+    const ListReceivedParams parsed = ParseListReceivedParams(params);
+
+    // Tally
+    std::map<CTxDestination, tallyitem> mapTally = TallyReceived(
+        config, pwallet, parsed, nChainActiveHeight, nMedianTimePast);
+
     // Reply
     UniValue ret(UniValue::VARR);
     std::map<std::string, tallyitem> mapAccountTally;
     for (const auto &[dest, account]: pwallet->mapAddressBook) {
         std::map<CTxDestination, tallyitem>::iterator it = mapTally.find(dest);
-        if (it == mapTally.end() && !fIncludeEmpty) {
+        if (it == mapTally.end() && !parsed.fIncludeEmpty) {
             continue;
         }
 
@@ -1470,63 +1591,39 @@ static UniValue ListReceived(
             fIsWatchonly = (*it).second.fIsWatchonly;
         }
 
-        if (fByAccounts) {
-            tallyitem &_item = mapAccountTally[account.name];
-            _item.nAmount += nAmount;
-            _item.nConf = std::min(_item.nConf, nConf);
-            _item.fIsWatchonly = fIsWatchonly;
-        } else {
-            UniValue obj(UniValue::VOBJ);
-            if (fIsWatchonly) {
-                obj.push_back(Pair("involvesWatchonly", true));
-            }
-            obj.push_back(Pair("address", EncodeDestination(dest)));
-            obj.push_back(Pair("account", account.name));
-            obj.push_back(Pair("amount", ValueFromAmount(nAmount)));
-            obj.push_back(
-                Pair("confirmations",
-                     (nConf == std::numeric_limits<int>::max() ? 0 : nConf)));
-            if (!fByAccounts) {
-                obj.push_back(Pair("label", account.name));
-            }
-            UniValue transactions(UniValue::VARR);
-            if (it != mapTally.end()) {
-                for (const uint256 &_item : (*it).second.txids) {
-                    transactions.push_back(_item.GetHex());
-                }
-            }
-            obj.push_back(Pair("txids", transactions));
-            ret.push_back(obj);
-        }
+        tallyitem &_item = mapAccountTally[account.name];
+        _item.nAmount += nAmount;
+        _item.nConf = std::min(_item.nConf, nConf);
+        _item.fIsWatchonly = fIsWatchonly;
     }
 
-    if (fByAccounts) {
-        for (std::map<std::string, tallyitem>::iterator it =
-                 mapAccountTally.begin();
-             it != mapAccountTally.end(); ++it) {
-            Amount nAmount = (*it).second.nAmount;
-            int nConf = (*it).second.nConf;
-            UniValue obj(UniValue::VOBJ);
-            if ((*it).second.fIsWatchonly) {
-                obj.push_back(Pair("involvesWatchonly", true));
-            }
-            obj.push_back(Pair("account", (*it).first));
-            obj.push_back(Pair("amount", ValueFromAmount(nAmount)));
-            obj.push_back(
-                Pair("confirmations",
-                     (nConf == std::numeric_limits<int>::max() ? 0 : nConf)));
-            ret.push_back(obj);
+    for (std::map<std::string, tallyitem>::iterator it =
+             mapAccountTally.begin();
+         it != mapAccountTally.end(); ++it) {
+        Amount nAmount = (*it).second.nAmount;
+        int nConf = (*it).second.nConf;
+        UniValue obj(UniValue::VOBJ);
+        if ((*it).second.fIsWatchonly) {
+            obj.push_back(Pair("involvesWatchonly", true));
         }
+        obj.push_back(Pair("account", (*it).first));
+        obj.push_back(Pair("amount", ValueFromAmount(nAmount)));
+        obj.push_back(
+            Pair("confirmations",
+                 (nConf == std::numeric_limits<int>::max() ? 0 : nConf)));
+        ret.push_back(obj);
     }
 
     return ret;
 }
 
-static UniValue listreceivedbyaddress(const Config &config,
-                                      const JSONRPCRequest &request) {
+static void listreceivedbyaddress(const Config &config,
+                                  const JSONRPCRequest &request,
+                                  HTTPRequest *httpReq,
+                                  bool processedInBatch) {
     CWallet *const pwallet = GetWalletForJSONRPCRequest(request);
     if (!EnsureWalletIsAvailable(pwallet, request.fHelp)) {
-        return NullUniValue;
+        return;
     }
 
     if (request.fHelp || request.params.size() > 3) {
@@ -1573,14 +1670,59 @@ static UniValue listreceivedbyaddress(const Config &config,
             HelpExampleRpc("listreceivedbyaddress", "6, true, true"));
     }
 
-    LOCK2(cs_main, pwallet->cs_wallet);
-    return ListReceived(
-                config,
-                pwallet,
-                request.params,
-                false,
-                chainActive.Height(),
-                chainActive.Tip()->GetMedianTimePast());
+    if (httpReq == nullptr) {
+        return;
+    }
+
+    const ListReceivedParams parsed = ParseListReceivedParams(request.params);
+
+    int32_t nChainActiveHeight;
+    int nMedianTimePast;
+    {
+        LOCK(cs_main);
+        nChainActiveHeight = chainActive.Height();
+        nMedianTimePast = chainActive.Tip()->GetMedianTimePast();
+    }
+
+    const std::map<CTxDestination, tallyitem> mapTally = TallyReceived(
+        config, pwallet, parsed, nChainActiveHeight, nMedianTimePast);
+
+    StreamWalletRPCReply(request, *httpReq, processedInBatch,
+        [&](CJSONWriter &jWriter) {
+            jWriter.writeBeginArray();
+
+            // Address book is rendered in batches and written out after
+            // cs_wallet is released.
+            std::optional<CTxDestination> lastVisited;
+            bool more = true;
+            while (more) {
+                std::vector<UniValue> batch;
+                {
+                    LOCK(pwallet->cs_wallet);
+                    const auto &addressBook = pwallet->mapAddressBook;
+                    auto it = lastVisited ? addressBook.upper_bound(*lastVisited)
+                                          : addressBook.begin();
+                    for (size_t visited = 0;
+                         it != addressBook.end() &&
+                         visited < WALLET_RPC_ENTRIES_PER_LOCK;
+                         ++it, ++visited) {
+                        lastVisited = it->first;
+                        auto tally = mapTally.find(it->first);
+                        if (tally == mapTally.end() && !parsed.fIncludeEmpty) {
+                            continue;
+                        }
+                        batch.push_back(ReceivedByAddressToJSON(
+                            it->first,
+                            it->second.name,
+                            tally == mapTally.end() ? nullptr : &tally->second));
+                    }
+                    more = (it != addressBook.end());
+                }
+                WriteArrayElements(jWriter, batch);
+            }
+
+            jWriter.writeEndArray();
+        });
 }
 
 static UniValue listreceivedbyaccount(const Config &config,
@@ -1627,11 +1769,10 @@ static UniValue listreceivedbyaccount(const Config &config,
 
     LOCK2(cs_main, pwallet->cs_wallet);
 
-    return ListReceived(
+    return ListReceivedByAccount(
                 config,
                 pwallet,
                 request.params,
-                true,
                 chainActive.Height(),
                 chainActive.Tip()->GetMedianTimePast());
 }
@@ -1738,11 +1879,13 @@ void AcentryToJSON(const CAccountingEntry &acentry,
     }
 }
 
-static UniValue listtransactions(const Config &config,
-                                 const JSONRPCRequest &request) {
+static void listtransactions(const Config &config,
+                             const JSONRPCRequest &request,
+                             HTTPRequest *httpReq,
+                             bool processedInBatch) {
     CWallet *const pwallet = GetWalletForJSONRPCRequest(request);
     if (!EnsureWalletIsAvailable(pwallet, request.fHelp)) {
-        return NullUniValue;
+        return;
     }
 
     if (request.fHelp || request.params.size() > 4) {
@@ -1845,7 +1988,9 @@ static UniValue listtransactions(const Config &config,
             HelpExampleRpc("listtransactions", "\"*\", 20, 100"));
     }
 
-    LOCK2(cs_main, pwallet->cs_wallet);
+    if (httpReq == nullptr) {
+        return;
+    }
 
     std::string strAccount = "*";
     if (request.params.size() > 0) {
@@ -1875,23 +2020,40 @@ static UniValue listtransactions(const Config &config,
     }
     UniValue ret(UniValue::VARR);
 
-    const CWallet::TxItems &txOrdered = pwallet->wtxOrdered;
+    // iterate backwards until we have nCount items to return. Entries are
+    // visited in batches and the locks are released between them; a batch
+    // only ends between two different order positions so that it can be
+    // resumed from the last visited one.
+    std::optional<int64_t> lastVisited;
+    bool more = true;
+    while (more) {
+        LOCK2(cs_main, pwallet->cs_wallet);
+        const CWallet::TxItems &txOrdered = pwallet->wtxOrdered;
+
+        auto it = lastVisited ? std::make_reverse_iterator(
+                                    txOrdered.lower_bound(*lastVisited))
+                              : txOrdered.rbegin();
+        for (size_t visited = 0; it != txOrdered.rend(); ++it, ++visited) {
+            if (visited >= WALLET_RPC_ENTRIES_PER_LOCK &&
+                it->first != *lastVisited) {
+                break;
+            }
+            lastVisited = it->first;
 
-    // iterate backwards until we have nCount items to return:
-    for (CWallet::TxItems::const_reverse_iterator it = txOrdered.rbegin();
-         it != txOrdered.rend(); ++it) {
-        CWalletTx *const pwtx = (*it).second.first;
-        if (pwtx != 0) {
-            ListTransactions(pwallet, *pwtx, strAccount, 0, true, ret, filter);
-        }
-        CAccountingEntry *const pacentry = (*it).second.second;
-        if (pacentry != 0) {
-            AcentryToJSON(*pacentry, strAccount, ret);
-        }
+            CWalletTx *const pwtx = (*it).second.first;
+            if (pwtx != 0) {
+                ListTransactions(pwallet, *pwtx, strAccount, 0, true, ret, filter);
+            }
+            CAccountingEntry *const pacentry = (*it).second.second;
+            if (pacentry != 0) {
+                AcentryToJSON(*pacentry, strAccount, ret);
+            }
 
-        if ((int)ret.size() >= (nCount + nFrom)) {
-            break;
+            if ((int)ret.size() >= (nCount + nFrom)) {
+                break;
+            }
         }
+        more = (it != txOrdered.rend() && (int)ret.size() < (nCount + nFrom));
     }
 
     // ret is newest to oldest
@@ -1903,28 +2065,17 @@ static UniValue listtransactions(const Config &config,
         nCount = ret.size() - nFrom;
     }
 
-    std::vector<UniValue> arrTmp = ret.getValues();
-
-    std::vector<UniValue>::iterator first = arrTmp.begin();
-    std::advance(first, nFrom);
-    std::vector<UniValue>::iterator last = arrTmp.begin();
-    std::advance(last, nFrom + nCount);
-
-    if (last != arrTmp.end()) {
-        arrTmp.erase(last, arrTmp.end());
-    }
-    if (first != arrTmp.begin()) {
-        arrTmp.erase(arrTmp.begin(), first);
-    }
+    const std::vector<UniValue> &arrTmp = ret.getValues();
 
     // Return oldest to newest
-    std::reverse(arrTmp.begin(), arrTmp.end());
-
-    ret.clear();
-    ret.setArray();
-    ret.push_backV(arrTmp);
-
-    return ret;
+    StreamWalletRPCReply(request, *httpReq, processedInBatch,
+        [&](CJSONWriter &jWriter) {
+            jWriter.writeBeginArray();
+            for (int i = nFrom + nCount - 1; i >= nFrom; --i) {
+                jWriter.pushVJSONFormatted(arrTmp[i].write());
+            }
+            jWriter.writeEndArray();
+        });
 }
 
 static UniValue listaccounts(const Config &config,
@@ -2022,11 +2173,13 @@ static UniValue listaccounts(const Config &config,
     return ret;
 }
 
-static UniValue listsinceblock(const Config &config,
-                               const JSONRPCRequest &request) {
+static void listsinceblock(const Config &config,
+                           const JSONRPCRequest &request,
+                           HTTPRequest *httpReq,
+                           bool processedInBatch) {
     CWallet *const pwallet = GetWalletForJSONRPCRequest(request);
     if (!EnsureWalletIsAvailable(pwallet, request.fHelp)) {
-        return NullUniValue;
+        return;
     }
 
     if (request.fHelp) {
@@ -2110,25 +2263,17 @@ static UniValue listsinceblock(const Config &config,
                                              "\", 6"));
     }
 
-    LOCK2(cs_main, pwallet->cs_wallet);
+    if (httpReq == nullptr) {
+        return;
+    }
 
     const CBlockIndex *pindex = nullptr;
     int target_confirms = 1;
     isminefilter filter = ISMINE_SPENDABLE;
 
+    uint256 blockId;
     if (request.params.size() > 0) {
-        uint256 blockId;
-
         blockId.SetHex(request.params[0].get_str());
-        if (pindex = mapBlockIndex.Get(blockId); pindex)
-        {
-            if (chainActive[pindex->GetHeight()] != pindex) {
-                // the block being asked for is a part of a deactivated chain;
-                // we don't want to depend on its perceived height in the block
-                // chain, we want to instead use the last common ancestor
-                pindex = chainActive.FindFork(pindex);
-            }
-        }
     }
 
     if (request.params.size() > 1) {
@@ -2143,27 +2288,66 @@ static UniValue listsinceblock(const Config &config,
         filter = filter | ISMINE_WATCH_ONLY;
     }
 
-    int depth = pindex ? (1 + chainActive.Height() - pindex->GetHeight()) : -1;
+    int depth;
+    uint256 lastblock;
+    {
+        LOCK(cs_main);
 
-    UniValue transactions(UniValue::VARR);
+        if (request.params.size() > 0 &&
+            (pindex = mapBlockIndex.Get(blockId)) != nullptr)
+        {
+            if (chainActive[pindex->GetHeight()] != pindex) {
+                // the block being asked for is a part of a deactivated chain;
+                // we don't want to depend on its perceived height in the block
+                // chain, we want to instead use the last common ancestor
+                pindex = chainActive.FindFork(pindex);
+            }
+        }
 
-    for (const auto& pairWtx : pwallet->mapWallet) {
-        CWalletTx tx = pairWtx.second;
+        depth = pindex ? (1 + chainActive.Height() - pindex->GetHeight()) : -1;
 
-        if (depth == -1 || tx.GetDepthInMainChain() < depth) {
-            ListTransactions(pwallet, tx, "*", 0, true, transactions, filter);
-        }
+        CBlockIndex *pblockLast =
+            chainActive[chainActive.Height() + 1 - target_confirms];
+        lastblock = pblockLast ? pblockLast->GetBlockHash() : uint256();
     }
 
-    CBlockIndex *pblockLast =
-        chainActive[chainActive.Height() + 1 - target_confirms];
-    uint256 lastblock = pblockLast ? pblockLast->GetBlockHash() : uint256();
+    StreamWalletRPCReply(request, *httpReq, processedInBatch,
+        [&](CJSONWriter &jWriter) {
+            jWriter.writeBeginObject();
+            jWriter.writeBeginArray("transactions");
 
-    UniValue ret(UniValue::VOBJ);
-    ret.push_back(Pair("transactions", transactions));
-    ret.push_back(Pair("lastblock", lastblock.GetHex()));
+            // Wallet transactions are visited in batches and written out after
+            // the locks are released.
+            std::optional<uint256> lastVisited;
+            bool more = true;
+            while (more) {
+                UniValue transactions(UniValue::VARR);
+                {
+                    LOCK2(cs_main, pwallet->cs_wallet);
+                    auto it = lastVisited
+                                  ? pwallet->mapWallet.upper_bound(*lastVisited)
+                                  : pwallet->mapWallet.begin();
+                    for (size_t visited = 0;
+                         it != pwallet->mapWallet.end() &&
+                         visited < WALLET_RPC_ENTRIES_PER_LOCK;
+                         ++it, ++visited) {
+                        lastVisited = it->first;
+                        const CWalletTx &tx = it->second;
+
+                        if (depth == -1 || tx.GetDepthInMainChain() < depth) {
+                            ListTransactions(pwallet, tx, "*", 0, true,
+                                             transactions, filter);
+                        }
+                    }
+                    more = (it != pwallet->mapWallet.end());
+                }
+                WriteArrayElements(jWriter, transactions.getValues());
+            }
 
-    return ret;
+            jWriter.writeEndArray();
+            jWriter.pushKV("lastblock", lastblock.GetHex());
+            jWriter.writeEndObject();
+        });
 }
 
 static UniValue gettransaction(const Config &config,
@@ -3057,11 +3241,13 @@ static UniValue resendwallettransactions(const Config &config,
     return result;
 }
 
-static UniValue listunspent(const Config &config,
-                            const JSONRPCRequest &request) {
+static void listunspent(const Config &config,
+                        const JSONRPCRequest &request,
+                        HTTPRequest *httpReq,
+                        bool processedInBatch) {
     CWallet *const pwallet = GetWalletForJSONRPCRequest(request);
     if (!EnsureWalletIsAvailable(pwallet, request.fHelp)) {
-        return NullUniValue;
+        return;
     }
 
     if (request.fHelp || request.params.size() > 4) {
@@ -3133,6 +3319,10 @@ static UniValue listunspent(const Config &config,
                            "\"1LtvqCaApEdUGFkpKMM4MstjcaL4dKg8SP\"]"));
     }
 
+    if (httpReq == nullptr) {
+        return;
+    }
+
     int nMinDepth = 1;
     if (request.params.size() > 0 && !request.params[0].isNull()) {
         RPCTypeCheckArgument(request.params[0], UniValue::VNUM);
@@ -3173,60 +3363,110 @@ static UniValue listunspent(const Config &config,
         include_unsafe = request.params[3].get_bool();
     }
 
-    UniValue results(UniValue::VARR);
-    std::vector<COutput> vecOutputs;
+    // Unspent outputs are copied out of the wallet so that they can be
+    // rendered in batches without holding cs_wallet for the whole call.
+    struct UnspentOutput {
+        TxId txid;
+        int i;
+        CTxOut txout;
+        int nDepth;
+        bool fSpendable;
+        bool fSolvable;
+        bool fSafe;
+    };
+    std::vector<UnspentOutput> unspentOutputs;
     assert(pwallet != nullptr);
-    LOCK2(cs_main, pwallet->cs_wallet);
-    pwallet->AvailableCoins(vecOutputs, !include_unsafe, nullptr, true);
-    for (const COutput &out : vecOutputs) {
-        if (out.nDepth < nMinDepth || out.nDepth > nMaxDepth) {
-            continue;
-        }
+    {
+        std::vector<COutput> vecOutputs;
+        LOCK2(cs_main, pwallet->cs_wallet);
+        pwallet->AvailableCoins(vecOutputs, !include_unsafe, nullptr, true);
+        for (const COutput &out : vecOutputs) {
+            if (out.nDepth < nMinDepth || out.nDepth > nMaxDepth) {
+                continue;
+            }
 
-        CTxDestination address;
-        const CScript &scriptPubKey = out.tx->tx->vout[out.i].scriptPubKey;
-        bool fValidAddress = CWallet::ExtractDestination(scriptPubKey, address);
+            CTxDestination address;
+            const CScript &scriptPubKey = out.tx->tx->vout[out.i].scriptPubKey;
+            bool fValidAddress =
+                CWallet::ExtractDestination(scriptPubKey, address);
 
-        if (destinations.size() &&
-            (!fValidAddress || !destinations.count(address))) {
-            continue;
-        }
+            if (destinations.size() &&
+                (!fValidAddress || !destinations.count(address))) {
+                continue;
+            }
 
-        UniValue entry(UniValue::VOBJ);
-        entry.push_back(Pair("txid", out.tx->GetId().GetHex()));
-        entry.push_back(Pair("vout", out.i));
+            unspentOutputs.push_back({out.tx->GetId(), out.i,
+                                      out.tx->tx->vout[out.i], out.nDepth,
+                                      out.fSpendable, out.fSolvable,
+                                      out.fSafe});
+        }
+    }
 
-        if (fValidAddress) {
-            entry.push_back(Pair("address", EncodeDestination(address)));
+    StreamWalletRPCReply(request, *httpReq, processedInBatch,
+        [&](CJSONWriter &jWriter) {
+            jWriter.writeBeginArray();
 
-            if (pwallet->mapAddressBook.count(address)) {
-                entry.push_back(
-                    Pair("account", pwallet->mapAddressBook[address].name));
-            }
+            for (size_t first = 0; first < unspentOutputs.size();
+                 first += WALLET_RPC_ENTRIES_PER_LOCK) {
+                const size_t last = std::min(
+                    first + WALLET_RPC_ENTRIES_PER_LOCK, unspentOutputs.size());
 
-            if (IsP2SH(scriptPubKey)) {
-                const CScriptID &hash = boost::get<CScriptID>(address);
-                CScript redeemScript;
-                if (pwallet->GetCScript(hash, redeemScript)) {
-                    entry.push_back(
-                        Pair("redeemScript",
-                             HexStr(redeemScript.begin(), redeemScript.end())));
+                std::vector<UniValue> batch;
+                {
+                    LOCK(pwallet->cs_wallet);
+                    for (size_t idx = first; idx < last; ++idx) {
+                        const UnspentOutput &out = unspentOutputs[idx];
+
+                        CTxDestination address;
+                        const CScript &scriptPubKey = out.txout.scriptPubKey;
+                        bool fValidAddress =
+                            CWallet::ExtractDestination(scriptPubKey, address);
+
+                        UniValue entry(UniValue::VOBJ);
+                        entry.push_back(Pair("txid", out.txid.GetHex()));
+                        entry.push_back(Pair("vout", out.i));
+
+                        if (fValidAddress) {
+                            entry.push_back(
+                                Pair("address", EncodeDestination(address)));
+
+                            auto book = pwallet->mapAddressBook.find(address);
+                            if (book != pwallet->mapAddressBook.end()) {
+                                entry.push_back(
+                                    Pair("account", book->second.name));
+                            }
+
+                            if (IsP2SH(scriptPubKey)) {
+                                const CScriptID &hash =
+                                    boost::get<CScriptID>(address);
+                                CScript redeemScript;
+                                if (pwallet->GetCScript(hash, redeemScript)) {
+                                    entry.push_back(
+                                        Pair("redeemScript",
+                                             HexStr(redeemScript.begin(),
+                                                    redeemScript.end())));
+                                }
+                            }
+                        }
+
+                        entry.push_back(
+                            Pair("scriptPubKey",
+                                 HexStr(scriptPubKey.begin(),
+                                        scriptPubKey.end())));
+                        entry.push_back(
+                            Pair("amount", ValueFromAmount(out.txout.nValue)));
+                        entry.push_back(Pair("confirmations", out.nDepth));
+                        entry.push_back(Pair("spendable", out.fSpendable));
+                        entry.push_back(Pair("solvable", out.fSolvable));
+                        entry.push_back(Pair("safe", out.fSafe));
+                        batch.push_back(std::move(entry));
+                    }
                 }
+                WriteArrayElements(jWriter, batch);
             }
-        }
-
-        entry.push_back(Pair("scriptPubKey",
-                             HexStr(scriptPubKey.begin(), scriptPubKey.end())));
-        entry.push_back(
-            Pair("amount", ValueFromAmount(out.tx->tx->vout[out.i].nValue)));
-        entry.push_back(Pair("confirmations", out.nDepth));
-        entry.push_back(Pair("spendable", out.fSpendable));
-        entry.push_back(Pair("solvable", out.fSolvable));
-        entry.push_back(Pair("safe", out.fSafe));
-        results.push_back(entry);
-    }
 
-    return results;
+            jWriter.writeEndArray();
+        });
 }
 
 static UniValue fundrawtransaction(const Config &config,
@@ -38,33 +38,91 @@ static bool zmq_send_message(void* socket, const void* data, const size_t size,
     return true;
 }
 
+/* Same as zmq_send_message() but hands the payload to ZMQ without copying it.
+ * ZMQ keeps its own reference to the payload until the message is sent.
+ */
+static bool zmq_send_payload(void* socket, const CZMQPublisher::Payload& payload, bool lastMessage)
+{
+    auto* reference = new CZMQPublisher::Payload{payload};
+    auto release = [](void* /*data*/, void* hint)
+    {
+        delete static_cast<CZMQPublisher::Payload*>(hint);
+    };
+
+    zmq_msg_t msg;
+    // NOLINTNEXTLINE(cppcoreguidelines-pro-type-const-cast)
+    int rc = zmq_msg_init_data(&msg, const_cast<uint8_t*>(payload->data()), payload->size(), release, reference);
+    if (rc != 0)
+    {
+        zmqError("Unable to initialize ZMQ msg");
+        delete reference;
+        return false;
+    }
+
+    rc = zmq_msg_send(&msg, socket, lastMessage ? 0 : ZMQ_SNDMORE);
+    if (rc == -1)
+    {
+        zmqError("Unable to send ZMQ msg");
+        zmq_msg_close(&msg);
+        return false;
+    }
+    zmq_msg_close(&msg);
+    return true;
+}
+
 size_t CZMQPublisher::ZMQMessage::MemoryUsage() const
 {
-    // sizeof(CZMQPublisher) consists of sizes of all members. data and topic can allocate on the heap, so we need to add their sizes
-    return sizeof(CZMQPublisher) + memusage::DynamicUsage(data) + topic.capacity();
+    // sizeof(ZMQMessage) consists of sizes of all members. data and topic can allocate on the heap, so we need to add their sizes
+    return sizeof(ZMQMessage) + memusage::DynamicUsage(*data) + topic.capacity();
+}
+
+std::optional<CZMQPublisher::QueuePolicy> CZMQPublisher::ParseQueuePolicy(const std::string& policy)
+{
+    if (policy == "block")
+    {
+        return QueuePolicy::BLOCK;
+    }
+    if (policy == "drop")
+    {
+        return QueuePolicy::DROP;
+    }
+    if (policy == "coalesce")
+    {
+        return QueuePolicy::COALESCE;
+    }
+    return std::nullopt;
+}
+
+std::string CZMQPublisher::QueuePolicyToString(QueuePolicy policy)
+{
+    switch (policy)
+    {
+        case QueuePolicy::BLOCK:
+            return "block";
+        case QueuePolicy::DROP:
+            return "drop";
+        case QueuePolicy::COALESCE:
+            return "coalesce";
+    }
+    return "unknown";
 }
 
 CZMQPublisher::CZMQPublisher()
-    :ZMQQueue(4*ONE_GIGABYTE, [](const ZMQMessage& message){ return message.MemoryUsage(); })
 {
     auto threadFunction = [this]()
     {
         while(true)
         {
-            auto message = ZMQQueue.PopWait();
-            
+            auto message = PopMessage();
+
             if(!message.has_value())
             {
-                if(!ZMQQueue.IsClosed())
-                {
-                    LogPrintf("Could not get a zmq message from the thread safe queue!\n");
-                }
                 break;
             }
 
             if(!message->socketPointer)
             {
-                LogPrintf("Socket pointer in thread safe queue is null\n");
+                LogPrintf("Socket pointer in zmq publisher queue is null\n");
                 continue;
             }
 
@@ -81,10 +139,13 @@ CZMQPublisher::CZMQPublisher()
 
 CZMQPublisher::~CZMQPublisher()
 {
-    if(!ZMQQueue.IsClosed())
     {
-        ZMQQueue.Close(true);
+        std::lock_guard lock{mMtx};
+        mClosed = true;
+        mQueue.clear();
     }
+    mPushed.notify_all();
+    mPopped.notify_all();
 
     if(zmqThread.joinable())
     {
@@ -92,23 +153,132 @@ CZMQPublisher::~CZMQPublisher()
     }
 }
 
-bool CZMQPublisher::SendZMQMessage(void* psocket, const char* command, const void* data, size_t size, uint32_t nSequence)
+void CZMQPublisher::SetTopicLimits(const std::string& topic, const TopicLimits& limits)
+{
+    std::lock_guard lock{mMtx};
+    GetTopicQueueNL(topic).limits = limits;
+    // A bigger budget may unblock waiting publishers
+    mPopped.notify_all();
+}
+
+std::map<std::string, CZMQPublisher::TopicStats> CZMQPublisher::GetTopicStats() const
 {
-    if (ZMQQueue.IsClosed())
+    std::lock_guard lock{mMtx};
+    std::map<std::string, TopicStats> stats;
+    for (const auto& [topic, topicQueue] : mTopics)
+    {
+        stats.emplace(
+            topic,
+            TopicStats{
+                topicQueue.limits,
+                topicQueue.queuedMessages,
+                topicQueue.queuedBytes,
+                topicQueue.sentMessages,
+                topicQueue.droppedMessages});
+    }
+    return stats;
+}
+
+CZMQPublisher::TopicQueue& CZMQPublisher::GetTopicQueueNL(const std::string& topic)
+{
+    return mTopics[topic];
+}
+
+void CZMQPublisher::CoalesceNL(TopicQueue& topicQueue, const std::string& topic, size_t size)
+{
+    for (auto it = mQueue.begin(); it != mQueue.end() && !topicQueue.HasRoomFor(size);)
+    {
+        if (it->topic != topic)
+        {
+            ++it;
+            continue;
+        }
+
+        topicQueue.queuedBytes -= it->MemoryUsage();
+        --topicQueue.queuedMessages;
+        ++topicQueue.droppedMessages;
+        it = mQueue.erase(it);
+    }
+}
+
+bool CZMQPublisher::PushMessage(ZMQMessage&& message)
+{
+    const size_t size = message.MemoryUsage();
+
+    std::unique_lock lock{mMtx};
+    if (mClosed)
     {
         return false;
     }
 
+    TopicQueue& topicQueue = GetTopicQueueNL(message.topic);
+    if (!topicQueue.HasRoomFor(size))
+    {
+        switch (topicQueue.limits.policy)
+        {
+            case QueuePolicy::BLOCK:
+                mPopped.wait(lock, [&]{ return mClosed || topicQueue.HasRoomFor(size); });
+                if (mClosed)
+                {
+                    return false;
+                }
+                break;
+            case QueuePolicy::DROP:
+                // Subscribers detect dropped messages by a gap in sequence numbers.
+                ++topicQueue.droppedMessages;
+                return true;
+            case QueuePolicy::COALESCE:
+                CoalesceNL(topicQueue, message.topic, size);
+                break;
+        }
+    }
+
+    topicQueue.queuedBytes += size;
+    ++topicQueue.queuedMessages;
+    mQueue.push_back(std::move(message));
+    mPushed.notify_one();
+
+    return true;
+}
+
+std::optional<CZMQPublisher::ZMQMessage> CZMQPublisher::PopMessage()
+{
+    std::unique_lock lock{mMtx};
+    mPushed.wait(lock, [this]{ return mClosed || !mQueue.empty(); });
+    if (mClosed)
+    {
+        return std::nullopt;
+    }
+
+    ZMQMessage message = std::move(mQueue.front());
+    mQueue.pop_front();
+
+    TopicQueue& topicQueue = GetTopicQueueNL(message.topic);
+    topicQueue.queuedBytes -= message.MemoryUsage();
+    --topicQueue.queuedMessages;
+    ++topicQueue.sentMessages;
+    mPopped.notify_all();
+
+    return message;
+}
+
+bool CZMQPublisher::SendZMQMessage(void* psocket, const char* command, const void* data, size_t size, uint32_t nSequence)
+{
+    const auto* bytes = static_cast<const uint8_t*>(data);
+    // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+    return SendZMQMessage(psocket, command, std::make_shared<const std::vector<uint8_t>>(bytes, bytes + size), nSequence);
+}
+
+bool CZMQPublisher::SendZMQMessage(void* psocket, const char* command, Payload data, uint32_t nSequence)
+{
     if (!psocket)
     {
         return false;
     }
 
-    ZMQMessage message{psocket, command, data, size, nSequence};
-
-    if(!ZMQQueue.PushWait(std::move(message)))
+    if(!PushMessage(ZMQMessage{psocket, command, std::move(data), nSequence}))
     {
-        LogPrintf("Pushing message to the thread safe queue failed.\n");
+        LogPrintf("Pushing message to the zmq publisher queue failed.\n");
         return false;
     }
 
@@ -119,7 +289,7 @@ void CZMQPublisher::SendMultipart(const ZMQMessage& message) const
 {
     // Send the command, data and the sequence number
     if (zmq_send_message(message.socketPointer, message.topic.c_str(), message.topic.length(), false) &&
-        zmq_send_message(message.socketPointer, message.data.data(), message.data.size(), false))
+        zmq_send_payload(message.socketPointer, message.data, false))
     {
         // Calculate and send LE 4byte sequence number
         std::vector<uint8_t> msgSequence(sizeof(uint32_t));
@@ -2,57 +2,124 @@
 // Distributed under the Open BSV software license, see the accompanying file LICENSE.
 
 #pragma once
+#include "consensus/consensus.h"
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <memory>
 #include <mutex>
+#include <optional>
+#include <string>
 #include <thread>
 #include <vector>
-#include <string>
-#include <cstddef>
-#include "thread_safe_queue.h"
 
 class CZMQPublisher
 {
 public:
 
+    /** What to do with a new message when the queue of its topic is full. */
+    enum class QueuePolicy
+    {
+        // Wait until the publisher thread makes room (backpressure).
+        BLOCK,
+        // Drop the new message.
+        DROP,
+        // Drop the oldest queued messages of the topic to make room for the new one.
+        COALESCE
+    };
+
+    // Default amount of memory messages of a single topic can take in the queue, in megabytes.
+    static constexpr uint64_t DEFAULT_TOPIC_QUEUE_SIZE = 1024;
+    static constexpr QueuePolicy DEFAULT_TOPIC_QUEUE_POLICY = QueuePolicy::BLOCK;
+
+    struct TopicLimits
+    {
+        size_t maxQueuedBytes;
+        QueuePolicy policy;
+    };
+
+    struct TopicStats
+    {
+        TopicLimits limits;
+        size_t queuedMessages;
+        size_t queuedBytes;
+        uint64_t sentMessages;
+        uint64_t droppedMessages;
+    };
+
+    // Serialised message body shared between the queue and ZMQ until it is sent
+    using Payload = std::shared_ptr<const std::vector<uint8_t>>;
+
     CZMQPublisher(CZMQPublisher const &) = delete;
     CZMQPublisher & operator= (CZMQPublisher const &) = delete;
     CZMQPublisher(CZMQPublisher &&) = delete;
     CZMQPublisher & operator= (CZMQPublisher &&) = delete;
-    
+
     CZMQPublisher();
     ~CZMQPublisher();
+
+    // Set limits for a topic. Topics without explicitly set limits use defaults.
+    void SetTopicLimits(const std::string& topic, const TopicLimits& limits);
+    std::map<std::string, TopicStats> GetTopicStats() const;
+
     bool SendZMQMessage(void* psocket, const char* command, const void* data, size_t size, uint32_t nSequence);
+    // Queues the payload without copying it
+    bool SendZMQMessage(void* psocket, const char* command, Payload data, uint32_t nSequence);
+
+    static std::optional<QueuePolicy> ParseQueuePolicy(const std::string& policy);
+    static std::string QueuePolicyToString(QueuePolicy policy);
 
 private:
 
-    // Objects of type ZMQMessage are created for pushing into the thread safe queue
+    // Objects of type ZMQMessage are created for pushing into the queue
     // Every object contains pointer to ZMQ socket and ZMQ message consisting of three parts
     // topic, data, sequence number
     struct ZMQMessage
     {
         void* socketPointer;
         std::string topic;
-        std::vector<std::byte> data;
+        Payload data;
         uint32_t nSequence;
 
-        ZMQMessage(void* socketPointer, const std::string& topic,  const void* data, size_t size, uint32_t nSequence) : 
-            socketPointer(socketPointer),
-            topic(topic),
-            // NOLINTBEGIN(cppcoreguidelines-pro-type-reinterpret-cast)
-            // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-pointer-arithmetic)
-            data(std::vector<std::byte>(reinterpret_cast<const std::byte*>(data), reinterpret_cast<const std::byte*>(data) + size)),
-            // NOLINTEND(cppcoreguidelines-pro-type-reinterpret-cast)
-            nSequence(nSequence)
-        {}
-
-        // We need this function for thread safe queue, because sizes of ZMQMessages are not constant
+        // Sizes of ZMQMessages are not constant so queue budgets are based on this
         size_t MemoryUsage() const;
     };
 
-    // Queue for messages that should be sent to ZMQ by worker thread
-    CThreadSafeQueue<ZMQMessage> ZMQQueue;
+    struct TopicQueue
+    {
+        TopicLimits limits {DEFAULT_TOPIC_QUEUE_SIZE * ONE_MEGABYTE, DEFAULT_TOPIC_QUEUE_POLICY};
+        size_t queuedMessages {0};
+        size_t queuedBytes {0};
+        uint64_t sentMessages {0};
+        uint64_t droppedMessages {0};
+
+        // A message that is bigger than the whole budget is still accepted
+        // into an empty queue, otherwise it could never be sent.
+        bool HasRoomFor(size_t size) const
+        {
+            return queuedBytes == 0 || queuedBytes + size <= limits.maxQueuedBytes;
+        }
+    };
+
+    TopicQueue& GetTopicQueueNL(const std::string& topic);
+    // Drops the oldest queued messages of the topic until the message fits.
+    void CoalesceNL(TopicQueue& topicQueue, const std::string& topic, size_t size);
+    bool PushMessage(ZMQMessage&& message);
+    std::optional<ZMQMessage> PopMessage();
+
     // Helper function used to send message in three parts; the command, data and the LE 4byte sequence number
     void SendMultipart(const ZMQMessage& message) const;
 
+    // Queue for messages that should be sent to ZMQ by worker thread, and per topic accounting
+    mutable std::mutex mMtx;
+    std::condition_variable mPushed;
+    std::condition_variable mPopped;
+    std::deque<ZMQMessage> mQueue;
+    std::map<std::string, TopicQueue> mTopics;
+    bool mClosed {false};
+
     // worker thread which takes messages from the queue and sends it to the ZMQ
-    std::thread zmqThread; 
+    std::thread zmqThread;
 };
@@ -35,6 +35,11 @@ bool CZMQAbstractNotifier::NotifyRemovedFromMempoolBlock(const uint256& txid, Me
     return true;
 }
 
+bool CZMQAbstractNotifier::NotifyMempoolDelta(const CMempoolDelta&)
+{
+    return true;
+}
+
 bool CZMQAbstractNotifier::NotifyBlock2(const CBlockIndex*)
 {
     return true;
@@ -40,6 +40,7 @@ public:
     virtual bool NotifyRemovedFromMempool(const uint256& txid, const MemPoolRemovalReason reason,
                                           const CTransactionConflict& conflictedWith);
     virtual bool NotifyRemovedFromMempoolBlock(const uint256& txid, const MemPoolRemovalReason reason);
+    virtual bool NotifyMempoolDelta(const CMempoolDelta& delta);
 
 protected:
     void *psocket;
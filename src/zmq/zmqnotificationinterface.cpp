@@ -7,6 +7,7 @@
 #include "zmq_publisher.h"
 #include "streams.h"
 #include "util.h"
+#include "utilstrencodings.h"
 #include "validation.h"
 
 void zmqError(const char *str) {
@@ -37,6 +38,7 @@ void CZMQNotificationInterface::RegisterValidationInterface()
     slotConnections.push_back(sigs.TransactionAddedToMempool.connect(boost::bind(&CZMQNotificationInterface::TransactionAdded, this, _1)));
     slotConnections.push_back(sigs.TransactionRemovedFromMempool.connect(boost::bind(&CZMQNotificationInterface::TransactionRemovedFromMempool, this, _1, _2, _3)));
     slotConnections.push_back(sigs.TransactionRemovedFromMempoolBlock.connect(boost::bind(&CZMQNotificationInterface::TransactionRemovedFromMempoolBlock, this, _1, _2)));
+    slotConnections.push_back(sigs.MempoolDelta.connect(boost::bind(&CZMQNotificationInterface::MempoolDelta, this, _1)));
     slotConnections.push_back(sigs.BlockConnected.connect(boost::bind(&CZMQNotificationInterface::BlockConnected, this, _1, _2, _3)));
     slotConnections.push_back(sigs.BlockConnected2.connect(boost::bind(&CZMQNotificationInterface::BlockConnected2, this, _1, _2)));
     slotConnections.push_back(sigs.BlockDisconnected.connect(boost::bind(&CZMQNotificationInterface::BlockDisconnected, this, _1)));
@@ -49,6 +51,75 @@ void CZMQNotificationInterface::UnregisterValidationInterface()
     slotConnections.clear();
 }
 
+// Topic published by a notifier, e.g. "rawtx" for "pubrawtx"
+static std::string TopicOfNotifier(const CZMQAbstractNotifier& notifier)
+{
+    return notifier.GetType().substr(3);
+}
+
+// Apply -zmqtopicqueuesize and -zmqtopicqueuepolicy, given as <topic>:<value>,
+// to topics of all notifiers.
+static void ConfigureTopicQueues(CZMQPublisher& publisher,
+                                 const std::list<CZMQAbstractNotifier *>& notifiers)
+{
+    std::map<std::string, CZMQPublisher::TopicLimits> limits;
+    for (const CZMQAbstractNotifier* notifier : notifiers)
+    {
+        limits.emplace(
+            TopicOfNotifier(*notifier),
+            CZMQPublisher::TopicLimits{
+                CZMQPublisher::DEFAULT_TOPIC_QUEUE_SIZE * ONE_MEGABYTE,
+                CZMQPublisher::DEFAULT_TOPIC_QUEUE_POLICY});
+    }
+
+    auto forEachTopicValue =
+        [&limits](const std::string& arg, const auto& apply)
+        {
+            for (const std::string& setting : gArgs.GetArgs(arg))
+            {
+                const auto separator = setting.find(':');
+                const auto topic = setting.substr(0, separator);
+                const auto it = limits.find(topic);
+                if (separator == std::string::npos || it == limits.end() ||
+                    !apply(it->second, setting.substr(separator + 1)))
+                {
+                    LogPrintf("zmq: Ignoring invalid or unused %s=%s\n", arg, setting);
+                }
+            }
+        };
+
+    forEachTopicValue(
+        "-zmqtopicqueuesize",
+        [](CZMQPublisher::TopicLimits& topicLimits, const std::string& value)
+        {
+            int64_t sizeMB {0};
+            if (!ParseInt64(value, &sizeMB) || sizeMB <= 0)
+            {
+                return false;
+            }
+            topicLimits.maxQueuedBytes = static_cast<uint64_t>(sizeMB) * ONE_MEGABYTE;
+            return true;
+        });
+
+    forEachTopicValue(
+        "-zmqtopicqueuepolicy",
+        [](CZMQPublisher::TopicLimits& topicLimits, const std::string& value)
+        {
+            const auto policy = CZMQPublisher::ParseQueuePolicy(value);
+            if (!policy)
+            {
+                return false;
+            }
+            topicLimits.policy = *policy;
+            return true;
+        });
+
+    for (const auto& [topic, topicLimits] : limits)
+    {
+        publisher.SetTopicLimits(topic, topicLimits);
+    }
+}
+
 CZMQNotificationInterface *CZMQNotificationInterface::Create() {
     CZMQNotificationInterface *notificationInterface = nullptr;
     std::map<std::string, CZMQNotifierFactory> factories;
@@ -68,6 +139,8 @@ CZMQNotificationInterface *CZMQNotificationInterface::Create() {
         CZMQAbstractNotifier::Create<CZMQPublishRemovedFromMempoolNotifier>;
     factories["pubremovedfrommempoolblock"] =
         CZMQAbstractNotifier::Create<CZMQPublishRemovedFromMempoolBlockNotifier>;
+    factories["pubmempooldelta"] =
+        CZMQAbstractNotifier::Create<CZMQPublishMempoolDeltaNotifier>;
     factories["pubhashblock2"] =
         CZMQAbstractNotifier::Create<CZMQPublishHashBlockNotifier2>;
     factories["pubrawblock2"] =
@@ -94,6 +167,7 @@ CZMQNotificationInterface *CZMQNotificationInterface::Create() {
     if (!notifiers.empty()) {
         notificationInterface = new CZMQNotificationInterface();
         notificationInterface->notifiers = notifiers;
+        ConfigureTopicQueues(*notificationInterface->zmqPublisher, notifiers);
 
         if (!notificationInterface->Initialize()) {
             delete notificationInterface;
@@ -162,10 +236,19 @@ void CZMQNotificationInterface::Shutdown() {
 std::vector<ActiveZMQNotifier> CZMQNotificationInterface::ActiveZMQNotifiers()
 {
     std::vector<ActiveZMQNotifier> arrNotifiers;
+    if (!zmqPublisher)
+    {
+        return arrNotifiers;
+    }
 
+    const auto stats = zmqPublisher->GetTopicStats();
     for (auto& n : notifiers)
     {
-        arrNotifiers.push_back({n->GetType(), n->GetAddress()});
+        const auto topicStats = stats.find(TopicOfNotifier(*n));
+        if (topicStats != stats.end())
+        {
+            arrNotifiers.push_back({n->GetType(), n->GetAddress(), topicStats->second});
+        }
     }
 
     return arrNotifiers;
@@ -266,6 +349,24 @@ void CZMQNotificationInterface::TransactionRemovedFromMempoolBlock(const uint256
     }
 }
 
+void CZMQNotificationInterface::MempoolDelta(const CMempoolDelta& delta)
+{
+    for (auto i = notifiers.begin(); i != notifiers.end();)
+    {
+        CZMQAbstractNotifier *notifier = *i;
+        if (notifier->NotifyMempoolDelta(delta))
+        {
+            ++i;
+        }
+        else
+        {
+            notifier->Shutdown();
+            i = notifiers.erase(i);
+            delete notifier;
+        }
+    }
+}
+
 void CZMQNotificationInterface::TransactionAdded(const CTransactionRef& ptx)
 {
     // Used by BlockConnected2 and BlockDisconnected2 as well
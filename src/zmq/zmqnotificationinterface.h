@@ -18,6 +18,8 @@ struct ActiveZMQNotifier
 {
     std::string notifierName;
     std::string notifierAddress;
+    // State of the publisher queue for the notifier's topic
+    CZMQPublisher::TopicStats queue;
 };
 
 // NOLINTNEXTLINE(cppcoreguidelines-special-member-functions)
@@ -44,6 +46,7 @@ protected:
                                        const CTransactionConflict& conflictedWith) override;
     void TransactionRemovedFromMempoolBlock(const uint256& txid,
                                             MemPoolRemovalReason reason) override;
+    void MempoolDelta(const CMempoolDelta& delta) override;
     void
     BlockConnected(const std::shared_ptr<const CBlock> &pblock,
                    const CBlockIndex *pindexConnected,
@@ -28,6 +28,7 @@ static const char *MSG_RAWTX = "rawtx";
 */
 static const char *MSG_DISCARDEDFROMMEMPOOL = "discardedfrommempool";
 static const char *MSG_REMOVEDFROMMEMPOOLBLOCK = "removedfrommempoolblock";
+static const char* const MSG_MEMPOOLDELTA = "mempooldelta";
 
 static const char* const MSG_HASHTX2 = "hashtx2";
 static const char* const MSG_RAWTX2 = "rawtx2";
@@ -113,6 +114,16 @@ bool CZMQAbstractPublishNotifier::SendZMQMessage(const char *command,
     return true;
 }
 
+bool CZMQAbstractPublishNotifier::SendZMQMessage(const char* command, CZMQPublisher::Payload data)
+{
+    assert(psocket);
+    assert(zmqPublisher);
+
+    uint32_t sequence = nSequence++;
+
+    return zmqPublisher->SendZMQMessage(psocket, command, std::move(data), sequence);
+}
+
 bool CZMQAbstractPublishNotifier::SendZMQMessage(const char* command, const uint256& hash) 
 {
     LogPrint(BCLog::ZMQ, "zmq: Publish %s %s\n", command, hash.GetHex());
@@ -129,7 +140,7 @@ bool CZMQAbstractPublishNotifier::SendZMQMessage(const char* command, const CBlo
     LogPrint(BCLog::ZMQ, "zmq: Publish  %s %s\n", command, pindex->GetBlockHash().GetHex());
 
     const Config& config = GlobalConfig::GetConfig();
-    CDataStream ss(SER_NETWORK, PROTOCOL_VERSION | RPCSerializationFlags());
+    auto data = std::make_shared<std::vector<uint8_t>>();
     {
         LOCK(cs_main);
         CBlock block;
@@ -139,19 +150,21 @@ bool CZMQAbstractPublishNotifier::SendZMQMessage(const char* command, const CBlo
             return false;
         }
 
-        ss << block;
+        CVectorWriter{SER_NETWORK, PROTOCOL_VERSION | RPCSerializationFlags(), *data, 0, block};
     }
 
-    return SendZMQMessage(command, &(*ss.begin()), ss.size());
+    return SendZMQMessage(command, std::move(data));
 }
 
 bool CZMQAbstractPublishNotifier::SendZMQMessage(const char* command, const CTransaction& transaction) 
 {
     uint256 txid = transaction.GetId();
     LogPrint(BCLog::ZMQ, "zmq: Publish %s %s\n", command, txid.GetHex());
-    CDataStream ss(SER_NETWORK, PROTOCOL_VERSION | RPCSerializationFlags());
-    ss << transaction;
-    return SendZMQMessage(command, &(*ss.begin()), ss.size());
+    // Serialise directly into the payload which is then shared with ZMQ without further copies
+    auto data = std::make_shared<std::vector<uint8_t>>();
+    data->reserve(transaction.GetTotalSize());
+    CVectorWriter{SER_NETWORK, PROTOCOL_VERSION | RPCSerializationFlags(), *data, 0, transaction};
+    return SendZMQMessage(command, std::move(data));
 }
 
 bool CZMQPublishHashBlockNotifier::NotifyBlock(const CBlockIndex* pindex) 
@@ -252,6 +265,21 @@ bool CZMQPublishRemovedFromMempoolBlockNotifier::NotifyRemovedFromMempoolBlock(c
     return SendZMQMessage(MSG_REMOVEDFROMMEMPOOLBLOCK, message.data(), message.size());
 }
 
+bool CZMQPublishMempoolDeltaNotifier::NotifyMempoolDelta(const CMempoolDelta& delta)
+{
+    LogPrint(BCLog::ZMQ, "zmq: Publish %s %s %d\n", MSG_MEMPOOLDELTA, delta.txid.GetHex(), delta.sequence);
+
+    CDataStream ss(SER_NETWORK, PROTOCOL_VERSION);
+    ss << delta.sequence
+       << static_cast<uint8_t>(delta.type)
+       << static_cast<uint8_t>(delta.reason)
+       << delta.txid
+       << delta.fee
+       << static_cast<uint64_t>(delta.size);
+
+    return SendZMQMessage(MSG_MEMPOOLDELTA, &(*ss.begin()), ss.size());
+}
+
 bool CZMQPublishRawBlockNotifier::NotifyBlock(const CBlockIndex* pindex) 
 {
     return SendZMQMessage(MSG_RAWBLOCK, pindex);
@@ -24,6 +24,7 @@ public:
           * message sequence number
     */
     bool SendZMQMessage(const char *command, const void *data, size_t size);
+    bool SendZMQMessage(const char* command, CZMQPublisher::Payload data);
     
     bool SendZMQMessage(const char* command, const uint256& hash);
     bool SendZMQMessage(const char* command, const CBlockIndex* pindex);
@@ -56,6 +57,17 @@ public:
     bool NotifyRemovedFromMempoolBlock(const uint256& txid, const MemPoolRemovalReason reason) override;
 };
 
+/**
+ * Publishes every mempool addition and removal as a fixed size binary record
+ * (see doc/zmq.md). Records carry the mempool delta sequence so subscribers can
+ * detect missed records and resynchronise with getmempoolsnapshot.
+ */
+class CZMQPublishMempoolDeltaNotifier : public CZMQAbstractPublishNotifier
+{
+public:
+    bool NotifyMempoolDelta(const CMempoolDelta& delta) override;
+};
+
 class CZMQPublishRawBlockNotifier : public CZMQAbstractPublishNotifier {
 public:
     bool NotifyBlock(const CBlockIndex *pindex) override;
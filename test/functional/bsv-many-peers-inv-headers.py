@@ -0,0 +1,96 @@
+#!/usr/bin/env python3
+# Copyright (c) 2024 Bitcoin Association
+# Distributed under the Open BSV software license, see the accompanying file LICENSE.
+
+import random
+import threading
+import time
+
+from test_framework.mininode import msg_headers, msg_inv, CBlockHeader, CInv, FromHex, CBlock
+from test_framework.test_framework import BitcoinTestFramework
+from test_framework.util import assert_equal
+
+# Scenario:
+# Many peers flood the node with INV (transactions and known blocks) and
+# HEADERS (re-announcements of the active chain) messages while the node is
+# busy connecting new blocks. Processing of these messages must not serialise
+# against block connection (cs_main), so all peers must keep being served and
+# every peer must get a PONG after its flood.
+#
+# The test logs the measured message throughput so runs before and after a
+# change to the locking in net_processing can be compared.
+
+NUM_PEERS = 16
+NUM_ROUNDS = 20
+INVS_PER_MESSAGE = 1000
+
+
+class ManyPeersInvHeaders(BitcoinTestFramework):
+    def set_test_params(self):
+        self.num_nodes = 1
+        self.setup_clean_chain = True
+
+    def get_headers(self, node, count):
+        headers = []
+        block_hash = node.getbestblockhash()
+        for _ in range(count):
+            block = FromHex(CBlock(), node.getblock(block_hash, False))
+            block.rehash()
+            headers.insert(0, CBlockHeader(block))
+            block_hash = node.getblockheader(block_hash)["previousblockhash"]
+        return headers
+
+    def flood(self, connection, headers, block_hashes):
+        for _ in range(NUM_ROUNDS):
+            invs = [CInv(CInv.TX, random.getrandbits(256)) for _ in range(INVS_PER_MESSAGE)]
+            invs += [CInv(CInv.BLOCK, h) for h in block_hashes]
+            connection.cb.send_message(msg_inv(invs))
+            headers_message = msg_headers()
+            headers_message.headers = headers
+            connection.cb.send_message(headers_message)
+        connection.cb.sync_with_ping(timeout=240)
+
+    def run_test(self):
+        node = self.nodes[0]
+        node.generate(20)
+        headers = self.get_headers(node, 10)
+        block_hashes = [int(node.getblockhash(height), 16) for height in range(1, 11)]
+
+        self.stop_node(0)
+        with self.run_node_with_connections("flood inv and headers from many peers", 0, [], NUM_PEERS) as connections:
+            start_height = node.getblockcount()
+
+            # Keep connecting blocks while the peers are flooding the node.
+            stop_mining = threading.Event()
+
+            def mine():
+                while not stop_mining.is_set():
+                    node.generate(1)
+
+            miner = threading.Thread(target=mine)
+            start = time.time()
+            miner.start()
+
+            peers = [threading.Thread(target=self.flood, args=(connection, headers, block_hashes))
+                     for connection in connections]
+            for peer in peers:
+                peer.start()
+            for peer in peers:
+                peer.join()
+            elapsed = time.time() - start
+
+            stop_mining.set()
+            miner.join()
+
+            num_messages = NUM_PEERS * NUM_ROUNDS * 2
+            num_invs = NUM_PEERS * NUM_ROUNDS * (INVS_PER_MESSAGE + len(block_hashes))
+            self.log.info("Processed %d messages (%d inv entries) from %d peers in %.2f s: %.0f msg/s, %.0f inv/s, %d blocks connected meanwhile",
+                          num_messages, num_invs, NUM_PEERS, elapsed, num_messages / elapsed, num_invs / elapsed,
+                          node.getblockcount() - start_height)
+
+            # All peers must still be connected.
+            assert_equal(len(node.getpeerinfo()), NUM_PEERS)
+
+
+if __name__ == '__main__':
+    ManyPeersInvHeaders().main()
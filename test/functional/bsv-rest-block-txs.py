@@ -0,0 +1,155 @@
+#!/usr/bin/env python3
+# Copyright (c) 2024 Bitcoin Association
+# Distributed under the Open BSV software license, see the accompanying file LICENSE.
+"""
+Test reading parts of a block through /rest/block/<hash>/txs/<start>/<count>
+and /rest/block/<hash>/txids.
+
+- Transactions are returned exactly as they are serialised in the block.
+- The binary form of transactions supports the HTTP Range header relative to
+  the start of the first returned transaction.
+- Requested count is clamped to the number of transactions in the block.
+- With -blocktxoffsets a transaction offsets file is written for blocks with
+  enough transactions and getrawtransaction finds transactions in a given
+  block with or without it, as does getmerkleproof2 with the full transaction.
+"""
+from test_framework.blocktools import create_transaction
+from test_framework.test_framework import BitcoinTestFramework, ChainManager
+from test_framework.mininode import CBlock, msg_block, ser_uint256
+from test_framework.util import assert_equal, assert_raises_rpc_error, json
+from test_framework.script import CScript, OP_TRUE
+
+from io import BytesIO
+import http.client
+import os
+import urllib.parse
+
+
+def spend(out):
+    return create_transaction(out.tx, out.n, b"", out.tx.vout[out.n].nValue - 1000, CScript([OP_TRUE]))
+
+
+class RestBlockTxsTest(BitcoinTestFramework):
+
+    def set_test_params(self):
+        self.num_nodes = 1
+        self.setup_clean_chain = True
+        self.extra_args = [['-genesisactivationheight=1', '-rest', '-blocktxoffsets=2']]
+        self.chain = ChainManager()
+
+    def get(self, path, headers={}):
+        url = urllib.parse.urlparse(self.nodes[0].url)
+        conn = http.client.HTTPConnection(url.hostname, url.port)
+        conn.request('GET', path, headers=headers)
+        response = conn.getresponse()
+        return response, response.read()
+
+    def run_test(self):
+        self.stop_node(0)
+        with self.run_node_with_connections("test /rest/block/<hash>/txs", 0, self.extra_args[0], 1) as connections:
+            connection = connections[0]
+
+            # Create spendable outputs
+            self.chain.set_genesis_hash(int(self.nodes[0].getbestblockhash(), 16))
+            starting_blocks = 110
+            for i in range(starting_blocks):
+                block = self.chain.next_block(i)
+                self.chain.save_spendable_output()
+                connection.cb.send_message(msg_block(block))
+            out = []
+            for i in range(10):
+                out.append(self.chain.get_spendable_output())
+
+            # Block with the coinbase and 10 transactions
+            self.chain.next_block(starting_blocks)
+            block = self.chain.update_block(starting_blocks, [spend(o) for o in out])
+            connection.cb.send_message(msg_block(block))
+            self.nodes[0].waitforblockheight(starting_blocks + 1)
+            assert_equal(self.nodes[0].getbestblockhash(), block.hash)
+
+        self.start_node(0, self.extra_args[0])
+
+        # Transactions as stored by the node
+        response, data = self.get('/rest/block/' + block.hash + '.bin')
+        assert_equal(response.status, 200)
+        stored = CBlock()
+        stored.deserialize(BytesIO(data))
+        txs = stored.vtx
+        for tx in txs:
+            tx.rehash()
+        assert_equal(len(txs), 11)
+        raw = [tx.serialize() for tx in txs]
+
+        # Transaction ids
+        response, data = self.get('/rest/block/' + block.hash + '/txids.json')
+        assert_equal(response.status, 200)
+        assert_equal(json.loads(data.decode('utf-8')), [tx.hash for tx in txs])
+        response, data = self.get('/rest/block/' + block.hash + '/txids.bin')
+        assert_equal(response.status, 200)
+        assert_equal(data, b"".join(ser_uint256(tx.sha256) for tx in txs))
+        response, data = self.get('/rest/block/' + block.hash + '/txids.hex')
+        assert_equal(response.status, 200)
+        assert_equal(data.decode('utf-8').strip(), b"".join(ser_uint256(tx.sha256) for tx in txs).hex())
+
+        # Range of transactions
+        slice = b"".join(raw[2:5])
+        response, data = self.get('/rest/block/' + block.hash + '/txs/2/3.bin')
+        assert_equal(response.status, 200)
+        assert_equal(data, slice)
+        response, data = self.get('/rest/block/' + block.hash + '/txs/2/3.hex')
+        assert_equal(response.status, 200)
+        assert_equal(data.decode('utf-8').strip(), slice.hex())
+        response, data = self.get('/rest/block/' + block.hash + '/txs/0/1.json')
+        assert_equal(response.status, 200)
+        assert_equal([tx['txid'] for tx in json.loads(data.decode('utf-8'))], [txs[0].hash])
+
+        # Count is clamped to the number of transactions in the block
+        response, data = self.get('/rest/block/' + block.hash + '/txs/9/100.json')
+        assert_equal(response.status, 200)
+        assert_equal([tx['txid'] for tx in json.loads(data.decode('utf-8'))], [txs[9].hash, txs[10].hash])
+
+        # Range header is relative to the returned transactions
+        response, data = self.get('/rest/block/' + block.hash + '/txs/2/3.bin', {"Range": "bytes=10-19"})
+        assert_equal(response.status, 206)
+        assert_equal(data, slice[10:20])
+        assert_equal(response.getheader('Content-Range'), "bytes 10-19/%d" % len(slice))
+        response, data = self.get('/rest/block/' + block.hash + '/txs/2/3.bin', {"Range": "bytes=100-"})
+        assert_equal(response.status, 206)
+        assert_equal(data, slice[100:])
+        response, data = self.get('/rest/block/' + block.hash + '/txs/2/3.bin', {"Range": "bytes=-20"})
+        assert_equal(response.status, 206)
+        assert_equal(data, slice[-20:])
+        response, data = self.get('/rest/block/' + block.hash + '/txs/2/3.bin', {"Range": "bytes=%d-" % len(slice)})
+        assert_equal(response.status, 416)
+        response, data = self.get('/rest/block/' + block.hash + '/txs/2/3.bin', {"Range": "items=1-2"})
+        assert_equal(response.status, 400)
+
+        # Invalid requests
+        assert_equal(self.get('/rest/block/' + block.hash + '/txs/11/1.bin')[0].status, 400)
+        assert_equal(self.get('/rest/block/' + block.hash + '/txs/0/0.bin')[0].status, 400)
+        assert_equal(self.get('/rest/block/' + block.hash + '/txs/a/1.bin')[0].status, 400)
+        assert_equal(self.get('/rest/block/' + block.hash + '/txs/1.bin')[0].status, 400)
+        assert_equal(self.get('/rest/block/' + block.hash + '/unknown.bin')[0].status, 400)
+        assert_equal(self.get('/rest/block/' + "0" * 64 + '/txids.bin')[0].status, 404)
+        assert_equal(self.get('/rest/block/' + "0" * 64 + '/txs/0/1.bin')[0].status, 404)
+
+        # Transaction offsets file is only written for blocks with at least 2 transactions
+        txo_dir = os.path.join(self.nodes[0].datadir, 'regtest', 'blocks', 'txo00000')
+        assert os.path.exists(os.path.join(txo_dir, block.hash + '.dat'))
+        assert not os.path.exists(os.path.join(txo_dir, self.nodes[0].getblockhash(1) + '.dat'))
+
+        # Transactions of a given block, without -txindex
+        for tx in [txs[0], txs[7]]:
+            assert_equal(self.nodes[0].getrawtransaction(tx.hash, False, block.hash), tx.serialize().hex())
+            assert_equal(self.nodes[0].getrawtransaction(tx.hash, True, block.hash)['blockhash'], block.hash)
+        coinbase = self.nodes[0].getblock(self.nodes[0].getblockhash(1))['tx'][0]
+        assert_equal(self.nodes[0].getrawtransaction(coinbase, True, self.nodes[0].getblockhash(1))['txid'], coinbase)
+        assert_raises_rpc_error(-5, "No such transaction found in the provided block",
+                                self.nodes[0].getrawtransaction, coinbase, False, block.hash)
+        assert_equal(self.nodes[0].getmerkleproof2(block.hash, txs[3].hash, True)['txOrId'], txs[3].serialize().hex())
+        assert_raises_rpc_error(-5, "Block hash not found",
+                                self.nodes[0].getrawtransaction, coinbase, False, "0" * 64)
+
+
+if __name__ == '__main__':
+    RestBlockTxsTest().main()
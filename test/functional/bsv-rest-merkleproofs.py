@@ -0,0 +1,179 @@
+#!/usr/bin/env python3
+# Copyright (c) 2024 Bitcoin Association
+# Distributed under the Open BSV software license, see the accompanying file LICENSE.
+"""
+Test requesting Merkle proofs of a batch of transactions through
+/rest/merkleproofs.
+
+- JSON proofs are the same as those returned by getmerkleproof2.
+- Binary proofs are in the TSC format and match the JSON proofs.
+- Transactions from different blocks are grouped by block, the block of a
+  transaction is found in the UTXO set if no block hash is given.
+- Transactions that are not found are reported per transaction.
+"""
+from test_framework.blocktools import create_transaction
+from test_framework.test_framework import BitcoinTestFramework, ChainManager
+from test_framework.mininode import msg_block, deser_compact_size, deser_uint256, ser_uint256, CBlockHeader, CTransaction
+from test_framework.util import assert_equal, json
+from test_framework.script import CScript, OP_TRUE
+
+from io import BytesIO
+import http.client
+import urllib.parse
+
+
+def spend(out):
+    return create_transaction(out.tx, out.n, b"", out.tx.vout[out.n].nValue - 1000, CScript([OP_TRUE]))
+
+
+def parse_binary_proofs(data):
+    """Returns (txid, proof) pairs where proof is a dict with the fields of the JSON result or None"""
+    f = BytesIO(data)
+    results = []
+    while f.tell() < len(data):
+        txid = "%064x" % deser_uint256(f)
+        if deser_compact_size(f) == 0:
+            results.append((txid, None))
+            continue
+        proof = {}
+        flags = f.read(1)[0]
+        proof['index'] = deser_compact_size(f)
+        if flags & 0x01:
+            tx = CTransaction()
+            tx.deserialize(BytesIO(f.read(deser_compact_size(f))))
+            proof['txOrId'] = tx.serialize().hex()
+        else:
+            proof['txOrId'] = "%064x" % deser_uint256(f)
+        if flags & 0x02:
+            proof['targetType'] = 'header'
+            header = CBlockHeader()
+            header.deserialize(f)
+            proof['target'] = header.serialize().hex()
+        else:
+            if flags & 0x04:
+                proof['targetType'] = 'merkleroot'
+            proof['target'] = "%064x" % deser_uint256(f)
+        proof['nodes'] = []
+        for _ in range(deser_compact_size(f)):
+            node_type = f.read(1)[0]
+            proof['nodes'].append("*" if node_type == 1 else "%064x" % deser_uint256(f))
+        results.append((txid, proof))
+    return results
+
+
+class RestMerkleProofsTest(BitcoinTestFramework):
+
+    def set_test_params(self):
+        self.num_nodes = 1
+        self.setup_clean_chain = True
+        self.extra_args = [['-genesisactivationheight=1', '-rest']]
+        self.chain = ChainManager()
+
+    def post(self, path, request):
+        url = urllib.parse.urlparse(self.nodes[0].url)
+        conn = http.client.HTTPConnection(url.hostname, url.port)
+        conn.request('POST', path, request if isinstance(request, str) else json.dumps(request))
+        response = conn.getresponse()
+        return response, response.read()
+
+    def proofs_json(self, request):
+        response, data = self.post('/rest/merkleproofs.json', request)
+        assert_equal(response.status, 200)
+        assert_equal(response.getheader('Content-Type'), 'application/x-ndjson')
+        return [json.loads(line) for line in data.decode('utf-8').splitlines()]
+
+    def proofs_bin(self, request):
+        response, data = self.post('/rest/merkleproofs.bin', request)
+        assert_equal(response.status, 200)
+        return parse_binary_proofs(data)
+
+    def check_same_proofs(self, request):
+        json_proofs = self.proofs_json(request)
+        bin_proofs = self.proofs_bin(request)
+        assert_equal(len(json_proofs), len(bin_proofs))
+        for json_proof, (txid, bin_proof) in zip(json_proofs, bin_proofs):
+            assert_equal(json_proof['txid'], txid)
+            if 'error' in json_proof:
+                assert_equal(bin_proof, None)
+            else:
+                del json_proof['txid']
+                assert_equal(json_proof, bin_proof)
+        return json_proofs
+
+    def run_test(self):
+        self.stop_node(0)
+        with self.run_node_with_connections("test /rest/merkleproofs", 0, self.extra_args[0], 1) as connections:
+            connection = connections[0]
+
+            # Create spendable outputs
+            self.chain.set_genesis_hash(int(self.nodes[0].getbestblockhash(), 16))
+            starting_blocks = 110
+            for i in range(starting_blocks):
+                block = self.chain.next_block(i)
+                self.chain.save_spendable_output()
+                connection.cb.send_message(msg_block(block))
+            out = []
+            for i in range(11):
+                out.append(self.chain.get_spendable_output())
+
+            # Block with the coinbase and 11 transactions
+            self.chain.next_block(starting_blocks)
+            block = self.chain.update_block(starting_blocks, [spend(o) for o in out])
+            connection.cb.send_message(msg_block(block))
+            self.nodes[0].waitforblockheight(starting_blocks + 1)
+            assert_equal(self.nodes[0].getbestblockhash(), block.hash)
+
+        self.start_node(0, self.extra_args[0])
+
+        txids = self.nodes[0].getblock(block.hash)['tx']
+        assert_equal(len(txids), 12)
+        coinbase_block_hash = self.nodes[0].getblockhash(50)
+        coinbase_block = self.nodes[0].getblock(coinbase_block_hash)
+        spent_coinbase = self.nodes[0].getblock(self.nodes[0].getblockhash(1))['tx'][0]
+        unknown = "ab" * 32
+
+        # Proofs are the same as getmerkleproof2 returns, for all target types
+        for target_type in ["hash", "header", "merkleroot"]:
+            for include_full_tx in [False, True]:
+                request = {"txids": txids, "blockhash": block.hash,
+                           "includeFullTx": include_full_tx, "targetType": target_type}
+                proofs = self.check_same_proofs(request)
+                assert_equal(len(proofs), len(txids))
+                for txid, proof in zip(txids, proofs):
+                    assert_equal(proof['txid'], txid)
+                    del proof['txid']
+                    assert_equal(proof, self.nodes[0].getmerkleproof2(block.hash, txid, include_full_tx, target_type))
+
+        # Without block hash transactions are grouped by block in order of first appearance.
+        # A transaction in a block without other transactions is its own merkle root.
+        request = {"txids": [txids[5], coinbase_block['tx'][0], spent_coinbase, txids[2], unknown]}
+        proofs = self.check_same_proofs(request)
+        assert_equal([p['txid'] for p in proofs], [spent_coinbase, unknown, txids[5], txids[2], coinbase_block['tx'][0]])
+        assert 'error' in proofs[0]
+        assert 'error' in proofs[1]
+        assert_equal(proofs[2]['target'], block.hash)
+        assert_equal(proofs[2]['index'], 5)
+        assert_equal(proofs[3]['index'], 2)
+        assert_equal(proofs[4]['target'], coinbase_block_hash)
+        assert_equal(proofs[4]['nodes'], [])
+        assert_equal(proofs[4]['txOrId'], coinbase_block['merkleroot'])
+
+        # Transactions that are not in the given block
+        proofs = self.check_same_proofs({"txids": [txids[1], unknown, coinbase_block['tx'][0]], "blockhash": block.hash})
+        assert_equal(proofs[0]['index'], 1)
+        assert_equal(proofs[1], {"txid": unknown, "error": "Transaction not found in block"})
+        assert_equal(proofs[2], {"txid": coinbase_block['tx'][0], "error": "Transaction not found in block"})
+
+        # Invalid requests
+        assert_equal(self.post('/rest/merkleproofs.json', "[]")[0].status, 400)
+        assert_equal(self.post('/rest/merkleproofs.json', "{")[0].status, 400)
+        assert_equal(self.post('/rest/merkleproofs.json', {"txids": []})[0].status, 400)
+        assert_equal(self.post('/rest/merkleproofs.json', {"txids": ["xyz"]})[0].status, 400)
+        assert_equal(self.post('/rest/merkleproofs.json', {"txids": txids, "targetType": "block"})[0].status, 400)
+        assert_equal(self.post('/rest/merkleproofs.json', {"txids": txids, "includeFullTx": 1})[0].status, 400)
+        assert_equal(self.post('/rest/merkleproofs.json', {"txids": txids, "blockhash": "0" * 64})[0].status, 404)
+        assert_equal(self.post('/rest/merkleproofs.hex', {"txids": txids})[0].status, 404)
+
+
+if __name__ == '__main__':
+    RestMerkleProofsTest().main()
@@ -0,0 +1,118 @@
+#!/usr/bin/env python3
+# Copyright (c) 2024 Bitcoin Association
+# Distributed under the Open BSV software license, see the accompanying file LICENSE.
+"""
+Test submission of transactions through POST /rest/txs.
+
+- Transactions are sent as a sequence of CompactSize prefixed raw transactions.
+- A result is returned for every transaction in request order, either as
+  JSON lines or in binary format.
+- The endpoint is only available with -resttxsubmission.
+"""
+from test_framework.blocktools import create_transaction
+from test_framework.test_framework import BitcoinTestFramework, ChainManager
+from test_framework.mininode import msg_block, ser_compact_size, deser_string
+from test_framework.util import assert_equal, wait_until, json
+from test_framework.script import CScript, OP_TRUE
+
+from io import BytesIO
+import http.client
+import struct
+import urllib.parse
+
+
+def http_post_call(host, port, path, body):
+    conn = http.client.HTTPConnection(host, port)
+    conn.request('POST', path, body, {"Content-Type": "application/octet-stream"})
+    return conn.getresponse()
+
+
+def spend(out, feeOffset=0):
+    return create_transaction(out.tx, out.n, b"", out.tx.vout[out.n].nValue - 1000 - feeOffset, CScript([OP_TRUE]))
+
+
+def serialize_txs(txs):
+    body = b""
+    for tx in txs:
+        raw = tx.serialize()
+        body += ser_compact_size(len(raw)) + raw
+    return body
+
+
+class RestTxsTest(BitcoinTestFramework):
+
+    def set_test_params(self):
+        self.num_nodes = 1
+        self.setup_clean_chain = True
+        self.extra_args = [['-genesisactivationheight=1', '-rest', '-resttxsubmission']]
+        self.chain = ChainManager()
+
+    def post(self, path, body):
+        url = urllib.parse.urlparse(self.nodes[0].url)
+        return http_post_call(url.hostname, url.port, path, body)
+
+    def run_test(self):
+        self.stop_node(0)
+        with self.run_node_with_connections("test /rest/txs", 0, self.extra_args[0], 1) as connections:
+            connection = connections[0]
+
+            # Create spendable outputs
+            self.chain.set_genesis_hash(int(self.nodes[0].getbestblockhash(), 16))
+            starting_blocks = 105
+            for i in range(starting_blocks):
+                block = self.chain.next_block(i)
+                self.chain.save_spendable_output()
+                connection.cb.send_message(msg_block(block))
+            out = []
+            for i in range(starting_blocks):
+                out.append(self.chain.get_spendable_output())
+            self.nodes[0].waitforblockheight(starting_blocks)
+
+            # JSON lines result, one line per transaction in request order
+            # Second transaction spends an output that is already spent by the first one
+            txs = [spend(out[0]), spend(out[0], 1000), spend(out[2])]
+            response = self.post('/rest/txs.json', serialize_txs(txs))
+            assert_equal(response.status, 200)
+            results = [json.loads(line) for line in response.read().decode('utf-8').splitlines()]
+            assert_equal([r['txid'] for r in results], [tx.hash for tx in txs])
+            assert_equal(results[0]['status'], 'accepted')
+            assert_equal(results[1]['status'], 'rejected')
+            assert 'reject_reason' in results[1]
+            assert_equal(results[2]['status'], 'accepted')
+            wait_until(lambda: {txs[0].hash, txs[2].hash}.issubset(set(self.nodes[0].getrawmempool())))
+
+            # Binary result; transactions already in the mempool are reported as known
+            newTx = spend(out[3])
+            response = self.post('/rest/txs.bin', serialize_txs([txs[0], newTx]))
+            assert_equal(response.status, 200)
+            f = BytesIO(response.read())
+            statuses = []
+            for tx in [txs[0], newTx]:
+                txid = f.read(32)[::-1].hex()
+                status, rejectCode = struct.unpack("<BI", f.read(5))
+                rejectReason = deser_string(f)
+                assert_equal(txid, tx.hash)
+                assert_equal(rejectCode, 0)
+                assert_equal(rejectReason, b"")
+                statuses.append(status)
+            assert_equal(f.read(), b"")
+            # known = 1, accepted = 0
+            assert_equal(statuses, [1, 0])
+            wait_until(lambda: newTx.hash in self.nodes[0].getrawmempool())
+
+            # Malformed requests
+            raw = newTx.serialize()
+            assert_equal(self.post('/rest/txs.bin', b"").status, 400)
+            assert_equal(self.post('/rest/txs.bin', ser_compact_size(len(raw) + 1) + raw).status, 400)
+            assert_equal(self.post('/rest/txs.bin', ser_compact_size(len(raw) - 1) + raw).status, 400)
+            assert_equal(self.post('/rest/txs.hex', serialize_txs([newTx])).status, 404)
+
+        # The endpoint is not available without -resttxsubmission
+        self.start_node(0, ['-rest'])
+        newTx = spend(out[4])
+        assert_equal(self.post('/rest/txs.json', serialize_txs([newTx])).status, 404)
+        assert newTx.hash not in self.nodes[0].getrawmempool()
+
+
+if __name__ == '__main__':
+    RestTxsTest().main()
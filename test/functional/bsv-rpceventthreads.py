@@ -0,0 +1,61 @@
+#!/usr/bin/env python3
+# Copyright (c) 2024 Bitcoin Association
+# Distributed under the Open BSV software license, see the accompanying file LICENSE.
+"""
+Test serving RPC and REST requests with several HTTP event threads (-rpceventthreads).
+
+- Concurrent RPC and REST requests on many connections are all served.
+- Requests are still queued when the work queue is full (-rpcworkqueuefull=queue).
+- Shutdown is clean.
+"""
+from test_framework.test_framework import BitcoinTestFramework
+from test_framework.util import assert_equal, str_to_b64str
+
+from concurrent.futures import ThreadPoolExecutor
+import http.client
+import json
+import urllib.parse
+
+NUM_CONNECTIONS = 16
+NUM_REQUESTS = 10
+
+
+class RPCEventThreadsTest(BitcoinTestFramework):
+
+    def set_test_params(self):
+        self.num_nodes = 1
+        self.setup_clean_chain = True
+        self.extra_args = [['-rest', '-rpceventthreads=4']]
+
+    def requests(self, i):
+        # Mix of RPC and REST requests on one persistent connection
+        url = urllib.parse.urlparse(self.nodes[0].url)
+        headers = {"Authorization": "Basic " + str_to_b64str(url.username + ':' + url.password)}
+        conn = http.client.HTTPConnection(url.hostname, url.port, timeout=60)
+        results = []
+        for n in range(NUM_REQUESTS):
+            if (i + n) % 2:
+                conn.request('POST', '/', '{"method": "getblockcount"}', headers)
+                response = conn.getresponse()
+                results.append((response.status, json.loads(response.read())['result']))
+            else:
+                conn.request('GET', '/rest/chaininfo.json')
+                response = conn.getresponse()
+                results.append((response.status, json.loads(response.read())['blocks']))
+        conn.close()
+        return results
+
+    def burst(self):
+        with ThreadPoolExecutor(max_workers=NUM_CONNECTIONS) as executor:
+            results = executor.map(self.requests, range(NUM_CONNECTIONS))
+            return [r for connResults in results for r in connResults]
+
+    def run_test(self):
+        assert_equal(self.burst(), [(200, 0)] * NUM_CONNECTIONS * NUM_REQUESTS)
+
+        self.restart_node(0, self.extra_args[0] + ['-rpcthreads=1', '-rpcworkqueue=1', '-rpcworkqueuefull=queue'])
+        assert_equal(self.burst(), [(200, 0)] * NUM_CONNECTIONS * NUM_REQUESTS)
+
+
+if __name__ == '__main__':
+    RPCEventThreadsTest().main()
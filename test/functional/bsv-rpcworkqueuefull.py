@@ -0,0 +1,56 @@
+#!/usr/bin/env python3
+# Copyright (c) 2024 Bitcoin Association
+# Distributed under the Open BSV software license, see the accompanying file LICENSE.
+"""
+Test what happens to RPC calls when the HTTP work queue is full (-rpcworkqueuefull).
+
+- With the default policy (reject) calls over the -rpcworkqueue depth are
+  rejected.
+- With the queue policy all calls are queued and eventually served.
+"""
+from test_framework.test_framework import BitcoinTestFramework
+from test_framework.util import assert_equal, str_to_b64str
+
+from concurrent.futures import ThreadPoolExecutor
+import http.client
+import urllib.parse
+
+NUM_CALLS = 6
+
+
+class RPCWorkQueueFullTest(BitcoinTestFramework):
+
+    def set_test_params(self):
+        self.num_nodes = 1
+        self.setup_clean_chain = True
+
+    def slow_call(self):
+        # Each call occupies the only worker thread for a while
+        url = urllib.parse.urlparse(self.nodes[0].url)
+        headers = {"Authorization": "Basic " + str_to_b64str(url.username + ':' + url.password)}
+        conn = http.client.HTTPConnection(url.hostname, url.port, timeout=60)
+        conn.request('POST', '/', '{"method": "waitfornewblock", "params": [500]}', headers)
+        status = conn.getresponse().status
+        conn.close()
+        return status
+
+    def run_burst(self, args):
+        self.restart_node(0, ['-rpcthreads=1', '-rpcworkqueue=1'] + args)
+        with ThreadPoolExecutor(max_workers=NUM_CALLS) as executor:
+            return list(executor.map(lambda _: self.slow_call(), range(NUM_CALLS)))
+
+    def run_test(self):
+        statuses = self.run_burst([])
+        assert 500 in statuses, statuses
+
+        statuses = self.run_burst(['-rpcworkqueuefull=queue'])
+        assert_equal(statuses, [200] * NUM_CALLS)
+
+        # Invalid policy
+        self.stop_node(0)
+        self.assert_start_raises_init_error(
+            0, ['-rpcworkqueuefull=wait'], "Invalid -rpcworkqueuefull value: wait")
+
+
+if __name__ == '__main__':
+    RPCWorkQueueFullTest().main()
@@ -0,0 +1,100 @@
+#!/usr/bin/env python3
+# Copyright (c) 2024 Bitcoin Association
+# Distributed under the Open BSV software license, see the accompanying file LICENSE.
+"""
+Test the compact transaction index (-txindexbackend=compact).
+
+- An existing LevelDB transaction index is migrated when the node is started
+  with the compact backend and transactions are still found afterwards.
+- Transactions of blocks connected with the compact backend are found, also
+  after a restart.
+- Switching back to the LevelDB backend requires -reindex-chainstate.
+- Unknown backends are rejected.
+"""
+from test_framework.blocktools import create_transaction
+from test_framework.test_framework import BitcoinTestFramework, ChainManager
+from test_framework.mininode import msg_block
+from test_framework.util import assert_equal, assert_raises_rpc_error
+from test_framework.script import CScript, OP_TRUE
+
+import os
+
+
+def spend(out):
+    return create_transaction(out.tx, out.n, b"", out.tx.vout[out.n].nValue - 1000, CScript([OP_TRUE]))
+
+
+class CompactTxIndexTest(BitcoinTestFramework):
+
+    def set_test_params(self):
+        self.num_nodes = 1
+        self.setup_clean_chain = True
+        self.leveldb_args = ['-genesisactivationheight=1', '-txindex']
+        self.compact_args = self.leveldb_args + ['-txindexbackend=compact']
+        self.extra_args = [self.leveldb_args]
+        self.chain = ChainManager()
+
+    def send_block(self, args, height, outs):
+        with self.run_node_with_connections("send block", 0, args, 1) as connections:
+            self.chain.next_block(height)
+            block = self.chain.update_block(height, [spend(o) for o in outs])
+            connections[0].cb.send_message(msg_block(block))
+            self.nodes[0].waitforblockheight(height + 1)
+            assert_equal(self.nodes[0].getbestblockhash(), block.hash)
+        return block
+
+    def check_found(self, txs, block):
+        for tx in txs:
+            tx.rehash()
+            raw = self.nodes[0].getrawtransaction(tx.hash, True)
+            assert_equal(raw['hex'], tx.serialize().hex())
+            assert_equal(raw['blockhash'], block.hash)
+
+    def run_test(self):
+        self.stop_node(0)
+        with self.run_node_with_connections("create spendable outputs", 0, self.leveldb_args, 1) as connections:
+            self.chain.set_genesis_hash(int(self.nodes[0].getbestblockhash(), 16))
+            starting_blocks = 110
+            for i in range(starting_blocks):
+                block = self.chain.next_block(i)
+                self.chain.save_spendable_output()
+                connections[0].cb.send_message(msg_block(block))
+            self.nodes[0].waitforblockheight(starting_blocks)
+
+        outs = [self.chain.get_spendable_output() for _ in range(10)]
+        first = self.send_block(self.leveldb_args, starting_blocks, outs[:5])
+
+        # Coinbases of the first blocks are spent so only the index finds them
+        spent_coinbase = outs[0].tx.hash
+
+        # Migration of the LevelDB index
+        self.start_node(0, self.compact_args)
+        assert os.path.exists(os.path.join(self.nodes[0].datadir, "regtest", "blocks", "txindex", "meta.dat"))
+        self.check_found(first.vtx, first)
+        assert_equal(self.nodes[0].getrawtransaction(spent_coinbase, True)['txid'], spent_coinbase)
+        assert_raises_rpc_error(-5, "No such mempool or blockchain transaction",
+                                self.nodes[0].getrawtransaction, "ab" * 32)
+        self.stop_node(0)
+
+        # Blocks connected with the compact index
+        second = self.send_block(self.compact_args, starting_blocks + 1, outs[5:])
+        self.start_node(0, self.compact_args)
+        self.check_found(first.vtx, first)
+        self.check_found(second.vtx, second)
+        self.stop_node(0)
+
+        # LevelDB index was removed by migration
+        self.assert_start_raises_init_error(
+            0, self.leveldb_args, "You need to rebuild the database using -reindex-chainstate to change -txindexbackend")
+        self.start_node(0, self.leveldb_args + ['-reindex-chainstate'])
+        self.nodes[0].waitforblockheight(starting_blocks + 2)
+        self.check_found(first.vtx, first)
+        self.check_found(second.vtx, second)
+        self.stop_node(0)
+
+        self.assert_start_raises_init_error(
+            0, self.leveldb_args + ['-txindexbackend=sqlite'], "Unknown -txindexbackend: 'sqlite'")
+
+
+if __name__ == '__main__':
+    CompactTxIndexTest().main()